@@ -4,7 +4,9 @@
 #include "brains/examples/AggressiveMultiplier.h"
 #include "brains/examples/AggressiveMultiplier2.h"
 #include "brains/examples/Dota2Player.h"
+#include "brains/neural/NeuralBrain.h"
 
 // Register your brains here
 REGISTER_BOT_CLASS(AggressiveMultiplierBotBrain);
-REGISTER_BOT_CLASS(AggressiveMultiplierBotBrain2);
\ No newline at end of file
+REGISTER_BOT_CLASS(AggressiveMultiplierBotBrain2);
+REGISTER_BOT_CLASS(NeuralBrain);
\ No newline at end of file
@@ -10,17 +10,14 @@
 class AggressiveMultiplierBotBrain : public BotBrain
 {
 private:
-    static int population;
-    static int death;
-    static unsigned long b_id;
     void printStats() {
+        const auto& stats = context->populationStats(populationName);
         std::cout << "<" << populationName;
-        std::cout << "> |- population: " << population;
-        std::cout << " | death: " << death;
-        std::cout << " | b_id: " << b_id << " |\n";
+        std::cout << "> |- population: " << stats.population;
+        std::cout << " | death: " << stats.death;
+        std::cout << " | b_id: " << stats.born << " |\n";
     }
 public:
-    std::random_device rd;
     std::mt19937 gen;
     std::uniform_real_distribution<float> deltaAngle = std::uniform_real_distribution<float>(-0.4f, 0.4f);
     std::uniform_real_distribution<float> circleAngle = std::uniform_real_distribution<float>(-M_PI, M_PI);
@@ -45,10 +42,8 @@ public:
         responce.speedPoints = int(0.25 * data.evolutionPoints);
         responce.attackPoints = int(0.07 * data.evolutionPoints);
 
+        gen.seed(context->random()());
         angle = circleAngle(gen);
-        population++;
-        b_id++;
-        gen = std::mt19937(static_cast<std::mt19937::result_type>(rd() + b_id));
         printStats();
     }
 
@@ -123,13 +118,23 @@ public:
 
     void kill(KillProtocol& data, KillProtocolResponce& responce) override
     { // User defined brain class must have override kill function that takes 0 arguments
-        population--;
-        death++;
         printStats();
         responce.success = true;
     }
-};
 
-int AggressiveMultiplierBotBrain::population = 0;
-int AggressiveMultiplierBotBrain::death = 0;
-unsigned long AggressiveMultiplierBotBrain::b_id = 0;
\ No newline at end of file
+    void saveState(BinaryWriter& writer) const override
+    {
+        writer.write(gen);
+        writer.write(angle);
+        writer.write(focusTime);
+        writer.write(bornAmount);
+    }
+
+    void loadState(BinaryReader& reader) override
+    {
+        reader.read(gen);
+        reader.read(angle);
+        reader.read(focusTime);
+        reader.read(bornAmount);
+    }
+};
\ No newline at end of file
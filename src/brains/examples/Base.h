@@ -17,28 +17,18 @@ class YourBotClassName : public BotBrain
 {
 private:
     /*
-     * Optional variable that indicate amount
-     * of current live bots of this population in simulation
-     */
-    static int population;
-    /*
-     * Optional variable that indicate amount
-     * of death in this population during simulation
-     */
-    static int death;
-    /*
-     * Optional variable that indicate amount
-     * of spawned bots of this population during simulation
-     */
-    static unsigned long b_id;
-    /*
-     * Function that output information about population when something changed
+     * Optional function that output information about population when something changed.
+     * Simulation count alive, died and born bots of each population for you.
+     * They are stored in context, which is separate for every simulation,
+     * so please do not use static variables in brains for such counters
+     * (several simulations can run in one program).
      */
     void printStats() {
+        const auto& stats = context->populationStats(populationName);
         std::cout << "<" << populationName;
-        std::cout << "> |- population: " << population;
-        std::cout << " | death: " << death;
-        std::cout << " | b_id: " << b_id << " |\n";
+        std::cout << "> |- population: " << stats.population;
+        std::cout << " | death: " << stats.death;
+        std::cout << " | b_id: " << stats.born << " |\n";
     }
 public:
 
@@ -83,9 +73,7 @@ public:
         responce.speedPoints = int(0.25 * data.evolutionPoints);
         responce.attackPoints = int(0.07 * data.evolutionPoints);
 
-        // Optional things. Increase population and b_id counters. Output stats 
-        population++;
-        b_id++;
+        // Optional things. Output stats
         printStats();
     }
 
@@ -166,16 +154,20 @@ public:
      */
     void kill(KillProtocol& data, KillProtocolResponce& responce) override
     {
-        // Optional things. Decrease population and increase death counters. Output stats
-        population--;
-        death++;
+        // Optional things. Output stats
         printStats();
         // Set success of kill process to true
         responce.success = true;
     }
-};
 
-// Init values of static brain members
-int YourBotClassName::population = 0;
-int YourBotClassName::death = 0;
-unsigned long YourBotClassName::b_id = 0;
\ No newline at end of file
+    /*
+     * @brief Optional functions that save and restore your own fields
+     * when world is saved to snapshot and loaded back (see WorldSnapshot).
+     * loadState() is called instead of init(), so restore everything init() would set.
+     * loadState() must read exactly what saveState() wrote.
+     * This brain has no fields, so they do nothing.
+     * Example: writer.write(angle); / reader.read(angle);
+     */
+    void saveState(BinaryWriter& writer) const override {}
+    void loadState(BinaryReader& reader) override {}
+};
@@ -2,21 +2,24 @@
 
 class Dota2Player : public BotBrain {
 private:
-    inline static int highestTreeCount = 0;
-    inline static bool isHungry = false;
-
-    static int population;
-    static int death;
-    static unsigned long b_id;
-
-    inline static Vec2<float> homeBase;
-    inline static float safeDistance = 100.0f;
+    // Knowledge shared by all strategists of one simulation
+    struct SharedState {
+        int highestTreeCount = 0;
+        bool isHungry = false;
+        Vec2<float> homeBase;
+        float patrolAngle = 0.0f;
+    };
+    std::shared_ptr<SharedState> shared;
+
+    static constexpr float safeDistance = 100.0f;
+    static constexpr float patrolRadius = 500.0f;
 
     void printStats() {
+        const auto& stats = context->populationStats(populationName);
         std::cout << "<" << populationName;
-        std::cout << "> |- population: " << population;
-        std::cout << " | death: " << death;
-        std::cout << " | b_id: " << b_id << " |\n";
+        std::cout << "> |- population: " << stats.population;
+        std::cout << " | death: " << stats.death;
+        std::cout << " | b_id: " << stats.born << " |\n";
     }
 
     // Coordinate with allies in the vicinity and move towards home if needed
@@ -28,7 +31,7 @@ private:
                 allyCount++;
 
                 if (bot->isUnderAttack()) {
-                    responce.actionGoTo(homeBase);
+                    responce.actionGoTo(shared->homeBase);
                     return true;
                 }
             }
@@ -51,7 +54,7 @@ private:
     }
 
     bool gatherFood(UpdateProtocol& data, UpdateProtocolResponce& responce) {
-        if (data.visibleFood.empty() || !isHungry) {
+        if (data.visibleFood.empty() || !shared->isHungry) {
             return false;
         }
            
@@ -66,16 +69,15 @@ private:
     }
 
     void adaptivePatrol(UpdateProtocol& data, UpdateProtocolResponce& responce) {
-        static float angle = 0.0f;
-        static const float radius = 500.0f;
+        float& angle = shared->patrolAngle;
 
         angle += 0.02f;
         if (angle >= 2 * 3.14159f) {
             angle -= 2 * 3.14159f;
         }
 
-        float patrolX = homeBase.x + radius * cos(angle);
-        float patrolY = homeBase.y + radius * sin(angle);
+        float patrolX = shared->homeBase.x + patrolRadius * cos(angle);
+        float patrolY = shared->homeBase.y + patrolRadius * sin(angle);
         Vec2<float> patrolDirection(patrolX, patrolY);
 
         responce.actionGoTo(patrolDirection);
@@ -93,10 +95,10 @@ private:
             treeCount++;
         }
 
-        if (treeCount > highestTreeCount) {
+        if (treeCount > shared->highestTreeCount) {
             bestHomeBase = totalFoodPos / treeCount;
-            highestTreeCount = treeCount;
-            homeBase = bestHomeBase;
+            shared->highestTreeCount = treeCount;
+            shared->homeBase = bestHomeBase;
         }
     }
 
@@ -158,7 +160,7 @@ private:
     }
 
     bool spawnNewBot(UpdateProtocol& data, UpdateProtocolResponce& responce) {
-        float distanceToHomeBase = data.body->pos().distanceTo(homeBase);
+        float distanceToHomeBase = data.body->pos().distanceTo(shared->homeBase);
         if (data.body->food() >= data.body->maxFood() * 0.9 && distanceToHomeBase < safeDistance) {
             responce.actionSpawn(
                 std::dynamic_pointer_cast<BotBrain>(
@@ -188,17 +190,16 @@ public:
         responce.speedPoints = int(0.15 * data.evolutionPoints);
         responce.attackPoints = int(0.05 * data.evolutionPoints);
 
-        population++;
-        b_id++;
+        shared = context->populationState<SharedState>(populationName);
         printStats();
     }
 
     void update(UpdateProtocol& data, UpdateProtocolResponce& responce) override {
 
         if (data.body->food() < data.body->maxFood() * 0.5) {
-            isHungry = true;
+            shared->isHungry = true;
         } else if (data.body->food() > data.body->maxFood() * 0.9) {
-            isHungry = false;
+            shared->isHungry = false;
         }
 
         if (gatherFood(data, responce)) {
@@ -227,15 +228,20 @@ public:
     }
 
     void kill(KillProtocol& data, KillProtocolResponce& responce) override {
-        population--;
-        death++;
         printStats();
         responce.success = true;
     }
-};
 
-// Init values of static brain members
-int Dota2Player::population = 0;
-int Dota2Player::death = 0;
-unsigned long Dota2Player::b_id = 0;
-//Vec2<float> Dota2Player::homeBase(50.0f, 50.0f);  // Initial home base location
+    void saveState(BinaryWriter& writer) const override {
+        // State of population is written once, with the first bot
+        writer.writeShared(shared.get(), [&](BinaryWriter& sharedWriter) { sharedWriter.write(*shared); });
+    }
+
+    void loadState(BinaryReader& reader) override {
+        shared = context->populationState<SharedState>(populationName);
+        reader.readShared<const SharedState>([&](BinaryReader& sharedReader) {
+            sharedReader.read(*shared);
+            return shared;
+        });
+    }
+};
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include "protocols/brain/BotBrain.h"
+#include "utilities/NeuralNetwork.h"
+#include "utilities/Vec2.h"
+
+/*
+ * Built-in brain controlled by small neural network.
+ * Network is shared by all bots of population (children inherit weights of parent),
+ * so whole population is evaluated with one batched matrix multiplication per tick.
+ *
+ * Inputs are derived from BotPerception (see NeuralBrain::Input),
+ * outputs are scores of actions and movement direction (see NeuralBrain::Output).
+ */
+class NeuralBrain : public BotBrain
+{
+public:
+    enum Input
+    {
+        InputHealth,        ///< health / maxHealth
+        InputFood,          ///< food / maxFood
+        InputUnderAttack,   ///< 1 if bot was attacked on last tick
+        InputFoodX,         ///< Vector to nearest food relative to see distance
+        InputFoodY,
+        InputFoodSeen,      ///< 1 if there is food in vision
+        InputEnemyX,        ///< Vector to nearest enemy relative to see distance
+        InputEnemyY,
+        InputEnemySeen,     ///< 1 if there is enemy in vision
+        InputEnemyHealth,   ///< Health of nearest enemy relative to own max health
+        InputFriendX,       ///< Vector to nearest friend relative to see distance
+        InputFriendY,
+        InputFriendSeen,    ///< 1 if there is friend in vision
+        InputsCount
+    };
+
+    enum Output
+    {
+        OutputMove,         ///< Score of moving in OutputDirection
+        OutputEat,          ///< Score of going to/eating nearest food
+        OutputAttack,       ///< Score of going to/attacking nearest enemy
+        OutputSpawn,        ///< Score of spawning child
+        OutputDirectionX,   ///< Direction of movement
+        OutputDirectionY,
+        OutputsCount
+    };
+
+    /// @brief Weights used by population if no other weights are given.
+    /// They are read only, so can be shared between simulations
+    static std::shared_ptr<const NeuralWeights> defaultWeights()
+    {
+        static const std::shared_ptr<const NeuralWeights> weights =
+            std::make_shared<const NeuralWeights>(std::vector<int>{InputsCount, 16, 16, OutputsCount}, 2025);
+        return weights;
+    }
+
+private:
+    std::shared_ptr<const NeuralWeights> weights;
+
+    /// @brief Evaluate network for given rows of batch, which all use given weights
+    static void evaluate(UpdateBatch &batch, const std::vector<size_t> &rows, const std::shared_ptr<const NeuralWeights> &rowsWeights)
+    {
+        thread_local std::vector<float> input;
+        thread_local std::vector<float> output;
+        thread_local std::vector<float> scratch;
+
+        const int stride = NeuralWeights::paddedBatchSize(static_cast<int>(rows.size()));
+        input.assign(size_t(InputsCount) * stride, 0.0f);
+        output.resize(size_t(OutputsCount) * stride);
+
+        auto in = [&](int feature, size_t column) -> float & { return input[size_t(feature) * stride + column]; };
+
+        for (size_t column = 0; column < rows.size(); column++)
+        {
+            const BotPerception &p = batch.perceptions[rows[column]];
+            const float seeDistance = float(std::max(1, p.seeDistance));
+
+            in(InputHealth, column) = p.maxHealth > 0.0f ? p.health / p.maxHealth : 0.0f;
+            in(InputFood, column) = p.maxFood > 0.0f ? p.food / p.maxFood : 0.0f;
+            in(InputUnderAttack, column) = p.underAttack ? 1.0f : 0.0f;
+            if (p.nearestFood.exists())
+            {
+                in(InputFoodX, column) = p.nearestFood.delta.x / seeDistance;
+                in(InputFoodY, column) = p.nearestFood.delta.y / seeDistance;
+                in(InputFoodSeen, column) = 1.0f;
+            }
+            if (p.nearestEnemy.exists())
+            {
+                in(InputEnemyX, column) = p.nearestEnemy.delta.x / seeDistance;
+                in(InputEnemyY, column) = p.nearestEnemy.delta.y / seeDistance;
+                in(InputEnemySeen, column) = 1.0f;
+                in(InputEnemyHealth, column) = p.maxHealth > 0.0f ? p.nearestEnemyHealth / p.maxHealth : 0.0f;
+            }
+            if (p.nearestFriend.exists())
+            {
+                in(InputFriendX, column) = p.nearestFriend.delta.x / seeDistance;
+                in(InputFriendY, column) = p.nearestFriend.delta.y / seeDistance;
+                in(InputFriendSeen, column) = 1.0f;
+            }
+        }
+
+        rowsWeights->forwardBatch(input.data(), stride, output.data(), scratch);
+
+        for (size_t column = 0; column < rows.size(); column++)
+        {
+            const size_t row = rows[column];
+            const BotPerception &p = batch.perceptions[row];
+            UpdateProtocolResponce &responce = batch.responces[row];
+            auto out = [&](int feature) { return output[size_t(feature) * stride + column]; };
+
+            int action = OutputMove;
+            for (int o = OutputEat; o <= OutputSpawn; o++)
+            {
+                if (out(o) > out(action))
+                {
+                    action = o;
+                }
+            }
+
+            auto reachOrGoTo = [&](const BotPerception::NearestInfo &target) {
+                // Return true if target is in reach
+                if (target.distance <= float(p.radius + target.radius))
+                {
+                    return true;
+                }
+                responce.actionGoTo(p.pos + target.delta);
+                return false;
+            };
+
+            auto *brain = static_cast<NeuralBrain *>(batch.brains[row]);
+            const int evolutionPoints = brain->protocolsHolder->initProtocol.evolutionPoints;
+
+            if (action == OutputEat && p.nearestFood.exists())
+            {
+                if (reachOrGoTo(p.nearestFood))
+                {
+                    responce.actionEatByID(p.nearestFood.id);
+                }
+            }
+            else if (action == OutputAttack && p.nearestEnemy.exists())
+            {
+                if (reachOrGoTo(p.nearestEnemy))
+                {
+                    responce.actionAttackByID(false, p.nearestEnemy.id);
+                }
+            }
+            // Spawn only if stomach can pay for the child, otherwise parent would die
+            else if (action == OutputSpawn && p.food > float(evolutionPoints))
+            {
+                responce.actionSpawn(std::make_shared<NeuralBrain>(brain->weights), evolutionPoints);
+            }
+            else
+            {
+                responce.actionMove(Vec2<float>(out(OutputDirectionX), out(OutputDirectionY)), 1.0f);
+            }
+        }
+    }
+
+public:
+    NeuralBrain() : NeuralBrain(defaultWeights()) {}
+
+    /// @param weights_ Weights of network. Must have InputsCount inputs and OutputsCount outputs
+    explicit NeuralBrain(std::shared_ptr<const NeuralWeights> weights_)
+        : BotBrain("NeuralSwarm"), weights(weights_)
+    {
+        if (!weights || weights->inputSize() != InputsCount || weights->outputSize() != OutputsCount)
+        {
+            throw std::invalid_argument("NeuralBrain weights have wrong input or output size!");
+        }
+    }
+
+    std::shared_ptr<const NeuralWeights> getWeights() const { return weights; }
+
+    bool needsVisibleSets() const override { return false; }
+
+    void init(InitProtocol &data, InitProtocolResponce &responce) override
+    {
+        responce.r = 40;
+        responce.g = 200;
+        responce.b = 200;
+
+        responce.healthPoints = int(0.15 * data.evolutionPoints);
+        responce.foodPoints = int(0.3 * data.evolutionPoints);
+        responce.visionPoints = int(0.3 * data.evolutionPoints);
+        responce.speedPoints = int(0.15 * data.evolutionPoints);
+        responce.attackPoints = int(0.1 * data.evolutionPoints);
+    }
+
+    void update(UpdateProtocol &data, UpdateProtocolResponce &responce) override
+    {
+        // Used only when bot is updated alone. Evaluate batch of one bot
+        UpdateBatch batch;
+        batch.perceptions.resize(1);
+        packPerception(data, batch.perceptions[0]);
+        batch.responces.resize(1);
+        batch.brains.push_back(this);
+        updateBatch(batch);
+        responce = batch.responces[0];
+    }
+
+    void saveState(BinaryWriter &writer) const override
+    {
+        writer.writeShared(weights.get(), [&](BinaryWriter &shared)
+                           {
+            const auto &layers = weights->getLayers();
+            shared.write<uint32_t>(uint32_t(layers.size()));
+            shared.write<int32_t>(layers.front().inputs);
+            for (const auto &layer : layers)
+            {
+                shared.write<int32_t>(layer.outputs);
+            }
+            shared.writeArray(weights->parameters(), weights->parameterCount()); });
+    }
+
+    void loadState(BinaryReader &reader) override
+    {
+        weights = reader.readShared<const NeuralWeights>([](BinaryReader &shared)
+                                                         {
+            std::vector<int> layerSizes(shared.read<uint32_t>() + 1);
+            shared.readArray(layerSizes.data(), layerSizes.size());
+            auto loaded = std::make_shared<NeuralWeights>(layerSizes);
+            shared.readArray(loaded->parameters(), loaded->parameterCount());
+            return std::shared_ptr<const NeuralWeights>(loaded); });
+        if (weights->inputSize() != InputsCount || weights->outputSize() != OutputsCount)
+        {
+            throw std::runtime_error("NeuralBrain weights in snapshot have wrong input or output size!");
+        }
+    }
+
+    void updateBatch(UpdateBatch &batch) override
+    {
+        // Normally all bots of population share weights, but group rows by weights to be safe
+        thread_local std::vector<size_t> rows;
+        std::vector<const NeuralWeights *> done;
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            auto &rowWeights = static_cast<NeuralBrain *>(batch.brains[i])->weights;
+            if (std::find(done.begin(), done.end(), rowWeights.get()) != done.end())
+            {
+                continue;
+            }
+            done.push_back(rowWeights.get());
+
+            rows.clear();
+            for (size_t j = i; j < batch.size(); j++)
+            {
+                if (static_cast<NeuralBrain *>(batch.brains[j])->weights == rowWeights)
+                {
+                    rows.push_back(j);
+                }
+            }
+            evaluate(batch, rows, rowWeights);
+        }
+    }
+};
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <array>
+#include <random>
+#include <cmath>
+#include <memory>
+#include <algorithm>
+
+#include "protocols/brain/BotBrain.h"
+#include "utilities/Vec2.h"
+
+/*
+ * Brain with behavior of AggressiveMultiplier, but all hand-written
+ * constants (distribution of evolution points, thresholds) are taken
+ * from TunableBrain::Parameters. Used by headless tuner (src/tools/tuner.cpp)
+ * to search for the best parameters.
+ */
+class TunableBrain : public BotBrain
+{
+public:
+    struct Parameters
+    {
+        // Shares of evolution points. Normalized, so only ratio between them matters
+        float healthShare = 0.05f;
+        float foodShare = 0.25f;
+        float visionShare = 0.37f;
+        float speedShare = 0.25f;
+        float attackShare = 0.07f;
+
+        /// @brief Attack seen enemy only if food >= attackFoodThreshold * maxFood
+        float attackFoodThreshold = 0.6f;
+        /// @brief Spawn child only if food >= spawnFoodThreshold * maxFood and health is full
+        float spawnFoodThreshold = 0.9f;
+        /// @brief Child get evolution points of parent plus this value
+        float childExtraPoints = 5.0f;
+        /// @brief Maximum change of wandering direction per tick in radians
+        float turnRate = 0.4f;
+        /// @brief Number of extra ticks bot keep wandering direction without thinking
+        float wanderTicks = 0.0f;
+
+        static constexpr int count = 10;
+        static constexpr float maxChildExtraPoints = 20.0f;
+        static constexpr float maxTurnRate = float(M_PI);
+        static constexpr float maxWanderTicks = 10.0f;
+
+        static constexpr std::array<const char *, count> names = {
+            "healthShare", "foodShare", "visionShare", "speedShare", "attackShare",
+            "attackFoodThreshold", "spawnFoodThreshold", "childExtraPoints", "turnRate", "wanderTicks"};
+
+        /// @brief Create parameters from genome, where every gene is in range [0, 1]
+        static Parameters fromGenome(const std::array<float, count> &genome)
+        {
+            std::array<float, count> g;
+            for (int i = 0; i < count; i++)
+            {
+                g[i] = std::clamp(genome[i], 0.0f, 1.0f);
+            }
+            Parameters parameters;
+            parameters.healthShare = g[0];
+            parameters.foodShare = g[1];
+            parameters.visionShare = g[2];
+            parameters.speedShare = g[3];
+            parameters.attackShare = g[4];
+            parameters.attackFoodThreshold = g[5];
+            parameters.spawnFoodThreshold = g[6];
+            parameters.childExtraPoints = g[7] * maxChildExtraPoints;
+            parameters.turnRate = g[8] * maxTurnRate;
+            parameters.wanderTicks = g[9] * maxWanderTicks;
+            return parameters;
+        }
+
+        /// @brief Inverse of fromGenome()
+        std::array<float, count> toGenome() const
+        {
+            const float sharesSum = std::max(1e-6f, healthShare + foodShare + visionShare + speedShare + attackShare);
+            return {
+                healthShare / sharesSum, foodShare / sharesSum, visionShare / sharesSum,
+                speedShare / sharesSum, attackShare / sharesSum,
+                attackFoodThreshold, spawnFoodThreshold,
+                childExtraPoints / maxChildExtraPoints, turnRate / maxTurnRate, wanderTicks / maxWanderTicks};
+        }
+    };
+
+private:
+    std::shared_ptr<const Parameters> parameters;
+
+    // Small generator: one per bot, so it must be cheap to store and to snapshot
+    std::minstd_rand gen;
+    float angle = 0.0f;
+
+public:
+    TunableBrain() : TunableBrain(std::make_shared<const Parameters>()) {}
+
+    /// @param parameters_ Parameters shared by whole population. Children inherit them
+    explicit TunableBrain(std::shared_ptr<const Parameters> parameters_)
+        : BotBrain("TunableLegion"), parameters(parameters_)
+    {
+        if (!parameters)
+        {
+            throw std::invalid_argument("TunableBrain parameters must not be null!");
+        }
+    }
+
+    std::shared_ptr<const Parameters> getParameters() const { return parameters; }
+
+    bool needsVisibleSets() const override { return false; }
+
+    void init(InitProtocol &data, InitProtocolResponce &responce) override
+    {
+        responce.r = 230;
+        responce.g = 200;
+        responce.b = 60;
+
+        const float sharesSum = parameters->healthShare + parameters->foodShare + parameters->visionShare +
+                                parameters->speedShare + parameters->attackShare;
+        auto points = [&](float share)
+        {
+            return sharesSum > 0.0f ? int(share / sharesSum * data.evolutionPoints) : 0;
+        };
+        responce.healthPoints = points(parameters->healthShare);
+        responce.foodPoints = points(parameters->foodShare);
+        responce.visionPoints = points(parameters->visionShare);
+        responce.speedPoints = points(parameters->speedShare);
+        responce.attackPoints = points(parameters->attackShare);
+
+        // Seed from spawn position, so bots do not depend on global random state
+        gen.seed(static_cast<std::minstd_rand::result_type>(data.botSpawnPosition.x * 7919.0f + data.botSpawnPosition.y));
+        angle = std::uniform_real_distribution<float>(-M_PI, M_PI)(gen);
+    }
+
+    void update(UpdateProtocol &data, UpdateProtocolResponce &responce) override
+    {
+        if (seeEnemy() && data.body->food() >= parameters->attackFoodThreshold * data.body->maxFood())
+        {
+            if (canReach(data.nearestEnemy))
+            {
+                responce.actionAttackByID(false, data.nearestEnemy->id());
+            }
+            else
+            {
+                responce.actionGoTo(data.nearestEnemy->pos());
+            }
+            return;
+        }
+
+        if (data.body->food() >= parameters->spawnFoodThreshold * data.body->maxFood() &&
+            data.body->health() == data.body->maxHealth())
+        {
+            responce.actionSpawn(
+                std::make_shared<TunableBrain>(parameters),
+                protocolsHolder->initProtocol.evolutionPoints + int(parameters->childExtraPoints));
+            return;
+        }
+
+        if (seeFood())
+        {
+            if (canReach(data.nearestFood))
+            {
+                responce.actionEatByID(data.nearestFood->id());
+            }
+            else
+            {
+                // Walk to food without thinking, unless something dangerous happen
+                responce.actionGoTo(data.nearestFood->pos());
+                responce.persistUntilArrival().interruptOn(true, true);
+            }
+            return;
+        }
+
+        angle += std::uniform_real_distribution<float>(-parameters->turnRate, parameters->turnRate)(gen);
+        angle = std::fmod(angle + M_PI, 2 * M_PI) - M_PI;
+        responce.actionMove(Vec2<float>(std::cos(angle), std::sin(angle)), 1.0f);
+        responce.persistFor(int(parameters->wanderTicks)).interruptOn(true, true);
+    }
+
+    void kill(KillProtocol &data, KillProtocolResponce &responce) override
+    {
+        responce.success = true;
+    }
+
+    void saveState(BinaryWriter &writer) const override
+    {
+        writer.writeShared(parameters.get(), [&](BinaryWriter &shared) { shared.write(*parameters); });
+        writer.write(gen);
+        writer.write(angle);
+    }
+
+    void loadState(BinaryReader &reader) override
+    {
+        parameters = reader.readShared<const Parameters>([](BinaryReader &shared)
+                                                         { return std::make_shared<const Parameters>(shared.read<Parameters>()); });
+        reader.read(gen);
+        reader.read(angle);
+    }
+};
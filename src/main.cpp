@@ -1,10 +1,15 @@
 #include <memory>
+#include <cstdlib>
 
 #include "settings/SimulationSettings.h"
 #include "simulation.h"
 #include "objects/Tree.h"
 #include "gui/guiLoop.h"
 #include "protocols/brain/BotBrain.h"
+#include "protocols/brain/BrainPluginLoader.h"
+#include "snapshot/WorldImage.h"
+#include "snapshot/ActionLog.h"
+#include "telemetry/Telemetry.h"
 #include "BotRegister.h"
 
 int main()
@@ -23,12 +28,25 @@ int main()
     settings->mapGenerationSettings.foodPerChunk = 3.0f;
     settings->mapGenerationSettings.foodSpawnChance = 0.005f;
 
-    std::shared_ptr<Simulation> simulation = std::make_shared<Simulation>(
-        std::const_pointer_cast<const SimulationSettings>(settings)
-    );
+    // Brains built as plugins (see add_brain_plugin() in CMakeLists.txt) are loaded from ./brains
+    // or from BRAIN_PLUGINS_DIR. They can be reloaded from "Brain plugins" section of GUI
+    const char *pluginsDirectory = std::getenv("BRAIN_PLUGINS_DIR");
+    auto brainPlugins = std::make_shared<BrainPluginLoader>(pluginsDirectory ? pluginsDirectory : "brains");
+    brainPlugins->loadAll();
+    BrainsRegistry::getInstance().registerAll(brainPlugins->getRegistry());
 
-    simulation->initBotClasses();
-    simulation->generateTree();
+    // Prepared world (see WorldImage) replaces settings above and generation of map
+    const char *worldImage = std::getenv("WORLD_IMAGE");
+    std::shared_ptr<Simulation> simulation = worldImage
+        ? WorldImage::load(worldImage, BrainsRegistry::getInstance())
+        : std::make_shared<Simulation>(std::const_pointer_cast<const SimulationSettings>(settings));
+    simulation->setBrainPlugins(brainPlugins);
+
+    if (!worldImage)
+    {
+        simulation->initBotClasses();
+        simulation->generateTree();
+    }
 
     std::random_device rd;
     std::mt19937 gen;
@@ -55,6 +73,25 @@ int main()
     //     );
     // }
 
+    // Ticks of session can be replayed later without brains (see ActionReplay)
+    const char *actionLog = std::getenv("ACTION_LOG");
+    std::unique_ptr<ActionRecorder> actionRecorder = actionLog ? std::make_unique<ActionRecorder>(simulation, actionLog) : nullptr;
+
+    // Log of session is also written to file, even when Logger window is closed
+    if (const char *logFile = std::getenv("LOG_FILE"))
+    {
+        simulation->getLogger().setFileSink(logFile);
+    }
+
+    // Per tick metrics of session, written as CSV tables with given path prefix
+    std::unique_ptr<Telemetry> telemetry;
+    if (const char *telemetryPath = std::getenv("TELEMETRY"))
+    {
+        Telemetry::Options telemetryOptions;
+        telemetryOptions.path = telemetryPath;
+        telemetry = std::make_unique<Telemetry>(simulation, telemetryOptions);
+    }
+
     guiLoop(simulation);
 
     return 0;
@@ -0,0 +1,9 @@
+/*
+ * Example brain plugin. Built as brains/tunable_brain.so with optimisation
+ * of plugins, even when simulation itself is built in Debug.
+ */
+
+#include "protocols/brain/BrainPlugin.h"
+#include "brains/tunable/TunableBrain.h"
+
+BRAIN_PLUGIN(TunableBrain)
@@ -0,0 +1,20 @@
+#pragma once
+
+/// @brief All environment parameters of chunk (see Chunk). Plain values, so Simulation keeps them
+/// for every chunk in one flat array and effects pass doesn't touch chunks themselves
+struct ChunkEffects
+{
+    /// @brief Multiplier of see distance of bots in chunk
+    float seeDistanceMultiplier;
+    /// @brief Multiplier of distance bots in chunk move
+    float speedMultiplier;
+    /// @brief Multiplier of food bots in chunk burn every tick
+    float hungryMultiplier;
+    /// @brief Chance of bot in chunk to die on tick
+    float lostLifeChance;
+    /// @brief Chance of bot in chunk to find bite of food on tick
+    float findFoodChance;
+
+    /// @brief Effects have random events, otherwise they only change multipliers
+    bool hasEvents() const { return lostLifeChance > 0.0f || findFoodChance > 0.0f; }
+};
@@ -0,0 +1,95 @@
+#include "FoodField.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+#include "snapshot/BinaryStream.h"
+
+FoodField::FoodField(int chunksX_, int chunksY_)
+    : chunksX(chunksX_), chunksY(chunksY_),
+      calories(size_t(chunksX_) * chunksY_, 0.0f),
+      lastNearTick(calories.size(), 0),
+      materialised(calories.size(), 0),
+      retention(1.0f - 1.0f / foodLifetimeTicks())
+{
+}
+
+void FoodField::markNear(int xBegin, int yBegin, int xEnd, int yEnd, uint64_t tick)
+{
+    xBegin = std::max(xBegin, 0);
+    yBegin = std::max(yBegin, 0);
+    xEnd = std::min(xEnd, chunksX - 1);
+    yEnd = std::min(yEnd, chunksY - 1);
+    for (int y = yBegin; y <= yEnd; y++)
+    {
+        std::fill_n(lastNearTick.begin() + chunkIndex(xBegin, y), std::max(0, xEnd - xBegin + 1), tick);
+    }
+}
+
+void FoodField::decay()
+{
+    // Plain loop over array, compiler vectorises it
+    float *values = calories.data();
+    const size_t count = calories.size();
+    for (size_t i = 0; i < count; i++)
+    {
+        values[i] *= retention;
+    }
+}
+
+void FoodField::deposit(size_t chunk, float amount, int foodCount)
+{
+    calories[chunk] += amount;
+    stats.depositedFood += uint64_t(foodCount);
+}
+
+void FoodField::absorb(size_t chunk, float amount)
+{
+    calories[chunk] += amount;
+    stats.absorbedObjects++;
+}
+
+int FoodField::takeFood(size_t chunk)
+{
+    // The rest, less than one food object, stays and decays
+    const int count = int(calories[chunk] / foodMaxCalories);
+    calories[chunk] -= float(count) * foodMaxCalories;
+    stats.materialisedObjects += uint64_t(count);
+    return count;
+}
+
+float FoodField::getTotalCalories() const
+{
+    return std::accumulate(calories.begin(), calories.end(), 0.0f);
+}
+
+size_t FoodField::memoryBytes() const
+{
+    return calories.capacity() * sizeof(float) + lastNearTick.capacity() * sizeof(uint64_t) +
+           materialised.capacity() * sizeof(uint8_t);
+}
+
+void FoodField::save(BinaryWriter &writer) const
+{
+    writer.write<uint32_t>(uint32_t(calories.size()));
+    writer.writeArray(calories.data(), calories.size());
+    writer.writeArray(lastNearTick.data(), lastNearTick.size());
+    writer.writeArray(materialised.data(), materialised.size());
+    writer.write(stats);
+}
+
+void FoodField::load(BinaryReader &reader)
+{
+    const uint32_t chunks = reader.read<uint32_t>();
+    if (chunks != calories.size())
+    {
+        throw std::runtime_error("Food field of " + std::to_string(chunks) + " chunks can't be loaded to map of " +
+                                 std::to_string(calories.size()) + " chunks!");
+    }
+    reader.readArray(calories.data(), calories.size());
+    reader.readArray(lastNearTick.data(), lastNearTick.size());
+    reader.readArray(materialised.data(), materialised.size());
+    reader.read(stats);
+}
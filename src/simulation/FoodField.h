@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class BinaryWriter;
+class BinaryReader;
+
+/*
+ * Randomly spawned (ambient) food of chunks where no bot can see it, stored as calories per chunk
+ * instead of FoodObjects (MapGenerationSettings::foodDensityField).
+ *
+ * Every tick chunks within maxSeeDistance of some bot are marked as near. Calories of near chunk are
+ * turned into food objects (materialised), so bots perceive and eat food as before. Chunk that had no bots
+ * near for releaseTicks absorbs its ambient food objects back. Stored calories decay with rate that gives
+ * the same calories over time as lifetime of one food object (growth, maturity and decay), so field holds
+ * about as much food as objects would.
+ */
+class FoodField
+{
+public:
+    /// @brief Food spawned by Simulation::randomGenerationFood(), see Simulation::spawnAmbientFood()
+    static constexpr float foodCalories = 350.0f;
+    static constexpr float foodMaxCalories = 50.0f;
+    static constexpr float foodGrowthRate = 0.5f;
+    static constexpr float foodDecayRate = 1.0f;
+    /// @brief Ticks of maturity of every FoodObject
+    static constexpr int foodMatureTicks = 50;
+
+    /// @brief Calories of one food object summed over its life, divided by its maximum: it has maximum
+    /// from the first tick (start calories are above it) until maturity ends, then decays linearly
+    static constexpr float foodLifetimeTicks()
+    {
+        return foodMaxCalories / foodGrowthRate + foodMatureTicks + foodMaxCalories / (2.0f * foodDecayRate);
+    }
+
+    struct Stats
+    {
+        uint64_t materialisedObjects = 0;
+        uint64_t absorbedObjects = 0;
+        uint64_t depositedFood = 0;
+    };
+
+private:
+    int chunksX;
+    int chunksY;
+    /// @brief Per chunk, index y * chunksX + x
+    std::vector<float> calories;
+    std::vector<uint64_t> lastNearTick;
+    /// @brief Chunk has ambient food objects instead of calories
+    std::vector<uint8_t> materialised;
+    /// @brief Part of calories kept every tick
+    float retention;
+    Stats stats;
+
+public:
+    FoodField(int chunksX_, int chunksY_);
+
+    size_t getChunks() const { return calories.size(); }
+    size_t chunkIndex(int x, int y) const { return size_t(y) * chunksX + x; }
+
+    /// @brief Mark chunks of rectangle (inclusive, cut to map) as near bots on given tick
+    void markNear(int xBegin, int yBegin, int xEnd, int yEnd, uint64_t tick);
+    bool isNear(size_t chunk, uint64_t tick) const { return lastNearTick[chunk] == tick; }
+    uint64_t ticksSinceNear(size_t chunk, uint64_t tick) const { return tick - lastNearTick[chunk]; }
+
+    bool isMaterialised(size_t chunk) const { return materialised[chunk] != 0; }
+    void setMaterialised(size_t chunk, bool value) { materialised[chunk] = value; }
+
+    /// @brief Decay of all chunks, one tick
+    void decay();
+
+    /// @brief Add calories of food spawned in chunk
+    void deposit(size_t chunk, float amount, int foodCount);
+    /// @brief Calories of absorbed food object
+    void absorb(size_t chunk, float amount);
+    /// @brief Take calories of whole food objects out of chunk
+    /// @return Number of food objects to create
+    int takeFood(size_t chunk);
+
+    float getCalories(size_t chunk) const { return calories[chunk]; }
+    float getTotalCalories() const;
+    const Stats &getStats() const { return stats; }
+
+    size_t memoryBytes() const;
+
+    void save(BinaryWriter &writer) const;
+    /// @throw std::runtime_error if saved field has other size
+    void load(BinaryReader &reader);
+};
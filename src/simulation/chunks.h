@@ -9,6 +9,7 @@
 #include <unordered_set>
 
 #include "utilities/utilities.h"
+#include "ChunkEffects.h"
 #include "simulation.h"
 #include "objects/SimulationObject.h"
 
@@ -82,6 +83,25 @@ public:
         return (startPos <= position && position <= endPos);
     }
 
+    /// @brief All environment parameters of chunk. Applied to bots by Simulation::applyChunkEffects()
+    using Effects = ChunkEffects;
+
+    Effects getEffects() const
+    {
+        return Effects{seeDistanceMultiplier.get(), speedMultiplier.get(), hungryMultiplier.get(),
+                       lostLifeChance.get(), findFoodChance.get()};
+    }
+
+    /// @brief Set all environment parameters. Values are cut to their ranges
+    void setEffects(const Effects &effects)
+    {
+        seeDistanceMultiplier.set(effects.seeDistanceMultiplier);
+        speedMultiplier.set(effects.speedMultiplier);
+        hungryMultiplier.set(effects.hungryMultiplier);
+        lostLifeChance.set(effects.lostLifeChance);
+        findFoodChance.set(effects.findFoodChance);
+    }
+
     float getSeeDistanceMultiplier() { return seeDistanceMultiplier.get(); }
     float getSpeedMultiplier() { return speedMultiplier.get(); }
     float getHungryMultiplier() { return hungryMultiplier.get(); }
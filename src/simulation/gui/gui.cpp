@@ -1,10 +1,14 @@
 #include "gui.h"
 
+#include <algorithm>
+#include <array>
 #include <chrono>
 #include <memory>
+#include <string>
 
 #include "simulation.h"
 #include "objects/Bot.h"
+#include "protocols/brain/BrainPluginLoader.h"
 
 void createGui(std::shared_ptr<Simulation> simulation, ImGuiIO& io) {
     static auto logicTimeStart = std::chrono::high_resolution_clock::now(); 
@@ -119,6 +123,123 @@ void createGui(std::shared_ptr<Simulation> simulation, ImGuiIO& io) {
                     ImGui::PopStyleColor();
                     ImGui::Dummy(ImVec2(0.0f, 20.0f));
                     ImGui::Text("Number of objects: %i", simulation->getNumberOfObjects());
+                    const auto &botStats = simulation->getLastBotUpdateStats();
+                    ImGui::Text("Bots updated: %i", botStats.bots);
+                    ImGui::Text("Brain calls: %i (%i batches)", botStats.brainCalls, botStats.batchCalls);
+                    ImGui::Text("Persistent actions without brain: %i", botStats.intentActions);
+                    if (const auto &mergeStats = simulation->getFoodMergeStats(); mergeStats.saved() > 0) {
+                        ImGui::Text("Food merged: %llu overlapping, %llu into full cells",
+                                    static_cast<unsigned long long>(mergeStats.merged),
+                                    static_cast<unsigned long long>(mergeStats.capped));
+                    }
+                    if (const FoodField *foodField = simulation->getFoodField()) {
+                        const auto &fieldStats = foodField->getStats();
+                        ImGui::Text("Food field: %.0f calories, %llu food materialised, %llu absorbed",
+                                    foodField->getTotalCalories(),
+                                    static_cast<unsigned long long>(fieldStats.materialisedObjects),
+                                    static_cast<unsigned long long>(fieldStats.absorbedObjects));
+                    }
+
+                    // Brain profiler
+                    auto &profiler = simulation->getBrainProfiler();
+                    bool profileBrains = profiler.isEnabled();
+                    if (ImGui::Checkbox("Profile brains", &profileBrains)) {
+                        profiler.setEnabled(profileBrains);
+                    }
+                    ImGui::SameLine();
+                    if (ImGui::Button("Reset profile")) {
+                        profiler.reset();
+                    }
+                    float timeBudgetUs = profiler.getTimeBudgetUs();
+                    ImGui::SetNextItemWidth(120.0f);
+                    if (ImGui::InputFloat("Brain time budget (us per bot, 0 - none)", &timeBudgetUs, 1.0f, 10.0f, "%.1f")) {
+                        profiler.setTimeBudgetUs(timeBudgetUs);
+                    }
+                    if (profiler.getTicks() > 0 && ImGui::BeginTable("BrainProfile", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                        ImGui::TableSetupColumn("Population");
+                        for (const char *phaseName : BrainProfiler::phaseNames) {
+                            ImGui::TableSetupColumn(phaseName);
+                        }
+                        ImGui::TableSetupColumn("Share");
+                        ImGui::TableSetupColumn("Over budget");
+                        ImGui::TableHeadersRow();
+                        for (const auto &row : profiler.report()) {
+                            ImGui::TableNextRow();
+                            ImGui::TableNextColumn();
+                            ImGui::Text("%s", row.populationName.c_str());
+                            for (int phase = 0; phase < BrainProfiler::PhasesCount; phase++) {
+                                ImGui::TableNextColumn();
+                                ImGui::Text("%.2f / %.2f", row.meanUs[phase], row.p99Us[phase]);
+                            }
+                            ImGui::TableNextColumn();
+                            ImGui::Text("%.1f%%", row.tickShare * 100.0);
+                            ImGui::TableNextColumn();
+                            ImGui::Text("%lu", row.overBudget);
+                        }
+                        ImGui::EndTable();
+                        ImGui::Text("Time per bot in us (mean / p99) over %lu ticks", profiler.getTicks());
+                    }
+
+                    // Memory accounting walks all objects, so it is refreshed once per second
+                    if (ImGui::TreeNode("Memory")) {
+                        static MemoryStats memoryStats;
+                        static double memoryStatsTime = -1.0;
+                        if (memoryStatsTime < 0.0 || ImGui::GetTime() - memoryStatsTime > 1.0) {
+                            memoryStats = simulation->collectMemoryStats();
+                            memoryStatsTime = ImGui::GetTime();
+                        }
+                        ImGui::Text("Total (estimated): %s", MemoryStats::formatBytes(double(memoryStats.totalBytes())).c_str());
+                        if (ImGui::BeginTable("MemoryStats", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                            ImGui::TableSetupColumn("Category");
+                            ImGui::TableSetupColumn("Count");
+                            ImGui::TableSetupColumn("Bytes");
+                            ImGui::TableSetupColumn("Per item");
+                            ImGui::TableHeadersRow();
+                            for (int category = 0; category < MemoryStats::CategoriesCount; category++) {
+                                const auto &entry = memoryStats.entries[category];
+                                ImGui::TableNextRow();
+                                ImGui::TableNextColumn();
+                                ImGui::Text("%s", MemoryStats::categoryNames[category]);
+                                ImGui::TableNextColumn();
+                                ImGui::Text("%zu", entry.count);
+                                ImGui::TableNextColumn();
+                                ImGui::Text("%s", MemoryStats::formatBytes(double(entry.bytes)).c_str());
+                                ImGui::TableNextColumn();
+                                ImGui::Text("%s", entry.count ? MemoryStats::formatBytes(double(entry.bytes) / entry.count).c_str() : "-");
+                            }
+                            ImGui::EndTable();
+                        }
+                        if (ImGui::TreeNode("Object layout")) {
+                            for (const auto &type : Simulation::getObjectLayout()) {
+                                ImGui::Text("%-28s %6zu bytes", type.name, type.bytes);
+                            }
+                            ImGui::TreePop();
+                        }
+                        ImGui::TreePop();
+                    }
+                    ImGui::Dummy(ImVec2(0.0f, 20.0f));
+                }
+
+                if (auto brainPlugins = simulation->getBrainPlugins(); brainPlugins && ImGui::CollapsingHeader("Brain plugins")) {
+                    static int lastReloadedBots = -1;
+                    ImGui::Text("Directory: %s", brainPlugins->getDirectory().string().c_str());
+                    for (const auto &plugin : brainPlugins->getPlugins()) {
+                        ImGui::Text("%s (version %i)", plugin.path.filename().string().c_str(), plugin.version);
+                        for (const auto &populationName : plugin.populationNames) {
+                            ImGui::BulletText("%s", populationName.c_str());
+                        }
+                        if (!plugin.lastError.empty()) {
+                            ImGui::TextColored(ImVec4(0.9f, 0.2f, 0.2f, 1.0f), "%s", plugin.lastError.c_str());
+                        }
+                    }
+                    // Called between ticks, as simulation is updated above in the same frame
+                    if (ImGui::Button("Reload changed plugins")) {
+                        lastReloadedBots = simulation->reloadBrainPlugins();
+                    }
+                    if (lastReloadedBots >= 0) {
+                        ImGui::SameLine();
+                        ImGui::Text("Brains replaced: %i", lastReloadedBots);
+                    }
                     ImGui::Dummy(ImVec2(0.0f, 20.0f));
                 }
 
@@ -137,10 +258,19 @@ void createGui(std::shared_ptr<Simulation> simulation, ImGuiIO& io) {
                     }
                     else if (selectedChunk) {
                         selectedChunk->displayInfo();
+                        if (const FoodField *foodField = simulation->getFoodField()) {
+                            const size_t chunkIndex = foodField->chunkIndex(selectedChunk->xIndex, selectedChunk->yIndex);
+                            ImGui::Text("Food field calories: %.1f%s", foodField->getCalories(chunkIndex),
+                                        foodField->isMaterialised(chunkIndex) ? " (food materialised)" : "");
+                        }
                     }
                 }
                 ImGui::EndTabItem();
             }
+            if (ImGui::BeginTabItem("Profiler")) {
+                createTickProfilerGui(simulation);
+                ImGui::EndTabItem();
+            }
             ImGui::EndTabBar();
         }
         
@@ -169,6 +299,205 @@ void createGui(std::shared_ptr<Simulation> simulation, ImGuiIO& io) {
     }
 }
 
+void createTickProfilerGui(std::shared_ptr<Simulation> simulation) {
+    static const std::array<ImU32, TickProfiler::PhasesCount> phaseColors = {
+        IM_COL32(120, 200, 80, 255),  // Food generation
+        IM_COL32(80, 160, 60, 255),   // Food update
+        IM_COL32(40, 120, 40, 255),   // Tree update
+        IM_COL32(140, 140, 140, 255), // Other update
+        IM_COL32(190, 150, 90, 255),  // Environment
+        IM_COL32(80, 160, 230, 255),  // Perception
+        IM_COL32(230, 90, 90, 255),   // Brain
+        IM_COL32(240, 180, 60, 255),  // Action
+        IM_COL32(150, 70, 170, 255),  // Deaths
+        IM_COL32(230, 120, 200, 255), // Births
+        IM_COL32(60, 200, 200, 255),  // Render culling
+        IM_COL32(40, 110, 180, 255)   // Draw list
+    };
+    // Age of tick shown in flame view, -1 to follow the last one
+    static int selectedAge = -1;
+    static std::string exportStatus;
+
+    auto &profiler = simulation->getTickProfiler();
+    bool profileTicks = profiler.isEnabled();
+    if (ImGui::Checkbox("Profile ticks", &profileTicks)) {
+        profiler.setEnabled(profileTicks);
+    }
+    ImGui::SameLine();
+    int capacity = int(profiler.getCapacity());
+    ImGui::SetNextItemWidth(120.0f);
+    if (ImGui::InputInt("Ticks kept", &capacity, 10, 100, ImGuiInputTextFlags_EnterReturnsTrue)) {
+        profiler.setCapacity(std::max(1, capacity));
+        selectedAge = -1;
+    }
+    if (ImGui::Button("Export Chrome trace")) {
+        exportStatus = profiler.exportChromeTrace("tick_trace.json")
+            ? "Saved " + std::to_string(profiler.size()) + " ticks to tick_trace.json"
+            : "Can't write tick_trace.json";
+    }
+    if (!exportStatus.empty()) {
+        ImGui::SameLine();
+        ImGui::Text("%s", exportStatus.c_str());
+    }
+    bool profileCounters = profiler.areCountersEnabled();
+    if (ImGui::Checkbox("Hardware counters", &profileCounters)) {
+        profiler.setCountersEnabled(profileCounters);
+        profiler.resetCounters();
+    }
+    ImGui::SetItemTooltip("Cycles, instructions, L1D/LLC read misses and branch misses of every phase (Linux perf_event_open).\n"
+                          "Summed over all profiled ticks since enabling or reset");
+    if (profiler.countersFailed()) {
+        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.3f, 1.0f), "Counters unavailable: %s", profiler.getCounters().getError().c_str());
+    }
+
+    // Legend
+    for (int phase = 0; phase < TickProfiler::PhasesCount; phase++) {
+        ImGui::ColorButton(TickProfiler::phaseNames[phase], ImGui::ColorConvertU32ToFloat4(phaseColors[phase]),
+                           ImGuiColorEditFlags_NoTooltip, ImVec2(12.0f, 12.0f));
+        ImGui::SameLine();
+        ImGui::Text("%s", TickProfiler::phaseNames[phase]);
+        if (phase % 4 != 3 && phase + 1 < TickProfiler::PhasesCount) {
+            ImGui::SameLine();
+        }
+    }
+
+    const size_t recorded = profiler.size();
+    if (recorded == 0) {
+        ImGui::TextDisabled("No ticks recorded");
+        return;
+    }
+    if (selectedAge >= int(recorded)) {
+        selectedAge = -1;
+    }
+
+    // Timeline: one stacked bar per tick, the newest on the right
+    ImGui::SeparatorText("Timeline");
+    float maxTotalUs = 1.0f;
+    for (size_t age = 0; age < recorded; age++) {
+        maxTotalUs = std::max(maxTotalUs, profiler.tick(age).totalUs());
+    }
+    ImDrawList *draw_list = ImGui::GetWindowDrawList();
+    const ImVec2 timelinePos = ImGui::GetCursorScreenPos();
+    const ImVec2 timelineSize(ImGui::GetContentRegionAvail().x, 120.0f);
+    const float barWidth = timelineSize.x / float(profiler.getCapacity());
+    ImGui::InvisibleButton("TickTimeline", timelineSize);
+    draw_list->AddRectFilled(timelinePos, ImVec2(timelinePos.x + timelineSize.x, timelinePos.y + timelineSize.y), IM_COL32(30, 30, 30, 255));
+
+    const float mouseX = ImGui::GetIO().MousePos.x;
+    int hoveredAge = -1;
+    for (size_t age = 0; age < recorded; age++) {
+        const auto &record = profiler.tick(age);
+        const float x1 = timelinePos.x + timelineSize.x - barWidth * age;
+        const float x0 = x1 - barWidth;
+        float y = timelinePos.y + timelineSize.y;
+        for (int phase = 0; phase < TickProfiler::PhasesCount; phase++) {
+            const float height = record.phaseTotalsUs[phase] / maxTotalUs * timelineSize.y;
+            if (height > 0.0f) {
+                draw_list->AddRectFilled(ImVec2(x0, y - height), ImVec2(x1 - (barWidth > 3.0f ? 1.0f : 0.0f), y), phaseColors[phase]);
+                y -= height;
+            }
+        }
+        if (ImGui::IsItemHovered() && mouseX >= x0 && mouseX < x1) {
+            hoveredAge = int(age);
+        }
+        if (int(age) == selectedAge) {
+            draw_list->AddRect(ImVec2(x0, timelinePos.y), ImVec2(x1, timelinePos.y + timelineSize.y), IM_COL32(255, 255, 255, 255));
+        }
+    }
+    if (hoveredAge >= 0) {
+        const auto &record = profiler.tick(hoveredAge);
+        ImGui::BeginTooltip();
+        ImGui::Text("Tick %lu: %.1f us", record.index, record.totalUs());
+        for (int phase = 0; phase < TickProfiler::PhasesCount; phase++) {
+            if (record.phaseTotalsUs[phase] > 0.0f) {
+                ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(phaseColors[phase]), "%s: %.1f us",
+                                   TickProfiler::phaseNames[phase], record.phaseTotalsUs[phase]);
+            }
+        }
+        ImGui::EndTooltip();
+        if (ImGui::IsItemClicked()) {
+            selectedAge = hoveredAge;
+        }
+    }
+    ImGui::Text("Max %.1f us per tick. Click tick to inspect it", maxTotalUs);
+    ImGui::SameLine();
+    if (ImGui::SmallButton("Follow last tick")) {
+        selectedAge = -1;
+    }
+
+    // Flame view: phases of one tick at their real offsets
+    const auto &record = profiler.tick(selectedAge < 0 ? 0 : selectedAge);
+    ImGui::SeparatorText("Tick phases");
+    ImGui::Text("Tick %lu: %.1f us from start to end", record.index, record.endUs - record.startUs);
+    const ImVec2 flamePos = ImGui::GetCursorScreenPos();
+    const ImVec2 flameSize(ImGui::GetContentRegionAvail().x, 24.0f);
+    ImGui::InvisibleButton("TickFlame", flameSize);
+    draw_list->AddRectFilled(flamePos, ImVec2(flamePos.x + flameSize.x, flamePos.y + flameSize.y), IM_COL32(30, 30, 30, 255));
+    const double tickDurationUs = std::max(1.0, record.endUs - record.startUs);
+    for (const auto &event : record.events) {
+        const float x0 = flamePos.x + float((event.startUs - record.startUs) / tickDurationUs) * flameSize.x;
+        const float x1 = std::max(x0 + 1.0f, x0 + float(event.durationUs / tickDurationUs) * flameSize.x);
+        draw_list->AddRectFilled(ImVec2(x0, flamePos.y), ImVec2(x1, flamePos.y + flameSize.y), phaseColors[event.phase]);
+        if (ImGui::IsItemHovered() && mouseX >= x0 && mouseX < x1) {
+            ImGui::SetTooltip("%s: %.1f us at +%.1f us", TickProfiler::phaseNames[event.phase],
+                              event.durationUs, event.startUs - record.startUs);
+        }
+    }
+    if (ImGui::BeginTable("TickPhases", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("Time (us)");
+        ImGui::TableHeadersRow();
+        for (int phase = 0; phase < TickProfiler::PhasesCount; phase++) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(phaseColors[phase]), "%s", TickProfiler::phaseNames[phase]);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", record.phaseTotalsUs[phase]);
+        }
+        ImGui::EndTable();
+    }
+
+    if (!profiler.getCounters().isAvailable()) {
+        return;
+    }
+    ImGui::SeparatorText("Hardware counters");
+    if (ImGui::SmallButton("Reset counters")) {
+        profiler.resetCounters();
+    }
+    const auto &counters = profiler.getCounters();
+    if (ImGui::BeginTable("PhaseCounters", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Phase");
+        ImGui::TableSetupColumn("Objects / tick");
+        ImGui::TableSetupColumn("IPC");
+        ImGui::TableSetupColumn("L1D miss / obj");
+        ImGui::TableSetupColumn("LLC miss / obj");
+        ImGui::TableSetupColumn("Branch miss / obj");
+        ImGui::TableHeadersRow();
+        for (int phase = 0; phase < TickProfiler::PhasesCount; phase++) {
+            const auto &aggregate = profiler.getPhaseCounters(TickProfiler::Phase(phase));
+            if (aggregate.samples == 0) {
+                continue;
+            }
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(phaseColors[phase]), "%s", TickProfiler::phaseNames[phase]);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", double(aggregate.items) / aggregate.samples);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", aggregate.ipc());
+            for (PerfCounters::Counter counter : {PerfCounters::L1DMisses, PerfCounters::LLCMisses, PerfCounters::BranchMisses}) {
+                ImGui::TableNextColumn();
+                if (counters.has(counter) && aggregate.items) {
+                    ImGui::Text("%.2f", aggregate.perItem(counter));
+                } else {
+                    ImGui::TextDisabled("-");
+                }
+            }
+        }
+        ImGui::EndTable();
+    }
+}
+
 void createObjectListGui(std::shared_ptr<Simulation> simulation) {
     bool objectSelected = false;
     unsigned long selectedID = 0;
@@ -219,6 +548,10 @@ void createObjectListGui(std::shared_ptr<Simulation> simulation) {
                 ImGui::Text("ID: 0123456789");
                 ImGui::EndTabItem();
             }
+            if (ImGui::BeginTabItem("Profiler")) {
+                createTickProfilerGui(simulation);
+                ImGui::EndTabItem();
+            }
             ImGui::EndTabBar();
         }
         ImGui::EndChild();
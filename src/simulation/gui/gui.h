@@ -8,6 +8,9 @@
 /// @brief Create gui of simulation to draw on frame
 void createGui(std::shared_ptr<Simulation> simulation, ImGuiIO& io);
 
+/// @brief Create timeline of tick phases recorded by TickProfiler
+void createTickProfilerGui(std::shared_ptr<Simulation> simulation);
+
 /// @brief Create simulation objects list for preview and managment
 void createObjectListGui(std::shared_ptr<Simulation> simulation);
 
@@ -12,6 +12,7 @@
 #include "protocols/shadows/ShadowBotObject.h"
 #include "protocols/ProtocolsHolder.h"
 #include "protocols/brain/BotBrain.h"
+#include "snapshot/ActionCodec.h"
 
 BotObject::BotObject(std::shared_ptr<Simulation> simulation,
             Vec2<int> position,
@@ -40,18 +41,42 @@ BotObject::BotObject(std::shared_ptr<Simulation> simulation,
     {
     // This sh*t dosnt work :(
     protocolsHolder->updateProtocol.body = shadow;
+    // Chunk effects are taken on the next tick, until then bot has neutral ones
+    environment.seeDistance = simulation ? std::min(see_distance, simulation->maxSeeDistance) : see_distance;
     }
 
 void BotObject::update()
 {
-    food.decrease(0.1);
+    prepareUpdate();
+    if (hasActiveIntent())
+    {
+        finishPerception();
+        performIntent();
+    }
+    else
+    {
+        packProtocol();
+        finishPerception();
+        brain->protocolsHolder->updateProtocolResponce.persistArgs = UpdateProtocolResponce::PersistInfo();
+        brain->update(brain->protocolsHolder->updateProtocol, brain->protocolsHolder->updateProtocolResponce);
+        parseProtocolResponce(protocolsHolder->updateProtocolResponce);
+    }
+    finishUpdate();
+}
+
+void BotObject::prepareUpdate()
+{
+    // Hunger changes every bot on every tick
+    markDirty();
+    food.decrease(0.1 * environment.hungryMultiplier);
     if (food.get() == 0)
     {
         health.decrease(0.5);
     }
-    packProtocol();
-    brain->update(brain->protocolsHolder->updateProtocol, brain->protocolsHolder->updateProtocolResponce);
-    parseProtocolResponce();
+}
+
+void BotObject::finishUpdate()
+{
     if (health.get() == 0)
     {
         markForDeletion();
@@ -61,7 +86,10 @@ void BotObject::update()
         health.increase(0.1);
         food.decrease(0.2);
     }
+}
 
+void BotObject::finishPerception()
+{
     underAttack = false;
 }
 
@@ -78,45 +106,108 @@ void BotObject::update()
 //     Suicide        ///< Self-destruct
 // };
 
-void BotObject::parseProtocolResponce() {
-    switch (static_cast<int>(protocolsHolder->updateProtocolResponce.actionType))
+bool BotObject::hasActiveIntent()
+{
+    if (!intent.active)
+    {
+        return false;
+    }
+    const auto &persist = intent.responce.persistArgs;
+    const auto &target = intent.responce.goToArgs.targetPosition;
+    if (intent.ticksLeft <= 0 ||
+        (persist.interruptOnAttack && underAttack) ||
+        (persist.untilArrival && pos.sqrDistanceTo(target) <= float(getRadius() * getRadius())) ||
+        (persist.untilFull && food.get() >= food.getMax()) ||
+        (persist.interruptOnEnemy && seesEnemy()))
+    {
+        intent.active = false;
+    }
+    return intent.active;
+}
+
+void BotObject::performIntent()
+{
+    intent.ticksLeft--;
+    if (!performAction(intent.responce) && intent.responce.persistArgs.untilFull)
+    {
+        // Nothing left to eat
+        intent.active = false;
+    }
+}
+
+bool BotObject::seesEnemy()
+{
+    const int radius = getSeeDistance();
+    const float sqrSeeDistance = float(radius * radius);
+    auto chunksInVision = getChunksInRadius(pos, radius);
+    for (const auto &chunk : chunksInVision)
+    {
+        for (const auto &chunkObject : chunk->objects)
+        {
+            if (auto validChunkObject = chunkObject.lock())
+            {
+                if (validChunkObject->type() == SimulationObjectType::BotObject &&
+                    pos.sqrDistanceTo(validChunkObject->pos) < sqrSeeDistance &&
+                    std::static_pointer_cast<BotObject>(validChunkObject)->brain->populationName != brain->populationName)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+void BotObject::parseProtocolResponce(const UpdateProtocolResponce &responce) {
+    performAction(responce);
+
+    // Remember action as intent if brain asked to repeat it
+    intent.active = responce.persistArgs.ticks > 0 &&
+                    responce.actionType != BotAction::Spawn &&
+                    responce.actionType != BotAction::Suicide;
+    if (intent.active) {
+        intent.responce = responce;
+        intent.ticksLeft = responce.persistArgs.ticks;
+    }
+}
+
+bool BotObject::performAction(const UpdateProtocolResponce &responce) {
+    switch (static_cast<int>(responce.actionType))
     {
     case BotAction::DoNothing:
         break;
     case BotAction::Move:
         actionMove(
-            protocolsHolder->updateProtocolResponce.moveArgs.direction,
-            protocolsHolder->updateProtocolResponce.moveArgs.speedMultiplier
+            responce.moveArgs.direction,
+            responce.moveArgs.speedMultiplier
             );
         break;
     case BotAction::GoTo:
         actionGoTo(
-            protocolsHolder->updateProtocolResponce.goToArgs.targetPosition
+            responce.goToArgs.targetPosition
             );
         break;
     case BotAction::EatNearest:
-        actionEat();
-        break;
+        return actionEat();
     case BotAction::EatByID:
-        actionEat(
-            protocolsHolder->updateProtocolResponce.eatByIDArgs.objectID
+        return actionEat(
+            responce.eatByIDArgs.objectID
             );
-        break;
     case BotAction::AttackNearest:
         actionAttack(
-            protocolsHolder->updateProtocolResponce.attackNearestArgs.attackOwnKind
+            responce.attackNearestArgs.attackOwnKind
         );
         break;
     case BotAction::AttackByID:
         actionAttack(
-            protocolsHolder->updateProtocolResponce.attackByIDArgs.attackOwnKind,
-            protocolsHolder->updateProtocolResponce.attackByIDArgs.targetID
+            responce.attackByIDArgs.attackOwnKind,
+            responce.attackByIDArgs.targetID
             );
         break;
     case BotAction::Spawn:
         actionSpawnBot(
-            protocolsHolder->updateProtocolResponce.spawnArgs.brain,
-            protocolsHolder->updateProtocolResponce.spawnArgs.evolutionPoints
+            responce.spawnArgs.brain,
+            responce.spawnArgs.evolutionPoints
         );
         break;
     
@@ -128,6 +219,7 @@ void BotObject::parseProtocolResponce() {
         throw std::invalid_argument("Invalid action type!");
         break;
     }
+    return true;
 }
 
 void BotObject::actionMove(Vec2<float> direction, float speedMultyplier)
@@ -135,6 +227,9 @@ void BotObject::actionMove(Vec2<float> direction, float speedMultyplier)
     direction = direction.normalize();
     speedMultyplier = std::clamp<float>(speedMultyplier, 0.0f, 1.0f);
     food.decrease(0.1 * speedMultyplier);
+    // Cost is the same, ground of chunk makes distance shorter or longer
+    speedMultyplier *= environment.speedMultiplier;
+    markDirty();
     if (auto validSimulation = simulation.lock())
     {
         pos = Vec2<float>(
@@ -204,10 +299,11 @@ void BotObject::actionAttack(bool attackOwnKind, unsigned long targetID)
                 {
                     if (targetID == ULONG_MAX)
                     {
-                        // Find nearest if targetID wasnt specified
+                        // Find nearest if targetID wasnt specified. Order of objects in chunk
+                        // depends on their addresses, so equally near ones are chosen by id
                         if (validObj->id.get() != id.get() &&
                             validObj->type() == SimulationObjectType::BotObject &&
-                            pos.sqrDistanceTo(validObj->pos) < minDistance)
+                            isNearer(*validObj, minDistance, nearestBot.get()))
                         {
                             auto nearestBotUnchecked = std::static_pointer_cast<BotObject>(validObj);
                             if (attackOwnKind || nearestBotUnchecked->brain->populationName != brain->populationName) {
@@ -255,9 +351,18 @@ void BotObject::rawAttack(std::shared_ptr<BotObject> targetBot)
     targetBot->health.decrease(damage);
     food.decrease(0.4);
     targetBot->underAttack = true;
+    targetBot->markDirty();
+    markDirty();
+}
+
+bool BotObject::isNearer(const SimulationObject &candidate, float minDistance, const SimulationObject *nearest) const
+{
+    const float distance = pos.sqrDistanceTo(candidate.pos);
+    return distance < minDistance ||
+           (nearest && distance == minDistance && candidate.id.get() < nearest->id.get());
 }
 
-void BotObject::actionEat(unsigned long targetID)
+bool BotObject::actionEat(unsigned long targetID)
 {
     // When each users program will have own type id, add logic for attackOwnKind
     std::queue<std::shared_ptr<Chunk>> chunksToCheck;
@@ -300,7 +405,7 @@ void BotObject::actionEat(unsigned long targetID)
                         // Find nearest if targetID wasnt specified
                         if (validObj->id.get() != id.get() &&
                             validObj->type() == SimulationObjectType::FoodObject &&
-                            pos.sqrDistanceTo(validObj->pos) < minDistance)
+                            isNearer(*validObj, minDistance, nearestFood.get()))
                         {
                             minDistance = pos.sqrDistanceTo(validObj->pos);
                             nearestFood = validObj;
@@ -329,7 +434,9 @@ void BotObject::actionEat(unsigned long targetID)
         if (nearestFood && minDistance <= (getRadius() + nearestFood->getRadius()) * (getRadius() + nearestFood->getRadius()))
         {
             rawEat(std::static_pointer_cast<FoodObject>(nearestFood));
+            return true;
         }
+        return false;
     }
     else
     {
@@ -343,6 +450,26 @@ void BotObject::rawEat(std::shared_ptr<FoodObject> targetFood)
     food.decrease(0.1);
     float eatenCalories = targetFood->decreaseCalories(std::max(5.0f, food.getMax() / 20));
     food.increase(eatenCalories);
+    markDirty();
+}
+
+void BotObject::setEnvironment(const Chunk::Effects &effects, int maxSeeDistance)
+{
+    environment.seeDistance = std::min(static_cast<int>(see_distance * effects.seeDistanceMultiplier), maxSeeDistance);
+    environment.speedMultiplier = effects.speedMultiplier;
+    environment.hungryMultiplier = effects.hungryMultiplier;
+}
+
+void BotObject::loseLife()
+{
+    health.set(health.getMin());
+    markDirty();
+}
+
+void BotObject::findFood()
+{
+    food.increase(std::max(5.0f, food.getMax() / 20));
+    markDirty();
 }
 
 void BotObject::actionSpawnBot(std::shared_ptr<BotBrain> brain, int evolutionPoints) {
@@ -353,6 +480,7 @@ void BotObject::actionSpawnBot(std::shared_ptr<BotBrain> brain, int evolutionPoi
         float minusHealth = std::max(0.0f, evolutionPoints - food.get());
         food.decrease(evolutionPoints);
         health.decrease(minusHealth);
+        markDirty();
         // If you try to spawn bot with evolution points more than mother can produce,
         // it will kill mother bot and wont create child bot
         if (health.get() > 0) {
@@ -379,21 +507,99 @@ void BotObject::onDestroy()
     {
         float calories = health.getMax() * 0.3 + food.get() * 0.7;
         // validSimulation->addObject(SimulationObjectType::FoodObject, validSimulation, pos, colorInt(100, 0, 0), calories, calories, 0, 5.0f, true);
-        validSimulation->addObject(SimulationObjectType::FoodObject,
-                                   std::make_shared<FoodObject>(
-                                       validSimulation,
-                                       pos,
-                                       colorInt(100, 0, 0),
-                                       calories,
-                                       calories,
-                                       0,
-                                       5.0f,
-                                       true));
+        validSimulation->addFood(std::make_shared<FoodObject>(
+                                     validSimulation,
+                                     pos,
+                                     colorInt(100, 0, 0),
+                                     calories,
+                                     calories,
+                                     0,
+                                     5.0f,
+                                     true));
+    }
+    if (brain->context)
+    {
+        auto &populationStats = brain->context->populationStats(brain->populationName);
+        populationStats.population--;
+        populationStats.death++;
     }
     brain->kill(brain->protocolsHolder->killProtocol, brain->protocolsHolder->killProtocolResponce);
 }
 
-void BotObject::packProtocol()
+void BotObject::accountMemory(MemoryStats &stats) const
+{
+    stats.add(MemoryStats::BotObjects, MemoryStats::sharedObjectBytes<BotObject>());
+    stats.add(MemoryStats::BotShadows, MemoryStats::sharedObjectBytes<ShadowBotObject>() +
+                                           MemoryStats::stringBytes(shadow->_populationName));
+    accountBaseShadow(stats);
+
+    const auto &updateProtocol = protocolsHolder->updateProtocol;
+    stats.add(MemoryStats::ProtocolBuffers, MemoryStats::sharedObjectBytes<ProtocolsHolder>() +
+                                                MemoryStats::stringBytes(updateProtocol.lastActionMessage) +
+                                                MemoryStats::hashSetBytes(updateProtocol.visibleObjects) +
+                                                MemoryStats::hashSetBytes(updateProtocol.visibleFood) +
+                                                MemoryStats::hashSetBytes(updateProtocol.visibleTree) +
+                                                MemoryStats::hashSetBytes(updateProtocol.visibleBots) +
+                                                MemoryStats::hashSetBytes(updateProtocol.visibleFriends) +
+                                                MemoryStats::hashSetBytes(updateProtocol.visibleEnemies));
+}
+
+void BotObject::saveState(BinaryWriter &writer) const
+{
+    SimulationObject::saveState(writer);
+    writer.write<float>(health.get());
+    writer.write<float>(health.getMax());
+    writer.write<float>(food.get());
+    writer.write<float>(food.getMax());
+    writer.write<int32_t>(see_distance);
+    writer.write<float>(speed);
+    writer.write<float>(damage);
+    writer.write<uint8_t>(underAttack);
+    writer.write<uint8_t>(intent.active);
+    if (intent.active)
+    {
+        writer.write<int32_t>(intent.ticksLeft);
+        writeResponce(writer, intent.responce);
+    }
+}
+
+void BotObject::loadState(BinaryReader &reader)
+{
+    SimulationObject::loadState(reader);
+    const float healthValue = reader.read<float>();
+    health = RangeValue<float>(healthValue, 0.0f, reader.read<float>());
+    const float foodValue = reader.read<float>();
+    food = RangeValue<float>(foodValue, 0.0f, reader.read<float>());
+    see_distance = reader.read<int32_t>();
+    environment = Environment();
+    if (auto validSimulation = simulation.lock())
+    {
+        environment.seeDistance = std::min(see_distance, validSimulation->maxSeeDistance);
+    }
+    speed = reader.read<float>();
+    damage = reader.read<float>();
+    underAttack = reader.read<uint8_t>() != 0;
+    intent.active = reader.read<uint8_t>() != 0;
+    if (intent.active)
+    {
+        intent.ticksLeft = reader.read<int32_t>();
+        intent.responce = readResponce(reader);
+    }
+
+    shadow->_pos = pos;
+    shadow->_radius = getRadius();
+    shadow->_health = health.get();
+    shadow->_maxHealth = health.getMax();
+    shadow->_food = food.get();
+    shadow->_maxFood = food.getMax();
+    // Chunk multiplier is applied on the next packProtocol()
+    shadow->_seeDistance = see_distance;
+    shadow->_speed = speed;
+    shadow->_damage = damage;
+    shadow->_underAttack = underAttack;
+}
+
+void BotObject::packProtocol(bool packVisibleSets)
 {
     // Pack shadow object
     shadow->_health = health.get();
@@ -417,6 +623,7 @@ void BotObject::packProtocol()
     protocolsHolder->updateProtocol.visibleObjects.clear();
     protocolsHolder->updateProtocol.visibleFood.clear();
     protocolsHolder->updateProtocol.visibleTree.clear();
+    protocolsHolder->updateProtocol.visibleBots.clear();
     protocolsHolder->updateProtocol.visibleFriends.clear();
     protocolsHolder->updateProtocol.visibleEnemies.clear();
 
@@ -437,6 +644,12 @@ void BotObject::packProtocol()
     std::shared_ptr<const ShadowFoodObject> foodObj;
     std::shared_ptr<const ShadowTreeObject> treeObj;
     std::shared_ptr<const ShadowBotObject> botObj;
+    // Objects chosen as nearest so far. Chunk sets are in address order, so equally near objects are
+    // compared by id (see isNearer()), otherwise the same seed could give different perception
+    const SimulationObject *nearestFood = nullptr;
+    const SimulationObject *nearestTree = nullptr;
+    const SimulationObject *nearestFriend = nullptr;
+    const SimulationObject *nearestEnemy = nullptr;
 
     for (const auto &chunk : chunksInVision)
     {
@@ -453,49 +666,63 @@ void BotObject::packProtocol()
                         break;
                     case SimulationObjectType::FoodObject:
                         if (protocolsHolder->updateProtocol.distanceToNearestFood == -1.0f ||
-                            sqrDistanceToObj < protocolsHolder->updateProtocol.distanceToNearestFood)
+                            isNearer(*validChunkObject, protocolsHolder->updateProtocol.distanceToNearestFood, nearestFood))
                         {
+                            nearestFood = validChunkObject.get();
                             protocolsHolder->updateProtocol.distanceToNearestFood = sqrDistanceToObj;
                             protocolsHolder->updateProtocol.nearestFood = std::dynamic_pointer_cast<FoodObject>(validChunkObject)->getShadow();
                         }
-                        foodObj = std::dynamic_pointer_cast<FoodObject>(validChunkObject)->getShadow();
-                        protocolsHolder->updateProtocol.visibleObjects.insert(foodObj);
-                        protocolsHolder->updateProtocol.visibleFood.insert(foodObj);
+                        if (packVisibleSets) {
+                            foodObj = std::dynamic_pointer_cast<FoodObject>(validChunkObject)->getShadow();
+                            protocolsHolder->updateProtocol.visibleObjects.insert(foodObj);
+                            protocolsHolder->updateProtocol.visibleFood.insert(foodObj);
+                        }
 
                         break;
                     case SimulationObjectType::TreeObject:
                         if (protocolsHolder->updateProtocol.distanceToNearestTree == -1.0f ||
-                            sqrDistanceToObj < protocolsHolder->updateProtocol.distanceToNearestTree)
+                            isNearer(*validChunkObject, protocolsHolder->updateProtocol.distanceToNearestTree, nearestTree))
                         {
+                            nearestTree = validChunkObject.get();
                             protocolsHolder->updateProtocol.distanceToNearestTree = sqrDistanceToObj;
                             protocolsHolder->updateProtocol.nearestTree = std::dynamic_pointer_cast<TreeObject>(validChunkObject)->getShadow();
                         }
-                        treeObj = std::dynamic_pointer_cast<TreeObject>(validChunkObject)->getShadow();
-                        protocolsHolder->updateProtocol.visibleObjects.insert(treeObj);
-                        protocolsHolder->updateProtocol.visibleTree.insert(treeObj);
+                        if (packVisibleSets) {
+                            treeObj = std::dynamic_pointer_cast<TreeObject>(validChunkObject)->getShadow();
+                            protocolsHolder->updateProtocol.visibleObjects.insert(treeObj);
+                            protocolsHolder->updateProtocol.visibleTree.insert(treeObj);
+                        }
                         break;
                     case SimulationObjectType::BotObject:
                         botObj = std::dynamic_pointer_cast<BotObject>(validChunkObject)->getShadow();
                         if (botObj->populationName() == protocolsHolder->updateProtocol.body->populationName()) {
                             // Bot is from the same population (Friend)
                             if (protocolsHolder->updateProtocol.distanceToNearestFriend == -1.0f ||
-                                sqrDistanceToObj < protocolsHolder->updateProtocol.distanceToNearestFriend) {
+                                isNearer(*validChunkObject, protocolsHolder->updateProtocol.distanceToNearestFriend, nearestFriend)) {
+                                    nearestFriend = validChunkObject.get();
                                     protocolsHolder->updateProtocol.distanceToNearestFriend = sqrDistanceToObj;
                                     protocolsHolder->updateProtocol.nearestFriend = botObj;
                                 }
-                            protocolsHolder->updateProtocol.visibleFriends.insert(botObj);
+                            if (packVisibleSets) {
+                                protocolsHolder->updateProtocol.visibleFriends.insert(botObj);
+                            }
                         }
                         else {
                             // Bot is from different population (Enemy)
                             if (protocolsHolder->updateProtocol.distanceToNearestEnemy == -1.0f ||
-                                sqrDistanceToObj < protocolsHolder->updateProtocol.distanceToNearestEnemy) {
+                                isNearer(*validChunkObject, protocolsHolder->updateProtocol.distanceToNearestEnemy, nearestEnemy)) {
+                                    nearestEnemy = validChunkObject.get();
                                     protocolsHolder->updateProtocol.distanceToNearestEnemy = sqrDistanceToObj;
                                     protocolsHolder->updateProtocol.nearestEnemy = botObj;
                                 }
-                            protocolsHolder->updateProtocol.visibleEnemies.insert(botObj);
+                            if (packVisibleSets) {
+                                protocolsHolder->updateProtocol.visibleEnemies.insert(botObj);
+                            }
+                        }
+                        if (packVisibleSets) {
+                            protocolsHolder->updateProtocol.visibleObjects.insert(botObj);
+                            protocolsHolder->updateProtocol.visibleBots.insert(botObj);
                         }
-                        protocolsHolder->updateProtocol.visibleObjects.insert(botObj);
-                        protocolsHolder->updateProtocol.visibleBots.insert(botObj);
                         break;
                     default:
                         throw std::runtime_error("Invalid simulation object type!");
@@ -531,11 +758,18 @@ void BotObject::packProtocol()
     }
 }
 
+void BotObject::fillPerception(BotPerception &perception) const
+{
+    packPerception(protocolsHolder->updateProtocol, perception);
+}
+
 void BotObject::setBrainObject(std::shared_ptr<BotBrain> brain_)
 {
     brain = brain_;
     protocolsHolder = brain->protocolsHolder;
     shadow->_populationName = brain->populationName;
+    // Intent was chosen by previous brain
+    intent.active = false;
 }
 
 bool BotObject::isUnderAttack() const {
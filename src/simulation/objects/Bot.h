@@ -42,6 +42,36 @@ private:
 
     std::shared_ptr<BotBrain> brain;
 
+    /// @brief Action repeated without calling brain (see UpdateProtocolResponce::persistArgs)
+    struct Intent
+    {
+        bool active = false;
+        UpdateProtocolResponce responce;
+        int ticksLeft = 0;
+    };
+    Intent intent;
+
+    /// @brief Effects of chunk of bot, set by Simulation::applyChunkEffects() at the start of every tick,
+    /// so bot doesn't look its chunk up on every use
+    struct Environment
+    {
+        int seeDistance = 0;
+        float speedMultiplier = 1.0f;
+        float hungryMultiplier = 1.0f;
+    };
+    Environment environment;
+
+    /// @brief Perform action described by given responce
+    /// @return False if action obviously failed (e.g. there was nothing to eat)
+    bool performAction(const UpdateProtocolResponce &responce);
+
+    /// @brief Check if there is any bot of other population in vision. Cheaper than packProtocol()
+    bool seesEnemy();
+
+    /// @brief Check if candidate is nearer than the nearest object found so far. Equally near objects are
+    /// compared by id, so choice doesn't depend on order of chunk objects (it differs between runs)
+    bool isNearer(const SimulationObject &candidate, float minDistance, const SimulationObject *nearest) const;
+
 public:
     bool underAttack = false;
 
@@ -76,20 +106,27 @@ public:
     /// @brief Set brain for the bot and connect their protocols holders
     void setBrainObject(std::shared_ptr<BotBrain> brain_);
 
-    /// @brief Return see distance of bot including chunk multiplier
-    int getSeeDistance() const
-    {
-        if (auto validChunk = chunk.lock())
-        {
-            if (auto validSimulation = simulation.lock())
-            {
-                return std::min(static_cast<int>(see_distance * validChunk->getSeeDistanceMultiplier()),
-                                validSimulation->maxSeeDistance);
-            }
-            throw std::runtime_error("Invalid simulation pointer of BotObject!");
-        }
-        throw std::runtime_error("Invalid chunk pointer of BotObject!");
-    }
+    std::shared_ptr<BotBrain> getBrain() const { return brain; }
+
+    float getHealth() const { return health.get(); }
+    float getFood() const { return food.get(); }
+    float getSpeed() const { return speed; }
+    float getDamage() const { return damage; }
+    /// @brief See distance of bot itself, without chunk multiplier
+    int getBaseSeeDistance() const { return see_distance; }
+
+    /// @brief Return see distance of bot including multiplier of its chunk on this tick
+    int getSeeDistance() const { return environment.seeDistance; }
+
+    /// @brief Take multipliers of given chunk effects, see distance is cut to maxSeeDistance
+    void setEnvironment(const Chunk::Effects &effects, int maxSeeDistance);
+
+    /// @brief Random event of chunk (Chunk::Effects::lostLifeChance): bot dies at the end of this tick
+    void loseLife();
+
+    /// @brief Random event of chunk (Chunk::Effects::findFoodChance): bot gets one bite of food
+    /// as if it ate food object
+    void findFood();
 
     /// @brief Get and return all chunks within a given radius of the position.
     /// @param position The position to check around.
@@ -139,7 +176,12 @@ public:
     }
 
     /// @brief Get all objects shadows within the bot's vision range.
-    void packProtocol();
+    /// @param packVisibleSets If false, only body and nearest objects are packed, visible* sets stay empty
+    void packProtocol(bool packVisibleSets = true);
+
+    /// @brief Copy values of packed UpdateProtocol to flat perception used by batched brains.
+    /// Must be called after packProtocol()
+    void fillPerception(BotPerception &perception) const;
 
     /// @brief Check if the given object is within the bot's vision range.
     /// @param object The object to check.
@@ -151,8 +193,28 @@ public:
         return pos.sqrDistanceTo(object->pos) <= sqrSeeDistance;
     }
 
+    /// @brief Update bot alone: prepareUpdate(), packProtocol(), finishPerception(), brain update, parseProtocolResponce()
+    /// and finishUpdate().
+    /// Simulation use batched version of the same steps, see Simulation::updateBots()
     void update() override;
 
+    /// @brief Part of update that is done before bot perceive world (metabolism)
+    void prepareUpdate();
+
+    /// @brief Part of update that is done after bot perceived world (or continued intent) and before any bot acts.
+    /// Attacks received until now are perceived, attacks of this tick's actions are perceived on the next tick
+    void finishPerception();
+
+    /// @brief Part of update that is done after bot performed action (death check, healing)
+    void finishUpdate();
+
+    /// @brief Check if bot continue action chosen by brain earlier, so brain must not be called on this tick.
+    /// Cancel intent if any of its end conditions is met
+    bool hasActiveIntent();
+
+    /// @brief Perform action of active intent. Must be called only if hasActiveIntent() returned true
+    void performIntent();
+
     void draw(ImDrawList *draw_list, ImVec2 drawing_delta_pos, float zoom) override
     {
         draw_list->AddCircleFilled(ImVec2(drawing_delta_pos.x + pos.x * zoom, drawing_delta_pos.y + pos.y * zoom), getRadius() * zoom, color, 24);
@@ -185,12 +247,17 @@ public:
 
     bool isUnderAttack() const;
     void displayInfo();
+    void accountMemory(MemoryStats &stats) const override;
+    /// @brief Body and intent of bot. Brain is written separately by WorldSnapshot and must be set before loadState()
+    void saveState(BinaryWriter &writer) const override;
+    void loadState(BinaryReader &reader) override;
 
     void onDestroy() override;
 
     // Actions
 
-    void parseProtocolResponce();
+    /// @brief Perform action described by given responce and remember it as intent if brain asked to persist it
+    void parseProtocolResponce(const UpdateProtocolResponce &responce);
 
     void actionMove(Vec2<float> direction, float speedMultyplier = 1.0f);
 
@@ -206,7 +273,8 @@ public:
 
     /// @brief Preform eating on specific food object
     /// @param targetID If set, than bot will food object bot with given id, if can. If set to ULONG_MAX, will eat nearest food object
-    void actionEat(unsigned long targetID = ULONG_MAX);
+    /// @return True if bot ate something
+    bool actionEat(unsigned long targetID = ULONG_MAX);
 
     /// @brief Raw eat logic without any checks
     void rawEat(std::shared_ptr<FoodObject> targetFood);
@@ -16,8 +16,32 @@ private:
     Counter growingTime;
     Counter matureTime;
 
+    /// @brief Spawned randomly, not by tree. Such food can go back to FoodField when no bot is near
+    bool ambient = false;
+
     std::shared_ptr<ShadowFoodObject> shadow;
 
+    /// @brief Growth, maturing and decay of one tick
+    void advance()
+    {
+        if (growingTime.isMax())
+        {
+            if (matureTime.isMax())
+            {
+                calories.decrease(decayRate);
+            }
+            else
+            {
+                matureTime.increment();
+            }
+        }
+        else
+        {
+            growingTime.increment();
+            calories.increase(growthRate);
+        }
+    }
+
 public:
     FoodObject(
         std::shared_ptr<Simulation> simulation,
@@ -28,7 +52,7 @@ public:
         float growthRate_,
         float decayRate_,
         bool isMature_)
-        : SimulationObject(simulation, position, getRadius(), color),
+        : SimulationObject(simulation, position, convertCaloriesToRadius(calories_), color),
           calories(calories_, 0.0f, maxCalories_),
           growthRate(growthRate_),
           decayRate(decayRate_),
@@ -52,6 +76,47 @@ public:
         return shadow;
     }
 
+    void accountMemory(MemoryStats &stats) const override
+    {
+        stats.add(MemoryStats::FoodObjects, MemoryStats::sharedObjectBytes<FoodObject>());
+        stats.add(MemoryStats::FoodShadows, MemoryStats::sharedObjectBytes<ShadowFoodObject>());
+        accountBaseShadow(stats);
+    }
+
+    void saveState(BinaryWriter &writer) const override
+    {
+        SimulationObject::saveState(writer);
+        writer.write<float>(calories.get());
+        writer.write<float>(calories.getMax());
+        writer.write<float>(growthRate);
+        writer.write<float>(decayRate);
+        writer.write<int32_t>(growingTime.get());
+        writer.write<int32_t>(growingTime.getMax());
+        writer.write<int32_t>(matureTime.get());
+        writer.write<int32_t>(matureTime.getMax());
+        writer.write<uint8_t>(ambient);
+    }
+
+    void loadState(BinaryReader &reader) override
+    {
+        SimulationObject::loadState(reader);
+        const float caloriesValue = reader.read<float>();
+        calories = RangeValue<float>(caloriesValue, 0.0f, reader.read<float>());
+        growthRate = reader.read<float>();
+        decayRate = reader.read<float>();
+        const int growingValue = reader.read<int32_t>();
+        growingTime = Counter(growingValue, reader.read<int32_t>());
+        const int matureValue = reader.read<int32_t>();
+        matureTime = Counter(matureValue, reader.read<int32_t>());
+        ambient = reader.read<uint8_t>() != 0;
+        shadow->_id = id.get();
+        shadow->_pos = pos;
+        shadow->_radius = getRadius();
+        shadow->_calories = calories.get();
+        shadow->_isGrowing = growingTime.isMax();
+        shadow->_isDecaying = growingTime.isMax() && matureTime.isMax();
+    }
+
     float decreaseCalories(float amount)
     {
         if (amount < 0)
@@ -60,6 +125,7 @@ public:
         }
         float decreasedAmount = std::min(amount, calories.get());
         calories.decrease(amount);
+        markDirty();
         if (calories.get() == 0.0f)
         {
             markForDeletion();
@@ -68,24 +134,21 @@ public:
         return decreasedAmount;
     }
 
+    /// @brief Take calories of other food, which then is not added to simulation. Maximum grows by maximum
+    /// of other food, so merged food holds both, growth and decay stay as they are
+    void merge(const FoodObject &other)
+    {
+        const float addedCalories = std::min(other.calories.get(), other.calories.getMax());
+        calories = RangeValue<float>(calories.get() + addedCalories, 0.0f, calories.getMax() + other.calories.getMax());
+        ambient = ambient && other.ambient;
+        markDirty();
+        shadow->_calories = calories.get();
+        shadow->_radius = getRadius();
+    }
+
     void update() override
     {
-        if (growingTime.isMax())
-        {
-            if (matureTime.isMax())
-            {
-                calories.decrease(decayRate);
-            }
-            else
-            {
-                matureTime.increment();
-            }
-        }
-        else
-        {
-            growingTime.increment();
-            calories.increase(growthRate);
-        }
+        advance();
         if (calories.get() == 0.0f)
         {
             markForDeletion();
@@ -97,6 +160,18 @@ public:
         shadow->_radius = getRadius();
     }
 
+    void ageBy(int ticks) override
+    {
+        for (int i = 0; i < ticks; i++)
+        {
+            advance();
+        }
+        shadow->_calories = calories.get();
+        shadow->_isGrowing = growingTime.isMax();
+        shadow->_isDecaying = growingTime.isMax() && matureTime.isMax();
+        shadow->_radius = getRadius();
+    }
+
     void draw(ImDrawList *draw_list, ImVec2 drawing_delta_pos, float zoom) override
     {
         draw_list->AddRectFilled(ImVec2(drawing_delta_pos.x + (pos.x - getRadius()) * zoom, drawing_delta_pos.y + (pos.y - getRadius()) * zoom),
@@ -106,6 +181,11 @@ public:
 
     int getRadius() override { return convertCaloriesToRadius(calories.get()); }
 
+    float getCalories() const { return calories.get(); }
+
+    bool isAmbient() const { return ambient; }
+    void setAmbient(bool ambient_) { ambient = ambient_; }
+
     void displayInfo() override
     {
         // Call parent class displayInfo to show basic information
@@ -17,6 +17,10 @@ void SimulationObject::drawHighlightion(ImDrawList *draw_list, ImVec2 drawing_de
 }
 
 void SimulationObject::markForDeletion() {
+    if (markedForDeletion) {
+        return;
+    }
+    markedForDeletion = true;
     if (auto validSimulation = simulation.lock()) {
         validSimulation->addToDeathNote(shared_from_this());
     }
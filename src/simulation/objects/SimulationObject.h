@@ -5,22 +5,15 @@
 #include "simulation.h"
 #include "chunks.h"
 #include "utilities/utilities.h"
+#include "utilities/MemoryStats.h"
+#include "snapshot/BinaryStream.h"
+#include "objects/SimulationObjectType.h"
 #include "protocols/shadows/ShadowSimulationObject.h"
 
 class Simulation;
 class ObjectID;
 class Chunk;
 
-#ifndef SIMULATION_OBJECT_TYPE_ENUM
-#define SIMULATION_OBJECT_TYPE_ENUM
-enum class SimulationObjectType {
-    BaseObject,
-    FoodObject,
-    TreeObject,
-    BotObject
-};
-#endif
-
 const char* const SimulationObjectTypeNames[4] = {
     "BaseObject",
     "FoodObject",
@@ -47,6 +40,10 @@ public:
     ObjectID id;
 private:
     std::shared_ptr<ShadowSimulationObject> shadow;
+    // Prevent adding object to death note (and destroying it) twice
+    bool markedForDeletion = false;
+    // State was changed since last checkpoint (see DeltaCheckpointer). New objects are dirty
+    bool dirty = true;
 public:
     
     /// @brief Constructs a SimulationObject with the given parameters.
@@ -109,11 +106,50 @@ public:
 
     /// @brief Tell simulation to delete object at the end of frame
     virtual void markForDeletion();
+    bool isMarkedForDeletion() const { return markedForDeletion; }
 
     /// @brief Function that will be called before simulation destroy object
     virtual void onDestroy() {}
 
+    /// @brief Tell checkpoints that state of object was changed by something other than ageBy()
+    void markDirty() { dirty = true; }
+    bool isDirty() const { return dirty; }
+    void clearDirty() { dirty = false; }
+
+    /// @brief Repeat given number of times the part of update() that depends only on state of object
+    /// (timers, growth) without side effects. Objects that were not marked dirty since last checkpoint
+    /// are brought to the next one by it (see DeltaCheckpointer)
+    virtual void ageBy(int ticks) {}
+
+    /// @brief Add estimated memory of object and everything it owns (shadows, protocols) to stats
+    virtual void accountMemory(MemoryStats &stats) const {
+        stats.add(MemoryStats::OtherObjects, MemoryStats::sharedObjectBytes<SimulationObject>());
+        accountBaseShadow(stats);
+    }
+
+    /// @brief Write state of object to world snapshot (see WorldSnapshot). Derived classes append their own state
+    virtual void saveState(BinaryWriter &writer) const {
+        writer.write<uint64_t>(id.get());
+        writer.write<float>(pos.x);
+        writer.write<float>(pos.y);
+        writer.write<int32_t>(radius);
+        writer.write<uint32_t>(color);
+    }
+
+    /// @brief Restore state written by saveState(). Object must be fresh, without id
+    virtual void loadState(BinaryReader &reader) {
+        setID(reader.read<uint64_t>());
+        pos.x = reader.read<float>();
+        pos.y = reader.read<float>();
+        radius = reader.read<int32_t>();
+        color = reader.read<uint32_t>();
+        shadow->_pos = pos;
+        shadow->_radius = radius;
+    }
+
     virtual void displayInfo() {
+        // Any field can be edited here
+        markDirty();
         ImGui::SeparatorText("Simulation Object");
         ImGui::Text("ID: %0*lo:", 6, id.get());
         ImGui::Text("Position:");
@@ -125,4 +161,9 @@ public:
     virtual void drawHighlightion(ImDrawList *draw_list, ImVec2 window_pos, float zoom);
 
     virtual ~SimulationObject() = default;
+
+protected:
+    void accountBaseShadow(MemoryStats &stats) const {
+        stats.add(MemoryStats::BaseShadows, MemoryStats::sharedObjectBytes<ShadowSimulationObject>());
+    }
 };
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Type of simulation object.
+/// Values are written to world snapshots, so existing values must not be changed, only new ones added
+enum class SimulationObjectType : uint8_t
+{
+    BaseObject = 0,
+    FoodObject = 1,
+    TreeObject = 2,
+    BotObject = 3
+};
@@ -29,7 +29,7 @@ public:
         float foodDecayRate_,
         float foodSpawnCooldownMax_,
         bool foodIsMature_)
-        : SimulationObject(simulation, position, getRadius(), colorInt(60, 30, 0)),
+        : SimulationObject(simulation, position, 10 + numberOfFruits_ * 2, colorInt(60, 30, 0)),
         foodMaxCalories(foodMaxCalories_),
         foodGrowthRate(foodGrowthRate_),
         foodDecayRate(foodDecayRate_),
@@ -52,6 +52,41 @@ public:
         return shadow;
     }
 
+    void accountMemory(MemoryStats &stats) const override
+    {
+        stats.add(MemoryStats::TreeObjects, MemoryStats::sharedObjectBytes<TreeObject>());
+        stats.add(MemoryStats::TreeShadows, MemoryStats::sharedObjectBytes<ShadowTreeObject>());
+        accountBaseShadow(stats);
+    }
+
+    void saveState(BinaryWriter &writer) const override
+    {
+        SimulationObject::saveState(writer);
+        writer.write<float>(foodMaxCalories);
+        writer.write<float>(foodGrowthRate);
+        writer.write<float>(foodDecayRate);
+        writer.write<uint8_t>(foodIsMature);
+        writer.write<float>(foodSpawnCooldown);
+        writer.write<float>(foodSpawnCooldownMax);
+        writer.write<int32_t>(numberOfFruits);
+    }
+
+    void loadState(BinaryReader &reader) override
+    {
+        SimulationObject::loadState(reader);
+        foodMaxCalories = reader.read<float>();
+        foodGrowthRate = reader.read<float>();
+        foodDecayRate = reader.read<float>();
+        foodIsMature = reader.read<uint8_t>() != 0;
+        foodSpawnCooldown = reader.read<float>();
+        foodSpawnCooldownMax = reader.read<float>();
+        numberOfFruits = reader.read<int32_t>();
+        shadow->_id = id.get();
+        shadow->_pos = pos;
+        shadow->_radius = getRadius();
+        shadow->_numberOfFruits = numberOfFruits;
+    }
+
     void update() override
     {
         if (foodSpawnCooldown > 0.0f) {
@@ -60,10 +95,21 @@ public:
         else {
             spawnFood();
             foodSpawnCooldown = foodSpawnCooldownMax;
+            markDirty();
         }
 
     }
 
+    void ageBy(int ticks) override
+    {
+        // Spawn of food always makes tree dirty, so here only cooldown goes
+        for (int i = 0; i < ticks; i++) {
+            if (foodSpawnCooldown > 0.0f) {
+                foodSpawnCooldown -= 1.0f;
+            }
+        }
+    }
+
     /// @brief Spawns a set of food objects around the Tree in a regular polygon pattern.
     void spawnFood() {
         float mapWidth;
@@ -90,14 +136,13 @@ public:
 
             float angle = 2.0f * M_PI * i / numberOfFruits;
 
-            Vec2<float> foodPosition = Vec2<float>(
+            Vec2<float> foodPosition = clampPosition(Vec2<float>(
                 pos.x + cos(angle) * (getRadius() + 15),
                 pos.y + sin(angle) * (getRadius() + 15)
-            );
+            ));
 
             if (auto validSimulation = simulation.lock()) {
-                validSimulation->addObject(
-                    SimulationObjectType::FoodObject,
+                validSimulation->addFood(
                     std::make_shared<FoodObject>(
                         validSimulation, foodPosition,
                         colorInt(0, 255, 0),
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <vector>
+#include <string>
+
+#include "UpdateProtocol.h"
+#include "utilities/Vec2.h"
+
+class BotBrain;
+
+/// @brief Flat copy of the most used UpdateProtocol values of one bot.
+/// Contain only plain values, so array of perceptions can be processed without pointer chasing.
+struct BotPerception
+{
+    /// @brief Short description of nearest object of some kind
+    struct NearestInfo
+    {
+        unsigned long id = 0;         ///< ID of nearest object
+        Vec2<float> delta;            ///< Vector from bot position to nearest object position
+        float distance = -1.0f;       ///< Distance to nearest object. -1.0f if there is no such object in vision
+        int radius = 0;               ///< Radius of nearest object
+
+        bool exists() const { return distance != -1.0f; }
+    };
+
+    unsigned long id = 0;
+    Vec2<float> pos;
+    int radius = 0;
+
+    float health = 0.0f;
+    float maxHealth = 0.0f;
+    float food = 0.0f;
+    float maxFood = 0.0f;
+    int seeDistance = 0;
+    float speed = 0.0f;
+    float damage = 0.0f;
+    bool underAttack = false;
+
+    NearestInfo nearestFood;
+    NearestInfo nearestTree;
+    NearestInfo nearestFriend;
+    NearestInfo nearestEnemy;
+
+    /// @brief Calories of nearest food. 0.0f if there is no food in vision
+    float nearestFoodCalories = 0.0f;
+    /// @brief Health of nearest enemy. 0.0f if there is no enemies in vision
+    float nearestEnemyHealth = 0.0f;
+
+    // Counts stay 0 for brains that return false from BotBrain::needsVisibleSets()
+    int visibleFoodCount = 0;
+    int visibleTreeCount = 0;
+    int visibleFriendsCount = 0;
+    int visibleEnemiesCount = 0;
+};
+
+/// @brief Fill flat perception from packed UpdateProtocol of the bot
+/// @param data Packed UpdateProtocol (body must be set)
+/// @param perception Perception to fill
+inline void packPerception(const UpdateProtocol &data, BotPerception &perception)
+{
+    const Vec2<float> pos = data.body->pos();
+
+    perception.id = data.body->id();
+    perception.pos = pos;
+    perception.radius = data.body->radius();
+    perception.health = data.body->health();
+    perception.maxHealth = data.body->maxHealth();
+    perception.food = data.body->food();
+    perception.maxFood = data.body->maxFood();
+    perception.seeDistance = data.body->seeDistance();
+    perception.speed = data.body->speed();
+    perception.damage = data.body->damage();
+    perception.underAttack = data.body->isUnderAttack();
+
+    auto fillNearest = [&pos](BotPerception::NearestInfo &info, const ShadowSimulationObject *nearest, float distance)
+    {
+        if (nearest)
+        {
+            info.id = nearest->id();
+            info.delta = nearest->pos() - pos;
+            info.distance = distance;
+            info.radius = nearest->radius();
+        }
+        else
+        {
+            info = BotPerception::NearestInfo();
+        }
+    };
+    fillNearest(perception.nearestFood, data.nearestFood.get(), data.distanceToNearestFood);
+    fillNearest(perception.nearestTree, data.nearestTree.get(), data.distanceToNearestTree);
+    fillNearest(perception.nearestFriend, data.nearestFriend.get(), data.distanceToNearestFriend);
+    fillNearest(perception.nearestEnemy, data.nearestEnemy.get(), data.distanceToNearestEnemy);
+
+    perception.nearestFoodCalories = data.nearestFood ? data.nearestFood->calories() : 0.0f;
+    perception.nearestEnemyHealth = data.nearestEnemy ? data.nearestEnemy->health() : 0.0f;
+
+    perception.visibleFoodCount = static_cast<int>(data.visibleFood.size());
+    perception.visibleTreeCount = static_cast<int>(data.visibleTree.size());
+    perception.visibleFriendsCount = static_cast<int>(data.visibleFriends.size());
+    perception.visibleEnemiesCount = static_cast<int>(data.visibleEnemies.size());
+}
+
+/// @brief All bots of one population that are updated on current tick.
+/// Row i of every vector describe the same bot.
+struct UpdateBatch
+{
+    /// @brief Name of population all bots of batch belong to
+    std::string populationName;
+    /// @brief Perception of each bot
+    std::vector<BotPerception> perceptions;
+    /// @brief Responces that brain must fill. Each responce is reset to DoNothing before the call
+    std::vector<UpdateProtocolResponce> responces;
+    /// @brief Own brain of each bot. Used by per-bot adapter of BotBrain::updateBatch()
+    std::vector<BotBrain *> brains;
+
+    /// @brief Time limit of one update() call in microseconds. 0 - no limit.
+    /// Responce of call that exceeded it is replaced with DoNothing
+    float timeBudgetUs = 0.0f;
+    /// @brief If true, per-bot adapter write time of every update() call to callTimesUs
+    bool measureCalls = false;
+    std::vector<float> callTimesUs;
+    /// @brief Set by per-bot adapter when it checked time budget of every call itself
+    bool budgetChecked = false;
+    /// @brief Number of responces replaced because of time budget
+    int overBudget = 0;
+
+    size_t size() const { return perceptions.size(); }
+    bool empty() const { return perceptions.empty(); }
+
+    /// @brief Remove all rows but keep allocated memory for the next tick
+    void clear()
+    {
+        perceptions.clear();
+        responces.clear();
+        brains.clear();
+        callTimesUs.clear();
+        budgetChecked = false;
+        overBudget = 0;
+    }
+};
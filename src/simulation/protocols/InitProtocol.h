@@ -48,9 +48,9 @@ struct InitProtocol
     /// @brief Position on which bot will be spawned
     Vec2<float> botSpawnPosition;
     /// @brief Maximal amount of evolution points that can be spent
-    int evolutionPoints;
+    int evolutionPoints = 0;
     ///
-    int costumeMessage;
+    int costumeMessage = 0;
 
     // Constructor
     InitProtocol() {}
@@ -165,6 +165,55 @@ struct UpdateProtocolResponce
     {
         actionType = BotAction::Suicide;
     }
+
+    /*
+     * Persistence of chosen action (intent). By default action is performed once and brain
+     * is called again on the next tick. If persistence is set, simulation repeats the action
+     * on the following ticks by itself, without packing vision and calling brain,
+     * until one of the conditions ends it. Spawn and Suicide are never repeated.
+     */
+    struct PersistInfo
+    {
+        int ticks = 0;                 ///< Maximum number of extra ticks action is repeated. 0 - no persistence
+        bool untilArrival = false;     ///< GoTo: stop when target position is reached
+        bool untilFull = false;        ///< EatNearest/EatByID: stop when stomach is full or there is nothing to eat
+        bool interruptOnAttack = true; ///< Stop when bot is attacked
+        bool interruptOnEnemy = false; ///< Stop when enemy is in vision. Cost one cheap vision scan per tick
+    };
+    PersistInfo persistArgs;
+    /// @brief Repeat chosen action on the next ticks without calling brain
+    /// @param ticks Number of extra ticks to repeat action
+    UpdateProtocolResponce &persistFor(int ticks)
+    {
+        persistArgs = PersistInfo();
+        persistArgs.ticks = ticks;
+        return *this;
+    }
+    /// @brief Repeat GoTo until target position is reached
+    /// @param maxTicks Call brain anyway after this number of ticks
+    UpdateProtocolResponce &persistUntilArrival(int maxTicks = 300)
+    {
+        persistFor(maxTicks);
+        persistArgs.untilArrival = true;
+        return *this;
+    }
+    /// @brief Repeat eating until stomach is full or food is gone
+    /// @param maxTicks Call brain anyway after this number of ticks
+    UpdateProtocolResponce &persistUntilFull(int maxTicks = 300)
+    {
+        persistFor(maxTicks);
+        persistArgs.untilFull = true;
+        return *this;
+    }
+    /// @brief Set events on which simulation stop repeating action and call brain
+    /// @param attack Call brain when bot is attacked
+    /// @param enemy Call brain when enemy is in vision
+    UpdateProtocolResponce &interruptOn(bool attack, bool enemy)
+    {
+        persistArgs.interruptOnAttack = attack;
+        persistArgs.interruptOnEnemy = enemy;
+        return *this;
+    }
 };
 
 struct UpdateProtocol
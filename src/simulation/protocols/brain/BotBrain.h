@@ -1,9 +1,13 @@
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <string>
 
 #include "protocols/ProtocolsHolder.h"
+#include "protocols/BatchProtocol.h"
+#include "protocols/brain/BrainContext.h"
+#include "snapshot/BinaryStream.h"
 #include "objects/Bot.h"
 #include "simulation.h"
 class BotBrain
@@ -11,9 +15,19 @@ class BotBrain
 private:
     friend BotObject;
     friend Simulation;
+    friend class RemoteBrainServer;
+    friend class RemoteBrainHost;
+    friend class WorldSnapshot;
+    friend class ActionRecorder;
 protected:
     /// @brief Holder for all protocols of communication between brain and simulation
     std::shared_ptr<ProtocolsHolder> protocolsHolder;
+    /*
+     * Context of simulation the bot lives in. Set by simulation before init() is called.
+     * Keep population-wide data here (context->populationState<T>(populationName))
+     * instead of static members, so each simulation has its own copy.
+     */
+    std::shared_ptr<BrainContext> context;
 public:
     const std::string populationName;
 
@@ -34,6 +48,55 @@ public:
      * telling the BotObject what to do and howto do it.
      */
     virtual void update(UpdateProtocol& data, UpdateProtocolResponce& responce) {}
+    /*
+     * Function that will be called on each frame once for all bots of the population.
+     * It is called on brain of the first bot of batch and should fill batch.responces[i]
+     * for every batch.perceptions[i].
+     * Default implementation is an adapter that call update() of each bot's own brain,
+     * so brains that override only update() keep working without changes.
+     * Override it if your population can decide for all bots at once (e.g. vectorised logic).
+     */
+    virtual void updateBatch(UpdateBatch& batch)
+    {
+        const bool timed = batch.measureCalls || batch.timeBudgetUs > 0.0f;
+        batch.budgetChecked = true;
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            BotBrain *botBrain = batch.brains[i];
+            const auto start = timed ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+            // Action is kept from the previous tick if brain dont set new one, but persistence is not
+            botBrain->protocolsHolder->updateProtocolResponce.persistArgs = UpdateProtocolResponce::PersistInfo();
+            botBrain->update(botBrain->protocolsHolder->updateProtocol, botBrain->protocolsHolder->updateProtocolResponce);
+            if (timed)
+            {
+                const float callTimeUs = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - start).count();
+                if (batch.measureCalls)
+                {
+                    batch.callTimesUs.push_back(callTimeUs);
+                }
+                if (batch.timeBudgetUs > 0.0f && callTimeUs > batch.timeBudgetUs)
+                {
+                    // Too slow decision is dropped, responce stays DoNothing
+                    batch.overBudget++;
+                    continue;
+                }
+            }
+            batch.responces[i] = botBrain->protocolsHolder->updateProtocolResponce;
+        }
+    }
+    /*
+     * Optional asynchronous version of updateBatch(). Simulation first call startBatch()
+     * for all populations, then updateBatch() for populations that returned false and
+     * then finishBatch() for populations that returned true.
+     * Return true if batch was accepted (e.g. sent to other process) and responces
+     * will be written in finishBatch(). Batch stays alive and unchanged between the calls.
+     */
+    virtual bool startBatch(UpdateBatch& batch) { return false; }
+    /*
+     * Function that will be called after all local populations are updated
+     * for every batch accepted by startBatch(). It should fill batch.responces.
+     */
+    virtual void finishBatch(UpdateBatch& batch) {}
     /*
      * Function that will be called on the died of the bot.
      * It should read protocolsHolder->KillProtocol and modify protocolsHolder->KillProtocolResponce
@@ -41,6 +104,26 @@ public:
      */
     virtual void kill(KillProtocol& data, KillProtocolResponce& responce) {}
 
+    /*
+     * Function that will be called when world is saved to snapshot (see WorldSnapshot).
+     * It should write state of brain that init() and update() created (e.g. weights, random generator).
+     * Protocols, population name and context are saved by simulation.
+     * Write objects shared by whole population with writer.writeShared(), so they are stored once.
+     */
+    virtual void saveState(BinaryWriter& writer) const {}
+    /*
+     * Function that will be called instead of init() when bot is loaded from snapshot.
+     * It should read exactly what saveState() wrote. Context and protocolsHolder are already restored.
+     */
+    virtual void loadState(BinaryReader& reader) {}
+
+    /*
+     * Indicate if brain read visible* sets of UpdateProtocol.
+     * If false, simulation pack only body and nearest objects for bots with this brain,
+     * which make perception much cheaper. Override it in brains that dont use sets.
+     */
+    virtual bool needsVisibleSets() const { return true; }
+
     /*
      * Check if given object can be reached
      * (Compare distance between them to sum of their radiuses)
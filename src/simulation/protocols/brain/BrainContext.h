@@ -0,0 +1,62 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <typeindex>
+
+/// @brief State shared by all brains of one simulation.
+/// Use it instead of static members of brain class, so several simulations
+/// can live in one process without interfering with each other.
+/// Not thread safe: brains of one simulation are updated from one thread.
+class BrainContext
+{
+public:
+    /// @brief Counters of population maintained by simulation
+    struct PopulationStats
+    {
+        /// @brief Amount of currently alive bots
+        int population = 0;
+        /// @brief Amount of died bots
+        int death = 0;
+        /// @brief Amount of bots ever born (including starting bots)
+        unsigned long born = 0;
+    };
+
+private:
+    std::map<std::string, PopulationStats> stats;
+    std::map<std::pair<std::string, std::type_index>, std::shared_ptr<void>> states;
+    std::mt19937 randomGenerator;
+
+public:
+    explicit BrainContext(unsigned int seed) : randomGenerator(seed) {}
+
+    BrainContext(const BrainContext &) = delete;
+    BrainContext &operator=(const BrainContext &) = delete;
+
+    /// @brief Get counters of given population. Created on first access
+    PopulationStats &populationStats(const std::string &populationName)
+    {
+        return stats[populationName];
+    }
+
+    const std::map<std::string, PopulationStats> &getAllPopulationStats() const { return stats; }
+
+    /// @brief Get object of type T shared by all bots of given population in this simulation.
+    /// Object is default constructed on first access. Keep returned pointer to avoid repeated lookups
+    /// @example auto base = context->populationState<HomeBase>(populationName);
+    template <typename T>
+    std::shared_ptr<T> populationState(const std::string &populationName)
+    {
+        auto &state = states[{populationName, std::type_index(typeid(T))}];
+        if (!state)
+        {
+            state = std::make_shared<T>();
+        }
+        return std::static_pointer_cast<T>(state);
+    }
+
+    /// @brief Random generator of simulation. Use it to seed generators of brains
+    std::mt19937 &random() { return randomGenerator; }
+};
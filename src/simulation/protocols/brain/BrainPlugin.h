@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+
+#include "protocols/brain/BrainsRegistry.h"
+
+/*
+ * Interface of brain plugins: shared libraries with brains that are loaded by
+ * BrainPluginLoader at runtime. Plugin is built separately from simulation (see
+ * add_brain_plugin() in CMakeLists.txt), so changing brain dont rebuild simulation.
+ *
+ * Plugin source must contain exactly one BRAIN_PLUGIN() with all its brain classes:
+ *     #include "protocols/brain/BrainPlugin.h"
+ *     #include "brains/tunable/TunableBrain.h"
+ *     BRAIN_PLUGIN(TunableBrain)
+ *
+ * Plugin must be built by the same compiler and from the same simulation sources,
+ * because brains are passed between simulation and plugin as C++ objects.
+ */
+
+/// @brief Version of plugin interface. Increase it on any change of BotBrain or protocols
+#define BRAIN_PLUGIN_API_VERSION 1
+
+using BrainPluginApiVersionFunction = int (*)();
+using BrainPluginRegisterFunction = void (*)(BrainsRegistry &);
+
+/// @brief Register every brain class under its population name
+template <typename... Brains>
+inline void registerPluginBrains(BrainsRegistry &registry)
+{
+    (registry.registerBot(std::make_shared<Brains>()->populationName, [](BrainContext &) -> std::shared_ptr<BotBrain>
+                          { return std::make_shared<Brains>(); }),
+     ...);
+}
+
+#define BRAIN_PLUGIN(...)                                                     \
+    extern "C" int brainPluginApiVersion() { return BRAIN_PLUGIN_API_VERSION; } \
+    extern "C" void brainPluginRegister(BrainsRegistry &registry) { registerPluginBrains<__VA_ARGS__>(registry); }
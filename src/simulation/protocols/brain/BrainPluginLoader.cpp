@@ -0,0 +1,128 @@
+#include "protocols/brain/BrainPluginLoader.h"
+#include "protocols/brain/BrainPlugin.h"
+
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#include <unistd.h>
+#define BRAIN_PLUGINS_SUPPORTED 1
+#endif
+
+namespace fs = std::filesystem;
+
+void BrainPluginLoader::load(PluginInfo &plugin)
+{
+#ifdef BRAIN_PLUGINS_SUPPORTED
+    const auto writeTime = fs::last_write_time(plugin.path);
+
+    // dlopen returns already loaded library for the same path, so every version is loaded from its own copy
+    const fs::path copy = fs::temp_directory_path() /
+                          ("brain_plugin_" + std::to_string(getpid()) + "_" + std::to_string(loadCounter++) + "_" +
+                           plugin.path.filename().string());
+    fs::copy_file(plugin.path, copy, fs::copy_options::overwrite_existing);
+    void *handle = dlopen(copy.c_str(), RTLD_NOW | RTLD_LOCAL);
+    // Mapped library stays valid after its file is removed
+    std::error_code ignored;
+    fs::remove(copy, ignored);
+    if (!handle)
+    {
+        throw std::runtime_error(dlerror());
+    }
+
+    auto apiVersion = reinterpret_cast<BrainPluginApiVersionFunction>(dlsym(handle, "brainPluginApiVersion"));
+    auto registerBrains = reinterpret_cast<BrainPluginRegisterFunction>(dlsym(handle, "brainPluginRegister"));
+    if (!apiVersion || !registerBrains)
+    {
+        dlclose(handle);
+        throw std::runtime_error("Not a brain plugin, BRAIN_PLUGIN() is missing");
+    }
+    if (apiVersion() != BRAIN_PLUGIN_API_VERSION)
+    {
+        const int version = apiVersion();
+        dlclose(handle);
+        throw std::runtime_error("Plugin is built for interface version " + std::to_string(version) +
+                                 ", simulation has version " + std::to_string(BRAIN_PLUGIN_API_VERSION));
+    }
+
+    BrainsRegistry pluginRegistry;
+    registerBrains(pluginRegistry);
+
+    // From here library is never closed, see class description
+    plugin.populationNames = pluginRegistry.listRegisteredBots();
+    registry.registerAll(pluginRegistry);
+    plugin.loadedWriteTime = writeTime;
+    plugin.version++;
+    plugin.lastError.clear();
+#else
+    throw std::runtime_error("Brain plugins are not supported on this system");
+#endif
+}
+
+bool BrainPluginLoader::tryLoad(PluginInfo &plugin)
+{
+    try
+    {
+        load(plugin);
+        return true;
+    }
+    catch (const std::exception &e)
+    {
+        plugin.lastError = e.what();
+        std::cerr << "Cant load brain plugin " << plugin.path.string() << ": " << e.what() << "\n";
+        return false;
+    }
+}
+
+std::vector<std::string> BrainPluginLoader::loadAll()
+{
+    plugins.clear();
+    return reloadChanged();
+}
+
+std::vector<std::string> BrainPluginLoader::reloadChanged()
+{
+    std::vector<std::string> changedPopulations;
+#ifdef BRAIN_PLUGINS_SUPPORTED
+    std::error_code error;
+    if (!fs::is_directory(directory, error))
+    {
+        return changedPopulations;
+    }
+
+    std::vector<fs::path> files;
+    for (const auto &entry : fs::directory_iterator(directory, error))
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".so")
+        {
+            files.push_back(entry.path());
+        }
+    }
+    // Load in stable order, so the same population in two plugins always resolve the same way
+    std::sort(files.begin(), files.end());
+
+    for (const auto &file : files)
+    {
+        auto plugin = std::find_if(plugins.begin(), plugins.end(), [&file](const PluginInfo &info)
+                                   { return info.path == file; });
+        if (plugin == plugins.end())
+        {
+            plugins.push_back(PluginInfo{.path = file, .loadedWriteTime = {}, .version = 0, .populationNames = {}, .lastError = {}});
+            plugin = plugins.end() - 1;
+        }
+        else if (plugin->version > 0 && fs::last_write_time(file, error) == plugin->loadedWriteTime)
+        {
+            continue;
+        }
+
+        if (tryLoad(*plugin))
+        {
+            changedPopulations.insert(changedPopulations.end(), plugin->populationNames.begin(), plugin->populationNames.end());
+        }
+    }
+#endif
+    return changedPopulations;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "protocols/brain/BrainsRegistry.h"
+
+/*
+ * Load brain plugins (see BrainPlugin.h) from directory and keep registry
+ * with factories of their latest versions.
+ *
+ * Libraries are never unloaded: bots created by old version of plugin can live
+ * long after reload, and their code must stay in memory. Every reload therefore
+ * cost memory of one more copy of plugin, which is fine for development.
+ * Supported only on POSIX systems, elsewhere no plugins are found.
+ */
+class BrainPluginLoader
+{
+public:
+    struct PluginInfo
+    {
+        /// @brief Path to plugin in plugins directory
+        std::filesystem::path path;
+        /// @brief Modification time of loaded version
+        std::filesystem::file_time_type loadedWriteTime;
+        /// @brief Number of times plugin was loaded. 0 if plugin failed to load
+        int version = 0;
+        /// @brief Populations registered by the last loaded version
+        std::vector<std::string> populationNames;
+        /// @brief Error of the last load attempt. Empty if it was successful
+        std::string lastError;
+    };
+
+private:
+    std::filesystem::path directory;
+    std::vector<PluginInfo> plugins;
+    BrainsRegistry registry;
+    unsigned int loadCounter = 0;
+
+    /// @brief Load (new copy of) plugin and register its brains. Throw on error
+    void load(PluginInfo &plugin);
+    /// @brief Load plugin, saving error instead of throwing
+    /// @return True on success
+    bool tryLoad(PluginInfo &plugin);
+
+public:
+    /// @param directory_ Directory with plugins (*.so files)
+    explicit BrainPluginLoader(std::filesystem::path directory_) : directory(std::move(directory_)) {}
+
+    BrainPluginLoader(const BrainPluginLoader &) = delete;
+    BrainPluginLoader &operator=(const BrainPluginLoader &) = delete;
+
+    /// @brief Load all plugins in directory. Plugins that fail to load are reported in getPlugins()
+    /// @return Names of registered populations
+    std::vector<std::string> loadAll();
+
+    /// @brief Load new plugins and plugins whose file changed since they were loaded.
+    /// Call it between ticks, then replace brains of living bots (see Simulation::reloadBrainPlugins())
+    /// @return Names of populations whose factories changed
+    std::vector<std::string> reloadChanged();
+
+    /// @brief Registry with brains of the latest loaded versions of plugins
+    const BrainsRegistry &getRegistry() const { return registry; }
+    const std::vector<PluginInfo> &getPlugins() const { return plugins; }
+    const std::filesystem::path &getDirectory() const { return directory; }
+};
@@ -5,10 +5,15 @@
 #include <functional>
 #include <map>
 
-// Registry for bot creation
+// Registry for bot creation.
+// Global instance is filled by REGISTER_BOT_CLASS, but registries can also be created
+// separately (e.g. copy of global one with some brains removed) and passed to Simulation::initBotClasses()
 class BrainsRegistry {
 public:
-    using BrainFactory = std::function<std::shared_ptr<BotBrain>()>;
+    /// @brief Create new brain. Context is the one of simulation brain will live in
+    using BrainFactory = std::function<std::shared_ptr<BotBrain>(BrainContext&)>;
+
+    BrainsRegistry() = default;
 
     static BrainsRegistry& getInstance() {
         static BrainsRegistry instance;
@@ -19,10 +24,21 @@ public:
         botFactories[name] = factory;
     }
 
-    std::shared_ptr<BotBrain> createBot(const std::string& name) const {
+    /// @brief Register all factories of other registry, replacing factories with the same names
+    void registerAll(const BrainsRegistry& other) {
+        for (const auto& [name, factory] : other.botFactories) {
+            botFactories[name] = factory;
+        }
+    }
+
+    void unregisterBot(const std::string& name) {
+        botFactories.erase(name);
+    }
+
+    std::shared_ptr<BotBrain> createBot(const std::string& name, BrainContext& context) const {
         auto it = botFactories.find(name);
         if (it != botFactories.end()) {
-            return it->second();
+            return it->second(context);
         }
         throw std::runtime_error("Bot class not found: " + name);
     }
@@ -37,11 +53,6 @@ public:
 
 private:
     std::map<std::string, BrainFactory> botFactories;
-
-    // Singleton, so prevent direct construction
-    BrainsRegistry() = default;
-    BrainsRegistry(const BrainsRegistry&) = delete;
-    BrainsRegistry& operator=(const BrainsRegistry&) = delete;
 };
 
 #define REGISTER_BOT_CLASS(CLASS) \
@@ -49,7 +60,7 @@ private:
         struct CLASS##Registrar { \
             CLASS##Registrar() { \
                 auto botInstance = std::make_shared<CLASS>(); \
-                BrainsRegistry::getInstance().registerBot(botInstance->populationName, []() { \
+                BrainsRegistry::getInstance().registerBot(botInstance->populationName, [](BrainContext&) { \
                     return std::make_shared<CLASS>(); \
                 }); \
             } \
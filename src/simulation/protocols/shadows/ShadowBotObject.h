@@ -8,6 +8,7 @@ class ShadowBotObject : public ShadowSimulationObject
 {
 private:
     friend class BotObject;
+    friend class RemoteBrainServer;
 
     float _health;
     float _food;
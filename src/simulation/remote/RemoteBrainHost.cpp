@@ -0,0 +1,429 @@
+#include "remote/RemoteBrainHost.h"
+
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+void RemoteBrain::init(InitProtocol &data, InitProtocolResponce &responce)
+{
+    host->initBrain(*this, data, responce);
+}
+
+void RemoteBrain::updateBatch(UpdateBatch &batch)
+{
+    if (startBatch(batch))
+    {
+        finishBatch(batch);
+    }
+}
+
+bool RemoteBrain::startBatch(UpdateBatch &batch)
+{
+    pendingSequence = host->sendBatch(batch);
+    return true;
+}
+
+void RemoteBrain::finishBatch(UpdateBatch &batch)
+{
+    host->receiveBatch(pendingSequence, batch);
+    pendingSequence = 0;
+}
+
+void RemoteBrain::kill(KillProtocol &data, KillProtocolResponce &responce)
+{
+    host->killBrain(*this);
+    responce.success = true;
+}
+
+RemoteBrainHost::RemoteBrainHost(const Options &options_) : options(options_)
+{
+    if (options.workers < 1 || options.timeoutMs < 1)
+    {
+        throw std::invalid_argument("Remote brain host needs at least one worker and positive timeout!");
+    }
+    options.ringCapacity = std::max<size_t>(1024, (options.ringCapacity + 7) & ~size_t(7));
+}
+
+std::shared_ptr<RemoteBrainHost> RemoteBrainHost::start(const Options &options)
+{
+    static std::atomic<unsigned int> segmentCounter{0};
+
+    std::shared_ptr<RemoteBrainHost> host(new RemoteBrainHost(options));
+    const uint32_t workersCount = static_cast<uint32_t>(host->options.workers);
+    const size_t ringCapacity = host->options.ringCapacity;
+
+    const std::string name = "/bot_brains_" + std::to_string(getpid()) + "_" + std::to_string(segmentCounter++);
+    host->memory = std::make_unique<SharedMemorySegment>(name, RemoteControlBlock::requiredSize(workersCount, ringCapacity), true);
+
+    host->control = new (host->memory->data()) RemoteControlBlock();
+    host->control->magic = RemoteControlBlock::magicValue;
+    host->control->workers = workersCount;
+    host->control->ringCapacity = ringCapacity;
+    host->control->hostReady.store(0);
+    host->control->shutdown.store(0);
+    for (uint32_t i = 0; i < workersCount; i++)
+    {
+        SharedMemoryRing::initialize(host->control->ringMemory(i, false), ringCapacity);
+        SharedMemoryRing::initialize(host->control->ringMemory(i, true), ringCapacity);
+        host->workers.push_back(Worker{SharedMemoryRing(host->control->ringMemory(i, false)),
+                                       SharedMemoryRing(host->control->ringMemory(i, true)),
+                                       {}});
+    }
+
+    std::string shmArgument = "--shm";
+    std::vector<char *> argv = {host->options.hostExecutable.data(), shmArgument.data(),
+                                const_cast<char *>(name.c_str()), nullptr};
+    if (posix_spawn(&host->hostPid, host->options.hostExecutable.c_str(), nullptr, nullptr, argv.data(), environ) != 0)
+    {
+        host->hostPid = -1;
+        throw std::runtime_error("Cant start brain host " + host->options.hostExecutable);
+    }
+
+    // Host needs some time to start threads, but not more than a few seconds
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(5000, host->options.timeoutMs));
+    while (!host->control->hostReady.load(std::memory_order_acquire))
+    {
+        int status;
+        if (waitpid(host->hostPid, &status, WNOHANG) == host->hostPid)
+        {
+            host->hostPid = -1;
+            throw std::runtime_error("Brain host " + host->options.hostExecutable + " exited during start");
+        }
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            throw std::runtime_error("Brain host " + host->options.hostExecutable + " did not start in time");
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    host->connected = true;
+    return host;
+}
+
+RemoteBrainHost::~RemoteBrainHost()
+{
+    if (control)
+    {
+        control->shutdown.store(1, std::memory_order_release);
+    }
+    if (hostPid > 0)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        int status;
+        while (waitpid(hostPid, &status, WNOHANG) == 0)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                ::kill(hostPid, SIGKILL);
+                waitpid(hostPid, &status, 0);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+std::shared_ptr<BotBrain> RemoteBrainHost::createBrain(const std::string &populationName)
+{
+    return std::make_shared<RemoteBrain>(shared_from_this(), populationName);
+}
+
+BrainsRegistry RemoteBrainHost::makeRegistry(const std::vector<std::string> &populationNames)
+{
+    BrainsRegistry registry;
+    for (const auto &populationName : populationNames)
+    {
+        std::weak_ptr<RemoteBrainHost> weakHost = shared_from_this();
+        registry.registerBot(populationName, [weakHost, populationName](BrainContext &)
+                             {
+            auto host = weakHost.lock();
+            if (!host)
+            {
+                throw std::runtime_error("Remote brain host is already destroyed!");
+            }
+            return host->createBrain(populationName); });
+    }
+    return registry;
+}
+
+RemoteBrainHost::Worker &RemoteBrainHost::workerOf(const std::string &populationName)
+{
+    return workers[std::hash<std::string>()(populationName) % workers.size()];
+}
+
+void RemoteBrainHost::checkHostAlive()
+{
+    int status;
+    if (hostPid > 0 && waitpid(hostPid, &status, WNOHANG) == hostPid)
+    {
+        std::cerr << "Brain host exited, remote bots will do nothing\n";
+        hostPid = -1;
+        connected = false;
+    }
+}
+
+void RemoteBrainHost::fail(const std::string &reason)
+{
+    stats.failures++;
+    if (connected)
+    {
+        std::cerr << reason << ", remote bots will do nothing\n";
+        connected = false;
+    }
+}
+
+bool RemoteBrainHost::send(Worker &worker, const std::vector<char> &data)
+{
+    if (data.size() > worker.requests.maxMessageSize())
+    {
+        // Population outgrew Options::ringCapacity, it would never fit
+        fail("Batch is bigger than shared memory ring can hold");
+        return false;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeoutMs);
+    unsigned int idleRounds = 0;
+    while (!worker.requests.tryPush(data.data(), static_cast<uint32_t>(data.size())))
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            checkHostAlive();
+            fail("Brain host does not read requests");
+            return false;
+        }
+        remoteBackoff(idleRounds);
+    }
+    stats.bytesSent += data.size();
+    return true;
+}
+
+bool RemoteBrainHost::receive(Worker &worker, uint64_t sequence, std::vector<char> &responce)
+{
+    auto stashed = worker.stashed.find(sequence);
+    if (stashed != worker.stashed.end())
+    {
+        responce = std::move(stashed->second);
+        worker.stashed.erase(stashed);
+        pending.erase(sequence);
+        return true;
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeoutMs);
+    unsigned int idleRounds = 0;
+    while (true)
+    {
+        if (worker.responces.tryPop(responce))
+        {
+            idleRounds = 0;
+            stats.bytesReceived += responce.size();
+            if (responce.size() < sizeof(RemoteMessageHeader))
+            {
+                pending.erase(sequence);
+                fail("Brain host sent truncated message");
+                return false;
+            }
+            RemoteMessageHeader header;
+            size_t offset = 0;
+            readFromMessage(responce, offset, &header);
+            if (header.sequence == sequence)
+            {
+                pending.erase(sequence);
+                return true;
+            }
+            // Responce of other population served by the same worker, or late responce of timed out request
+            if (pending.count(header.sequence))
+            {
+                worker.stashed[header.sequence] = responce;
+            }
+            continue;
+        }
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            stats.timeouts++;
+            pending.erase(sequence);
+            checkHostAlive();
+            return false;
+        }
+        remoteBackoff(idleRounds);
+    }
+}
+
+void RemoteBrainHost::initBrain(RemoteBrain &brain, const InitProtocol &data, InitProtocolResponce &responce)
+{
+    if (brain.remoteId == 0)
+    {
+        brain.remoteId = nextRemoteId++;
+    }
+    if (!connected)
+    {
+        return;
+    }
+
+    RemoteMessageHeader header;
+    header.type = RemoteMessageType::Init;
+    header.count = 1;
+    header.sequence = nextSequence++;
+    header.setPopulationName(brain.populationName);
+    const RemoteInitRequest request{brain.remoteId, data.evolutionPoints, data.botSpawnPosition.x, data.botSpawnPosition.y};
+
+    message.clear();
+    appendToMessage(message, &header);
+    appendToMessage(message, &request);
+
+    Worker &worker = workerOf(brain.populationName);
+    pending[header.sequence] = PendingRequest{std::chrono::steady_clock::now()};
+    if (!send(worker, message))
+    {
+        pending.erase(header.sequence);
+        return;
+    }
+    if (!receive(worker, header.sequence, message))
+    {
+        return;
+    }
+    if (message.size() != sizeof(RemoteMessageHeader) + sizeof(RemoteInitResponce))
+    {
+        fail("Brain host answered init with wrong size");
+        return;
+    }
+
+    size_t offset = sizeof(RemoteMessageHeader);
+    RemoteInitResponce remoteResponce;
+    readFromMessage(message, offset, &remoteResponce);
+    responce = InitProtocolResponce(remoteResponce.healthPoints, remoteResponce.foodPoints, remoteResponce.visionPoints,
+                                    remoteResponce.speedPoints, remoteResponce.attackPoints,
+                                    remoteResponce.r, remoteResponce.g, remoteResponce.b);
+    stats.inits++;
+}
+
+uint64_t RemoteBrainHost::sendBatch(const UpdateBatch &batch)
+{
+    if (!connected)
+    {
+        return 0;
+    }
+
+    RemoteMessageHeader header;
+    header.type = RemoteMessageType::Batch;
+    header.count = static_cast<uint32_t>(batch.size());
+    header.sequence = nextSequence++;
+    header.setPopulationName(batch.populationName);
+
+    message.clear();
+    message.reserve(sizeof(header) + batch.size() * (sizeof(uint64_t) + sizeof(BotPerception)));
+    appendToMessage(message, &header);
+    for (BotBrain *brain : batch.brains)
+    {
+        const uint64_t remoteId = static_cast<RemoteBrain *>(brain)->remoteId;
+        appendToMessage(message, &remoteId);
+    }
+    appendToMessage(message, batch.perceptions.data(), batch.size());
+
+    // Perception has no population of nearest enemy, it is taken from protocol packed for the bot
+    enemyPopulations.clear();
+    populationNames.clear();
+    for (BotBrain *brain : batch.brains)
+    {
+        const auto &enemy = brain->protocolsHolder->updateProtocol.nearestEnemy;
+        uint32_t index = RemotePopulationName::noPopulation;
+        if (enemy)
+        {
+            const std::string enemyPopulation = enemy->populationName();
+            index = 0;
+            while (index < populationNames.size() && populationNames[index].name != enemyPopulation)
+            {
+                index++;
+            }
+            if (index == populationNames.size())
+            {
+                populationNames.emplace_back().set(enemyPopulation);
+            }
+        }
+        enemyPopulations.push_back(index);
+    }
+    const uint32_t namesCount = static_cast<uint32_t>(populationNames.size());
+    appendToMessage(message, enemyPopulations.data(), enemyPopulations.size());
+    appendToMessage(message, &namesCount);
+    appendToMessage(message, populationNames.data(), populationNames.size());
+
+    pending[header.sequence] = PendingRequest{std::chrono::steady_clock::now()};
+    if (!send(workerOf(batch.populationName), message))
+    {
+        pending.erase(header.sequence);
+        return 0;
+    }
+    return header.sequence;
+}
+
+void RemoteBrainHost::receiveBatch(uint64_t sequence, UpdateBatch &batch)
+{
+    // Responces are already reset to DoNothing, so bots just wait if host did not answer
+    auto request = pending.find(sequence);
+    if (sequence == 0 || request == pending.end())
+    {
+        return;
+    }
+    const auto sentAt = request->second.sentAt;
+    if (!connected)
+    {
+        // Host failed after this batch was sent
+        pending.erase(request);
+        return;
+    }
+    if (!receive(workerOf(batch.populationName), sequence, message))
+    {
+        return;
+    }
+
+    const double latencyUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sentAt).count();
+    stats.roundTrips++;
+    stats.bots += batch.size();
+    stats.totalLatencyUs += latencyUs;
+    stats.maxLatencyUs = std::max(stats.maxLatencyUs, latencyUs);
+
+    size_t offset = 0;
+    RemoteMessageHeader header;
+    readFromMessage(message, offset, &header);
+    // Checked before any responce is written, so bots of malformed batch do nothing
+    if (header.count != batch.size() || message.size() != offset + batch.size() * sizeof(RemoteAction))
+    {
+        fail("Brain host answered with wrong number of actions");
+        return;
+    }
+    RemoteAction action;
+    for (size_t i = 0; i < batch.size(); i++)
+    {
+        readFromMessage(message, offset, &action);
+        std::shared_ptr<BotBrain> childBrain;
+        if (action.actionType == BotAction::Spawn)
+        {
+            childBrain = std::make_shared<RemoteBrain>(shared_from_this(), batch.populationName, action.childID);
+        }
+        unpackRemoteAction(action, batch.responces[i], childBrain);
+    }
+}
+
+void RemoteBrainHost::killBrain(const RemoteBrain &brain)
+{
+    if (!connected || brain.remoteId == 0)
+    {
+        return;
+    }
+    RemoteMessageHeader header;
+    header.type = RemoteMessageType::Kill;
+    header.count = 1;
+    header.sequence = nextSequence++;
+    header.setPopulationName(brain.populationName);
+
+    message.clear();
+    appendToMessage(message, &header);
+    appendToMessage(message, &brain.remoteId);
+    send(workerOf(brain.populationName), message);
+}
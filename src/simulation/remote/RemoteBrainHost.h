@@ -0,0 +1,155 @@
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+#include "protocols/brain/BotBrain.h"
+#include "protocols/brain/BrainsRegistry.h"
+#include "remote/RemoteProtocol.h"
+#include "remote/SharedMemoryRing.h"
+
+class RemoteBrainHost;
+
+/// @brief Proxy of brain that lives in brain host process.
+/// Whole population is sent to host as one message per tick (see BotBrain::startBatch()).
+class RemoteBrain : public BotBrain
+{
+private:
+    friend class RemoteBrainHost;
+
+    std::shared_ptr<RemoteBrainHost> host;
+    /// @brief ID of brain in host process. 0 until init() is called, unless brain is a child created by host
+    uint64_t remoteId = 0;
+    /// @brief Sequence of batch sent by startBatch()
+    uint64_t pendingSequence = 0;
+
+public:
+    RemoteBrain(std::shared_ptr<RemoteBrainHost> host_, const std::string &populationName_, uint64_t remoteId_ = 0)
+        : BotBrain(populationName_), host(host_), remoteId(remoteId_) {}
+
+    uint64_t getRemoteId() const { return remoteId; }
+
+    // Host receive only flat perception of bots
+    bool needsVisibleSets() const override { return false; }
+
+    void init(InitProtocol &data, InitProtocolResponce &responce) override;
+    void updateBatch(UpdateBatch &batch) override;
+    bool startBatch(UpdateBatch &batch) override;
+    void finishBatch(UpdateBatch &batch) override;
+    void kill(KillProtocol &data, KillProtocolResponce &responce) override;
+};
+
+/*
+ * Simulation side of out-of-process brains. Start brain host executable (src/tools/brainHost.cpp)
+ * and talk to it through shared memory: every worker thread of host has a pair of
+ * single producer single consumer rings (requests and responces).
+ * Population is always served by the same worker, so its brains keep their state.
+ * Not thread safe: use one host per simulation thread.
+ */
+class RemoteBrainHost : public std::enable_shared_from_this<RemoteBrainHost>
+{
+public:
+    struct Options
+    {
+        /// @brief Path to brain host executable
+        std::string hostExecutable = "./brain_host";
+        /// @brief Number of worker threads in host. Each worker serve whole populations
+        int workers = 1;
+        /// @brief Size of every ring in bytes. Biggest batch is half of it
+        size_t ringCapacity = 16 << 20;
+        /// @brief Time to wait for responce. Bots of batch that timed out do nothing on this tick
+        int timeoutMs = 1000;
+    };
+
+    struct Stats
+    {
+        /// @brief Number of answered batch requests
+        unsigned long roundTrips = 0;
+        /// @brief Number of bots in answered batches
+        unsigned long bots = 0;
+        unsigned long inits = 0;
+        unsigned long timeouts = 0;
+        /// @brief Requests host did not read and malformed responces. Host is disconnected after any of them
+        unsigned long failures = 0;
+        unsigned long long bytesSent = 0;
+        unsigned long long bytesReceived = 0;
+        /// @brief Sum of time from sending batch to receiving its responce in microseconds
+        double totalLatencyUs = 0.0;
+        double maxLatencyUs = 0.0;
+
+        double meanLatencyUs() const { return roundTrips ? totalLatencyUs / roundTrips : 0.0; }
+    };
+
+private:
+    struct Worker
+    {
+        SharedMemoryRing requests;
+        SharedMemoryRing responces;
+        /// @brief Responces received while waiting for other sequence
+        std::map<uint64_t, std::vector<char>> stashed;
+    };
+
+    struct PendingRequest
+    {
+        std::chrono::steady_clock::time_point sentAt;
+    };
+
+    Options options;
+    std::unique_ptr<SharedMemorySegment> memory;
+    RemoteControlBlock *control = nullptr;
+    std::vector<Worker> workers;
+    pid_t hostPid = -1;
+    bool connected = false;
+
+    uint64_t nextSequence = 1;
+    uint64_t nextRemoteId = 1;
+    /// @brief Requests waiting for responce. Responces of other sequences (e.g. timed out) are dropped
+    std::map<uint64_t, PendingRequest> pending;
+
+    std::vector<char> message;
+    /// @brief Population of nearest enemy of every bot of batch being sent, see RemoteMessageType::Batch
+    std::vector<uint32_t> enemyPopulations;
+    std::vector<RemotePopulationName> populationNames;
+    Stats stats;
+
+    RemoteBrainHost(const Options &options_);
+
+    Worker &workerOf(const std::string &populationName);
+    /// @return False if host did not read requests in time, host is disconnected then
+    bool send(Worker &worker, const std::vector<char> &data);
+    /// @brief Wait for responce with given sequence
+    /// @return False on timeout or if host is dead
+    bool receive(Worker &worker, uint64_t sequence, std::vector<char> &responce);
+    void checkHostAlive();
+    /// @brief Count failure and stop talking to host, so remote bots do nothing instead of stopping simulation
+    void fail(const std::string &reason);
+
+public:
+    /// @brief Start brain host process and wait until it is ready
+    static std::shared_ptr<RemoteBrainHost> start(const Options &options);
+
+    RemoteBrainHost(const RemoteBrainHost &) = delete;
+    RemoteBrainHost &operator=(const RemoteBrainHost &) = delete;
+    /// @brief Stop host process and remove shared memory
+    ~RemoteBrainHost();
+
+    /// @brief Create brain of given population that lives in host. Population must be registered in host
+    std::shared_ptr<BotBrain> createBrain(const std::string &populationName);
+    /// @brief Registry that create remote brains of given populations. Pass it to Simulation::initBotClasses()
+    BrainsRegistry makeRegistry(const std::vector<std::string> &populationNames);
+
+    bool isConnected() const { return connected; }
+    const Stats &getStats() const { return stats; }
+
+    // Used by RemoteBrain
+    void initBrain(RemoteBrain &brain, const InitProtocol &data, InitProtocolResponce &responce);
+    uint64_t sendBatch(const UpdateBatch &batch);
+    void receiveBatch(uint64_t sequence, UpdateBatch &batch);
+    void killBrain(const RemoteBrain &brain);
+};
@@ -0,0 +1,359 @@
+#include "remote/RemoteBrainServer.h"
+
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include <unistd.h>
+
+RemoteBrainServer::RemoteBrainServer(const std::string &shmName, const BrainsRegistry &registry_)
+    : memory(shmName, 0, false), registry(registry_), parentPid(getppid())
+{
+    control = static_cast<RemoteControlBlock *>(memory.data());
+    if (memory.getSize() < sizeof(RemoteControlBlock) || control->magic != RemoteControlBlock::magicValue ||
+        memory.getSize() < RemoteControlBlock::requiredSize(control->workers, control->ringCapacity))
+    {
+        throw std::runtime_error("Shared memory " + shmName + " is not created by RemoteBrainHost");
+    }
+}
+
+void RemoteBrainServer::run()
+{
+    std::random_device rd;
+    std::vector<Worker> workers(control->workers);
+    for (uint32_t i = 0; i < control->workers; i++)
+    {
+        workers[i].index = i;
+        workers[i].requests = SharedMemoryRing(control->ringMemory(i, false));
+        workers[i].responces = SharedMemoryRing(control->ringMemory(i, true));
+        workers[i].context = std::make_shared<BrainContext>(rd());
+    }
+
+    std::vector<std::thread> threads;
+    for (auto &worker : workers)
+    {
+        threads.emplace_back([this, &worker]() { serve(worker); });
+    }
+    control->hostReady.store(1, std::memory_order_release);
+
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+bool RemoteBrainServer::shouldStop() const
+{
+    // Stop also if simulation died without asking
+    return control->shutdown.load(std::memory_order_acquire) || getppid() != parentPid;
+}
+
+void RemoteBrainServer::serve(Worker &worker)
+{
+    unsigned int idleRounds = 0;
+    while (true)
+    {
+        if (!worker.requests.tryPop(worker.request))
+        {
+            // Checking parent costs a syscall, so do it only while idle
+            if (idleRounds % 256 == 0 && shouldStop())
+            {
+                return;
+            }
+            remoteBackoff(idleRounds);
+            continue;
+        }
+        idleRounds = 0;
+
+        RemoteMessageHeader header;
+        size_t offset = 0;
+        readFromMessage(worker.request, offset, &header);
+        header.populationName[sizeof(header.populationName) - 1] = '\0';
+
+        try
+        {
+            switch (header.type)
+            {
+            case RemoteMessageType::Init:
+                handleInit(worker, header);
+                break;
+            case RemoteMessageType::Batch:
+                handleBatch(worker, header);
+                break;
+            case RemoteMessageType::Kill:
+                handleKill(worker, header);
+                break;
+            default:
+                std::cerr << "Brain host: unknown message type " << static_cast<uint32_t>(header.type) << "\n";
+                break;
+            }
+        }
+        catch (const std::exception &e)
+        {
+            // Answer anyway, so simulation dont wait for timeout. Bots just do nothing
+            std::cerr << "Brain host: " << e.what() << "\n";
+            if (header.type == RemoteMessageType::Init || header.type == RemoteMessageType::Batch)
+            {
+                const bool isInit = header.type == RemoteMessageType::Init;
+                header.type = isInit ? RemoteMessageType::InitResponce : RemoteMessageType::BatchResponce;
+                worker.responce.clear();
+                appendToMessage(worker.responce, &header);
+                if (isInit)
+                {
+                    const InitProtocolResponce defaults;
+                    const RemoteInitResponce responce{defaults.healthPoints, defaults.foodPoints, defaults.visionPoints,
+                                                      defaults.speedPoints, defaults.attackPoints,
+                                                      defaults.r, defaults.g, defaults.b};
+                    appendToMessage(worker.responce, &responce);
+                }
+                else
+                {
+                    worker.actions.assign(header.count, RemoteAction());
+                    appendToMessage(worker.responce, worker.actions.data(), worker.actions.size());
+                }
+                sendResponce(worker);
+            }
+        }
+    }
+}
+
+void RemoteBrainServer::sendResponce(Worker &worker)
+{
+    unsigned int idleRounds = 0;
+    while (!worker.responces.tryPush(worker.responce.data(), static_cast<uint32_t>(worker.responce.size())))
+    {
+        if (shouldStop())
+        {
+            return;
+        }
+        remoteBackoff(idleRounds);
+    }
+}
+
+void RemoteBrainServer::handleInit(Worker &worker, const RemoteMessageHeader &header)
+{
+    const std::string populationName = header.populationName;
+    RemoteInitRequest request;
+    size_t offset = sizeof(RemoteMessageHeader);
+    readFromMessage(worker.request, offset, &request);
+
+    // Child brain was created by its parent, other brains are created by registry
+    std::shared_ptr<BotBrain> brain;
+    auto &children = worker.children[populationName];
+    auto child = children.find(request.remoteId);
+    if (child != children.end())
+    {
+        brain = child->second;
+        children.erase(child);
+    }
+    else
+    {
+        brain = registry.createBot(populationName, *worker.context);
+    }
+
+    brain->context = worker.context;
+    auto &populationStats = worker.context->populationStats(populationName);
+    populationStats.population++;
+    populationStats.born++;
+
+    brain->protocolsHolder->initProtocol = InitProtocol(Vec2<float>(request.spawnX, request.spawnY), request.evolutionPoints);
+    brain->protocolsHolder->initProtocolResponce = InitProtocolResponce();
+    brain->init(brain->protocolsHolder->initProtocol, brain->protocolsHolder->initProtocolResponce);
+    const auto &initResponce = brain->protocolsHolder->initProtocolResponce;
+
+    RemoteBot &bot = worker.bots[request.remoteId];
+    bot.brain = brain;
+
+    RemoteMessageHeader responceHeader = header;
+    responceHeader.type = RemoteMessageType::InitResponce;
+    const RemoteInitResponce responce{initResponce.healthPoints, initResponce.foodPoints, initResponce.visionPoints,
+                                      initResponce.speedPoints, initResponce.attackPoints,
+                                      initResponce.r, initResponce.g, initResponce.b};
+    worker.responce.clear();
+    appendToMessage(worker.responce, &responceHeader);
+    appendToMessage(worker.responce, &responce);
+    sendResponce(worker);
+}
+
+void RemoteBrainServer::handleBatch(Worker &worker, const RemoteMessageHeader &header)
+{
+    const std::string populationName = header.populationName;
+    const size_t count = header.count;
+
+    size_t offset = sizeof(RemoteMessageHeader);
+    worker.remoteIds.resize(count);
+    worker.perceptions.resize(count);
+    readFromMessage(worker.request, offset, worker.remoteIds.data(), count);
+    readFromMessage(worker.request, offset, worker.perceptions.data(), count);
+    worker.enemyPopulations.resize(count);
+    readFromMessage(worker.request, offset, worker.enemyPopulations.data(), count);
+    uint32_t namesCount = 0;
+    readFromMessage(worker.request, offset, &namesCount);
+    if (namesCount > count)
+    {
+        throw std::runtime_error("Batch has more enemy populations than bots!");
+    }
+    worker.populationNames.resize(namesCount);
+    readFromMessage(worker.request, offset, worker.populationNames.data(), namesCount);
+    for (auto &name : worker.populationNames)
+    {
+        name.name[sizeof(name.name) - 1] = '\0';
+    }
+
+    // Children spawned on the previous tick are already initialized, the rest failed to spawn
+    worker.children[populationName].clear();
+
+    // Like in simulation, brains of different classes are updated in separate batches
+    for (auto &[type, classBatch] : worker.batches)
+    {
+        classBatch.batch.clear();
+        classBatch.rows.clear();
+    }
+    for (size_t row = 0; row < count; row++)
+    {
+        auto bot = worker.bots.find(worker.remoteIds[row]);
+        if (bot == worker.bots.end())
+        {
+            // Brain is unknown (e.g. its Init timed out), bot do nothing
+            continue;
+        }
+        BotBrain *brain = bot->second.brain.get();
+        auto &classBatch = worker.batches[std::type_index(typeid(*brain))];
+        classBatch.batch.populationName = populationName;
+
+        const uint32_t enemyPopulation = worker.enemyPopulations[row];
+        fillProtocol(bot->second, worker.perceptions[row], populationName,
+                     enemyPopulation < namesCount ? worker.populationNames[enemyPopulation].name : "");
+        classBatch.batch.perceptions.push_back(worker.perceptions[row]);
+        classBatch.batch.brains.push_back(brain);
+        classBatch.rows.push_back(row);
+    }
+
+    worker.actions.assign(count, RemoteAction());
+    for (auto &[type, classBatch] : worker.batches)
+    {
+        UpdateBatch &batch = classBatch.batch;
+        if (batch.empty())
+        {
+            continue;
+        }
+        batch.responces.assign(batch.size(), UpdateProtocolResponce());
+        batch.brains.front()->updateBatch(batch);
+
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            const UpdateProtocolResponce &responce = batch.responces[i];
+            RemoteAction &action = worker.actions[classBatch.rows[i]];
+            action = packRemoteAction(responce);
+            if (responce.actionType == BotAction::Spawn)
+            {
+                if (!responce.spawnArgs.brain)
+                {
+                    action = RemoteAction();
+                    continue;
+                }
+                // Top bit separate IDs given by host from IDs given by simulation
+                action.childID = (uint64_t(1) << 63) | (uint64_t(worker.index) << 48) | worker.nextChildId++;
+                worker.children[populationName][action.childID] = responce.spawnArgs.brain;
+            }
+        }
+    }
+
+    RemoteMessageHeader responceHeader = header;
+    responceHeader.type = RemoteMessageType::BatchResponce;
+    worker.responce.clear();
+    appendToMessage(worker.responce, &responceHeader);
+    appendToMessage(worker.responce, worker.actions.data(), count);
+    sendResponce(worker);
+}
+
+void RemoteBrainServer::handleKill(Worker &worker, const RemoteMessageHeader &header)
+{
+    uint64_t remoteId;
+    size_t offset = sizeof(RemoteMessageHeader);
+    readFromMessage(worker.request, offset, &remoteId);
+
+    auto bot = worker.bots.find(remoteId);
+    if (bot == worker.bots.end())
+    {
+        return;
+    }
+    BotBrain &brain = *bot->second.brain;
+    auto &populationStats = worker.context->populationStats(brain.populationName);
+    populationStats.population--;
+    populationStats.death++;
+    brain.kill(brain.protocolsHolder->killProtocol, brain.protocolsHolder->killProtocolResponce);
+    worker.bots.erase(bot);
+}
+
+void RemoteBrainServer::fillProtocol(RemoteBot &bot, const BotPerception &perception, const std::string &populationName,
+                                     const char *enemyPopulationName)
+{
+    UpdateProtocol &data = bot.brain->protocolsHolder->updateProtocol;
+
+    *bot.body = ShadowBotObject(perception.id, perception.pos, perception.radius, perception.health,
+                                perception.food, perception.seeDistance, perception.speed, perception.damage,
+                                perception.maxHealth, perception.maxFood);
+    bot.body->_populationName = populationName;
+    bot.body->_underAttack = perception.underAttack;
+    data.body = bot.body;
+
+    const auto &food = perception.nearestFood;
+    if (food.exists())
+    {
+        *bot.nearestFood = ShadowFoodObject(food.id, perception.pos + food.delta, food.radius, perception.nearestFoodCalories);
+        data.nearestFood = bot.nearestFood;
+    }
+    else
+    {
+        data.nearestFood = nullptr;
+    }
+    data.distanceToNearestFood = food.distance;
+
+    const auto &tree = perception.nearestTree;
+    if (tree.exists())
+    {
+        *bot.nearestTree = ShadowTreeObject(tree.id, perception.pos + tree.delta, tree.radius, 0);
+        data.nearestTree = bot.nearestTree;
+    }
+    else
+    {
+        data.nearestTree = nullptr;
+    }
+    data.distanceToNearestTree = tree.distance;
+
+    const auto &nearestFriend = perception.nearestFriend;
+    if (nearestFriend.exists())
+    {
+        *bot.nearestFriend = ShadowBotObject(nearestFriend.id, perception.pos + nearestFriend.delta, nearestFriend.radius,
+                                             0.0f, 0.0f, 0, 0.0f, 0.0f, 0.0f, 0.0f);
+        bot.nearestFriend->_populationName = populationName;
+        data.nearestFriend = bot.nearestFriend;
+    }
+    else
+    {
+        data.nearestFriend = nullptr;
+    }
+    data.distanceToNearestFriend = nearestFriend.distance;
+
+    const auto &enemy = perception.nearestEnemy;
+    if (enemy.exists())
+    {
+        *bot.nearestEnemy = ShadowBotObject(enemy.id, perception.pos + enemy.delta, enemy.radius,
+                                            perception.nearestEnemyHealth, 0.0f, 0, 0.0f, 0.0f,
+                                            perception.nearestEnemyHealth, 0.0f);
+        bot.nearestEnemy->_populationName = enemyPopulationName;
+        data.nearestEnemy = bot.nearestEnemy;
+    }
+    else
+    {
+        data.nearestEnemy = nullptr;
+    }
+    data.distanceToNearestEnemy = enemy.distance;
+
+    // Nearest bot is the nearer of friend and enemy
+    const bool enemyIsNearer = enemy.exists() && (!nearestFriend.exists() || enemy.distance < nearestFriend.distance);
+    data.nearestBot = enemyIsNearer ? data.nearestEnemy : data.nearestFriend;
+    data.distanceToNearestBot = enemyIsNearer ? enemy.distance : nearestFriend.distance;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+#include "protocols/brain/BotBrain.h"
+#include "protocols/brain/BrainsRegistry.h"
+#include "remote/RemoteProtocol.h"
+#include "remote/SharedMemoryRing.h"
+
+/*
+ * Brain host side of out-of-process brains (see RemoteBrainHost).
+ * Open shared memory created by simulation and serve every pair of rings
+ * with its own thread. Brains are created by given registry and live in the worker
+ * that serve their population. Each worker has its own BrainContext.
+ *
+ * Host receive only BotPerception of bots, so UpdateProtocol of brains is rebuilt from it:
+ * body and nearest food/tree/friend/enemy are filled, visible* sets are empty,
+ * nearest enemy has empty population name and nearest tree has no fruits.
+ */
+class RemoteBrainServer
+{
+private:
+    /// @brief Brain and shadow objects reused every tick to fill its UpdateProtocol
+    struct RemoteBot
+    {
+        std::shared_ptr<BotBrain> brain;
+        std::shared_ptr<ShadowBotObject> body = std::make_shared<ShadowBotObject>();
+        std::shared_ptr<ShadowFoodObject> nearestFood = std::make_shared<ShadowFoodObject>();
+        std::shared_ptr<ShadowTreeObject> nearestTree = std::make_shared<ShadowTreeObject>();
+        std::shared_ptr<ShadowBotObject> nearestFriend = std::make_shared<ShadowBotObject>();
+        std::shared_ptr<ShadowBotObject> nearestEnemy = std::make_shared<ShadowBotObject>();
+    };
+
+    /// @brief Rows of batch that belong to brains of one class
+    struct ClassBatch
+    {
+        UpdateBatch batch;
+        std::vector<size_t> rows;
+    };
+
+    struct Worker
+    {
+        uint32_t index = 0;
+        SharedMemoryRing requests;
+        SharedMemoryRing responces;
+        std::shared_ptr<BrainContext> context;
+        std::unordered_map<uint64_t, RemoteBot> bots;
+        /// @brief Brains of children spawned on the last batch of population, waiting for their Init
+        std::map<std::string, std::unordered_map<uint64_t, std::shared_ptr<BotBrain>>> children;
+        uint64_t nextChildId = 1;
+
+        std::vector<char> request;
+        std::vector<char> responce;
+        std::vector<uint64_t> remoteIds;
+        std::vector<BotPerception> perceptions;
+        std::vector<uint32_t> enemyPopulations;
+        std::vector<RemotePopulationName> populationNames;
+        std::vector<RemoteAction> actions;
+        std::map<std::type_index, ClassBatch> batches;
+    };
+
+    SharedMemorySegment memory;
+    RemoteControlBlock *control = nullptr;
+    const BrainsRegistry &registry;
+    pid_t parentPid;
+
+    void serve(Worker &worker);
+    void handleInit(Worker &worker, const RemoteMessageHeader &header);
+    void handleBatch(Worker &worker, const RemoteMessageHeader &header);
+    void handleKill(Worker &worker, const RemoteMessageHeader &header);
+    void sendResponce(Worker &worker);
+    bool shouldStop() const;
+
+    static void fillProtocol(RemoteBot &bot, const BotPerception &perception, const std::string &populationName,
+                      const char *enemyPopulationName);
+
+public:
+    /// @param shmName Name of shared memory created by RemoteBrainHost
+    /// @param registry_ Registry used to create brains. Must outlive server
+    RemoteBrainServer(const std::string &shmName, const BrainsRegistry &registry_);
+
+    /// @brief Serve requests until simulation ask to stop or exit
+    void run();
+};
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <type_traits>
+#include <stdexcept>
+
+#include "protocols/BatchProtocol.h"
+#include "protocols/UpdateProtocol.h"
+#include "protocols/InitProtocol.h"
+#include "remote/SharedMemoryRing.h"
+
+/*
+ * Messages exchanged between simulation and brain host process (see RemoteBrainHost and RemoteBrainServer).
+ * Every message is RemoteMessageHeader followed by plain arrays, so it can be copied
+ * into shared memory ring without serialization of separate fields.
+ * Both processes are built from the same sources, so layout of structs is the same.
+ */
+
+enum class RemoteMessageType : uint32_t
+{
+    Init = 1,      ///< Simulation -> host: create brain and call init(). Payload: RemoteInitRequest
+    InitResponce,  ///< Host -> simulation. Payload: RemoteInitResponce
+    /// Simulation -> host: decide for population. Payload: uint64_t remoteIds[count], BotPerception[count],
+    /// uint32_t enemyPopulations[count] (index of population name of nearest enemy, noPopulation if there is none),
+    /// uint32_t namesCount, RemotePopulationName names[namesCount]
+    Batch,
+    BatchResponce, ///< Host -> simulation. Payload: RemoteAction[count]
+    Kill,          ///< Simulation -> host: call kill() and forget brain. Payload: uint64_t remoteId. Has no responce
+};
+
+struct RemoteMessageHeader
+{
+    RemoteMessageType type;
+    uint32_t count = 0;
+    /// @brief Responce has the same sequence as its request
+    uint64_t sequence = 0;
+    char populationName[64] = {};
+
+    void setPopulationName(const std::string &name)
+    {
+        if (name.size() >= sizeof(populationName))
+        {
+            throw std::invalid_argument("Population name is too long for remote brain: " + name);
+        }
+        std::memcpy(populationName, name.c_str(), name.size() + 1);
+    }
+};
+
+/// @brief Name of population in message, null-terminated
+struct RemotePopulationName
+{
+    static constexpr uint32_t noPopulation = UINT32_MAX;
+
+    char name[64] = {};
+
+    void set(const std::string &populationName)
+    {
+        if (populationName.size() >= sizeof(name))
+        {
+            throw std::invalid_argument("Population name is too long for remote brain: " + populationName);
+        }
+        std::memcpy(name, populationName.c_str(), populationName.size() + 1);
+    }
+};
+
+struct RemoteInitRequest
+{
+    uint64_t remoteId;
+    int32_t evolutionPoints;
+    float spawnX;
+    float spawnY;
+};
+
+struct RemoteInitResponce
+{
+    int32_t healthPoints;
+    int32_t foodPoints;
+    int32_t visionPoints;
+    int32_t speedPoints;
+    int32_t attackPoints;
+    int32_t r;
+    int32_t g;
+    int32_t b;
+};
+
+/// @brief UpdateProtocolResponce without pointers.
+/// Spawn is always spawn of new bot of the same population, its brain stay in host (see childID)
+struct RemoteAction
+{
+    int32_t actionType = BotAction::DoNothing;
+    /// @brief Move direction or GoTo target
+    float x = 0.0f;
+    float y = 0.0f;
+    float speedMultiplier = 0.0f;
+    uint64_t objectID = 0;
+    int32_t evolutionPoints = -1;
+    uint8_t attackOwnKind = 0;
+    UpdateProtocolResponce::PersistInfo persist;
+    /// @brief Spawn: ID of child brain already created by host. Child is initialized with this ID
+    uint64_t childID = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<BotPerception>, "BotPerception must be trivially copyable to be sent to brain host");
+static_assert(std::is_trivially_copyable_v<RemoteAction>, "RemoteAction must be trivially copyable to be sent to brain host");
+
+inline RemoteAction packRemoteAction(const UpdateProtocolResponce &responce)
+{
+    RemoteAction action;
+    action.actionType = responce.actionType;
+    action.persist = responce.persistArgs;
+    switch (responce.actionType)
+    {
+    case BotAction::Move:
+        action.x = responce.moveArgs.direction.x;
+        action.y = responce.moveArgs.direction.y;
+        action.speedMultiplier = responce.moveArgs.speedMultiplier;
+        break;
+    case BotAction::GoTo:
+        action.x = responce.goToArgs.targetPosition.x;
+        action.y = responce.goToArgs.targetPosition.y;
+        break;
+    case BotAction::EatByID:
+        action.objectID = responce.eatByIDArgs.objectID;
+        break;
+    case BotAction::AttackNearest:
+        action.attackOwnKind = responce.attackNearestArgs.attackOwnKind;
+        break;
+    case BotAction::AttackByID:
+        action.attackOwnKind = responce.attackByIDArgs.attackOwnKind;
+        action.objectID = responce.attackByIDArgs.targetID;
+        break;
+    case BotAction::Spawn:
+        action.evolutionPoints = responce.spawnArgs.evolutionPoints;
+        break;
+    default:
+        break;
+    }
+    return action;
+}
+
+/// @brief Convert action back to responce
+/// @param childBrain Brain of child used if action is Spawn
+inline void unpackRemoteAction(const RemoteAction &action, UpdateProtocolResponce &responce, std::shared_ptr<BotBrain> childBrain)
+{
+    switch (action.actionType)
+    {
+    case BotAction::Move:
+        responce.actionMove(Vec2<float>(action.x, action.y), action.speedMultiplier);
+        break;
+    case BotAction::GoTo:
+        responce.actionGoTo(Vec2<float>(action.x, action.y));
+        break;
+    case BotAction::EatNearest:
+        responce.actionEatNearest();
+        break;
+    case BotAction::EatByID:
+        responce.actionEatByID(action.objectID);
+        break;
+    case BotAction::AttackNearest:
+        responce.actionAttackNearest(action.attackOwnKind);
+        break;
+    case BotAction::AttackByID:
+        responce.actionAttackByID(action.attackOwnKind, action.objectID);
+        break;
+    case BotAction::Spawn:
+        responce.actionSpawn(childBrain, action.evolutionPoints);
+        break;
+    case BotAction::Suicide:
+        responce.actionSuicide();
+        break;
+    default:
+        responce.actionDoNothing();
+        break;
+    }
+    responce.persistArgs = action.persist;
+}
+
+/// @brief Append plain value(s) to message buffer
+template <typename T>
+inline void appendToMessage(std::vector<char> &message, const T *values, size_t count = 1)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    const size_t offset = message.size();
+    message.resize(offset + sizeof(T) * count);
+    std::memcpy(message.data() + offset, values, sizeof(T) * count);
+}
+
+/// @brief Read plain values from message buffer at given offset and move offset
+template <typename T>
+inline void readFromMessage(const std::vector<char> &message, size_t &offset, T *values, size_t count = 1)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (offset + sizeof(T) * count > message.size())
+    {
+        throw std::runtime_error("Remote brain message is truncated!");
+    }
+    std::memcpy(values, message.data() + offset, sizeof(T) * count);
+    offset += sizeof(T) * count;
+}
+
+/// @brief Wait a bit while ring is empty or full: spin first, then yield, then sleep
+/// @param idleRounds Number of previous waits, reset it when ring is ready
+inline void remoteBackoff(unsigned int &idleRounds)
+{
+    if (idleRounds >= 1024)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    else if (idleRounds >= 64)
+    {
+        std::this_thread::yield();
+    }
+    idleRounds++;
+}
+
+/// @brief Layout of shared memory between simulation and brain host.
+/// Control block is followed by pair of rings for each worker: requests (simulation -> host)
+/// and responces (host -> simulation)
+struct RemoteControlBlock
+{
+    static constexpr uint32_t magicValue = 0xB07B2A15;
+
+    uint32_t magic;
+    uint32_t workers;
+    uint64_t ringCapacity;
+    /// @brief Set by host when all workers are started
+    std::atomic<uint32_t> hostReady;
+    /// @brief Set by simulation to stop host
+    std::atomic<uint32_t> shutdown;
+
+    static size_t alignedSize(size_t size) { return (size + 63) & ~size_t(63); }
+
+    static size_t requiredSize(uint32_t workers, uint64_t ringCapacity)
+    {
+        return alignedSize(sizeof(RemoteControlBlock)) + size_t(workers) * 2 * alignedSize(SharedMemoryRing::requiredSize(ringCapacity));
+    }
+
+    /// @brief Memory of ring of given worker
+    /// @param responces False for requests ring, true for responces ring
+    void *ringMemory(uint32_t worker, bool responces)
+    {
+        const size_t ringSize = alignedSize(SharedMemoryRing::requiredSize(ringCapacity));
+        return reinterpret_cast<char *>(this) + alignedSize(sizeof(RemoteControlBlock)) + (size_t(worker) * 2 + (responces ? 1 : 0)) * ringSize;
+    }
+};
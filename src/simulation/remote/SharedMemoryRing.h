@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// @brief Named POSIX shared memory mapped into the process
+class SharedMemorySegment
+{
+private:
+    std::string name;
+    void *memory = nullptr;
+    size_t size = 0;
+    bool owner = false;
+
+public:
+    /// @brief Create new segment (owner = true) or open existing one created by other process
+    /// @param name_ Name of segment, must start with '/'
+    /// @param size_ Size of segment. If 0 when opening, size is taken from existing segment
+    SharedMemorySegment(const std::string &name_, size_t size_, bool create)
+        : name(name_), size(size_), owner(create)
+    {
+        int fd = shm_open(name.c_str(), create ? (O_CREAT | O_EXCL | O_RDWR) : O_RDWR, 0600);
+        if (fd == -1)
+        {
+            throw std::runtime_error("Cant open shared memory " + name + ": " + std::strerror(errno));
+        }
+        if (create && ftruncate(fd, static_cast<off_t>(size)) == -1)
+        {
+            close(fd);
+            shm_unlink(name.c_str());
+            throw std::runtime_error("Cant resize shared memory " + name + ": " + std::strerror(errno));
+        }
+        if (!create)
+        {
+            struct stat info;
+            fstat(fd, &info);
+            size = static_cast<size_t>(info.st_size);
+        }
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory == MAP_FAILED)
+        {
+            if (create)
+            {
+                shm_unlink(name.c_str());
+            }
+            throw std::runtime_error("Cant map shared memory " + name + ": " + std::strerror(errno));
+        }
+    }
+
+    SharedMemorySegment(const SharedMemorySegment &) = delete;
+    SharedMemorySegment &operator=(const SharedMemorySegment &) = delete;
+
+    ~SharedMemorySegment()
+    {
+        munmap(memory, size);
+        if (owner)
+        {
+            shm_unlink(name.c_str());
+        }
+    }
+
+    void *data() const { return memory; }
+    size_t getSize() const { return size; }
+    const std::string &getName() const { return name; }
+};
+
+/// @brief Single producer single consumer queue of variable size messages placed in shared memory.
+/// Producer and consumer can live in different processes. Each message is stored as
+/// [uint32 size][uint32 padding][payload aligned to 8 bytes]; message that doesnt fit before
+/// end of buffer is preceded by wrap marker and written from the beginning.
+class SharedMemoryRing
+{
+public:
+    struct Header
+    {
+        /// @brief Total number of bytes ever written. Changed only by producer
+        alignas(64) std::atomic<uint64_t> head;
+        /// @brief Total number of bytes ever read. Changed only by consumer
+        alignas(64) std::atomic<uint64_t> tail;
+        alignas(64) uint64_t capacity;
+    };
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared memory ring needs lock free 64 bit atomics");
+
+private:
+    static constexpr uint32_t wrapMarker = 0xFFFFFFFFu;
+    static constexpr size_t recordHeaderSize = 8;
+
+    Header *header = nullptr;
+    char *buffer = nullptr;
+    uint64_t capacity = 0;
+
+    static size_t recordSize(size_t payloadSize)
+    {
+        return (recordHeaderSize + payloadSize + 7) & ~size_t(7);
+    }
+
+public:
+    /// @brief Size of memory needed for ring with given capacity
+    static size_t requiredSize(size_t capacity) { return sizeof(Header) + capacity; }
+
+    /// @brief Initialize empty ring in given memory. Must be called once by creator of memory
+    /// @param capacity Size of data buffer, must be multiple of 8
+    static void initialize(void *memory, size_t capacity)
+    {
+        if (capacity % 8 != 0 || capacity < 1024)
+        {
+            throw std::invalid_argument("Ring capacity must be multiple of 8 and at least 1024 bytes!");
+        }
+        Header *header = new (memory) Header();
+        header->head.store(0, std::memory_order_relaxed);
+        header->tail.store(0, std::memory_order_relaxed);
+        header->capacity = capacity;
+    }
+
+    SharedMemoryRing() = default;
+
+    /// @brief Attach to ring initialized with initialize()
+    explicit SharedMemoryRing(void *memory)
+        : header(static_cast<Header *>(memory)),
+          buffer(static_cast<char *>(memory) + sizeof(Header)),
+          capacity(header->capacity)
+    {
+    }
+
+    /// @brief Biggest message that can be pushed
+    size_t maxMessageSize() const { return capacity / 2 - recordHeaderSize; }
+
+    /// @brief Try to add message to the ring
+    /// @return False if there is not enough free space now
+    bool tryPush(const void *data, uint32_t size)
+    {
+        if (size > maxMessageSize())
+        {
+            throw std::invalid_argument("Message is bigger than shared memory ring can hold!");
+        }
+        uint64_t head = header->head.load(std::memory_order_relaxed);
+        const uint64_t tail = header->tail.load(std::memory_order_acquire);
+
+        const size_t record = recordSize(size);
+        size_t offset = head % capacity;
+        const size_t toEnd = capacity - offset;
+        const size_t needed = record + (toEnd < record ? toEnd : 0);
+        if (capacity - (head - tail) < needed)
+        {
+            return false;
+        }
+        if (toEnd < record)
+        {
+            std::memcpy(buffer + offset, &wrapMarker, sizeof(wrapMarker));
+            head += toEnd;
+            offset = 0;
+        }
+        std::memcpy(buffer + offset, &size, sizeof(size));
+        std::memcpy(buffer + offset + recordHeaderSize, data, size);
+        header->head.store(head + record, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Try to take the oldest message from the ring
+    /// @param message Buffer to which message is copied
+    /// @return False if ring is empty
+    bool tryPop(std::vector<char> &message)
+    {
+        uint64_t tail = header->tail.load(std::memory_order_relaxed);
+        const uint64_t head = header->head.load(std::memory_order_acquire);
+        if (tail == head)
+        {
+            return false;
+        }
+        size_t offset = tail % capacity;
+        uint32_t size;
+        std::memcpy(&size, buffer + offset, sizeof(size));
+        if (size == wrapMarker)
+        {
+            tail += capacity - offset;
+            offset = 0;
+            std::memcpy(&size, buffer, sizeof(size));
+        }
+        message.assign(buffer + offset + recordHeaderSize, buffer + offset + recordHeaderSize + size);
+        header->tail.store(tail + recordSize(size), std::memory_order_release);
+        return true;
+    }
+};
@@ -18,6 +18,17 @@ struct MapGenerationSettings
 	bool randomSpawnFood = false;
 	float foodPerChunk = 3;
 	float foodSpawnChance = 0.3f;
+	/// @brief Keep randomly spawned food that no bot can see as calories of its chunk (see FoodField)
+	/// instead of food objects. Food objects are created when bots come near
+	bool foodDensityField = false;
+	/// @brief Ticks without bots near chunk after which its randomly spawned food objects go back to field
+	unsigned int foodFieldReleaseTicks = 50;
+	/// @brief New food that overlaps food already on map is merged into it (calories are summed)
+	/// instead of being a separate object
+	bool mergeFood = false;
+	/// @brief Most food objects in one cell of map (SimulationSizeSettings::unit square). New food of full
+	/// cell is merged into the nearest food of cell. 0 - no limit
+	unsigned int maxFoodPerCell = 0;
 
 	/// @brief Threshold after which tree will be spawned
 	float perlinThreshold = 0.5f;
@@ -28,5 +39,7 @@ struct MapGenerationSettings
 	/// @brief Indicate how rare will be trees
 	/// @example if (RandomValueInRange(0, treeRarety) == 0) { spawTree(); }
 	unsigned int treeRarety = 5;
+	/// @brief How often trees spawn fruits. Food spawn cooldown of trees is divided by it
+	float treeFruitingRate = 1.0f;
 
 };
\ No newline at end of file
@@ -0,0 +1,30 @@
+#pragma once
+
+struct ProfilingSettings
+{
+    bool profileBrains;
+    float brainTimeBudgetUs;
+    bool profileTicks;
+    int profiledTicks;
+    bool profileCounters;
+
+    /// @brief Constructs ProfilingSettings with default or provided values for all members.
+    /// @param profileBrains_ Measure time spent on bots of each population, see BrainProfiler (default: false).
+    /// @param brainTimeBudgetUs_ Maximal time of brain decision for one bot in microseconds.
+    ///                           Bot does nothing if its brain is slower. 0 means no limit (default: 0.0f).
+    /// @param profileTicks_ Record time of every phase of the last ticks, see TickProfiler (default: false).
+    /// @param profiledTicks_ Number of the last ticks kept by tick profiler (default: 240).
+    /// @param profileCounters_ Read hardware counters (cycles, cache and branch misses) around phases
+    ///                         of tick profiler, Linux only (default: false).
+    ProfilingSettings(
+        bool profileBrains_ = false,
+        float brainTimeBudgetUs_ = 0.0f,
+        bool profileTicks_ = false,
+        int profiledTicks_ = 240,
+        bool profileCounters_ = false)
+        : profileBrains(profileBrains_),
+          brainTimeBudgetUs(brainTimeBudgetUs_),
+          profileTicks(profileTicks_),
+          profiledTicks(profiledTicks_),
+          profileCounters(profileCounters_) {}
+};
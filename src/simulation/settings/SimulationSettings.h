@@ -1,16 +1,24 @@
 #pragma once
 
+#include <cstdint>
+
 #include "EvolutionPointsSettings.h"
 #include "SimulationSizeSettings.h"
 #include "MapGenerationSettings.h"
+#include "ProfilingSettings.h"
 
 class SimulationSettings {
 public:
     EvolutionPointsSettings evolutionPointsSettings;
     SimulationSizeSettings simulationSizeSettings;
     MapGenerationSettings mapGenerationSettings;
+    ProfilingSettings profilingSettings;
 
     bool drawGui = false;
 
+    /// @brief Master seed of all random streams of simulation (see RandomService).
+    /// 0 means new seed from std::random_device, Simulation::getRandom().getSeed() tells which one was taken
+    uint64_t seed = 0;
+
     SimulationSettings() = default;
 };
\ No newline at end of file
@@ -1,8 +1,11 @@
 #include "simulation.h"
 
+#include <cmath>
 #include <tuple>
+#include <unordered_set>
 #include <random>
 #include <memory>
+#include <optional>
 
 #include "objects/SimulationObject.h"
 #include "objects/Food.h"
@@ -14,12 +17,17 @@
 
 #include "settings/SimulationSettings.h"
 #include "protocols/brain/BrainsRegistry.h"
+#include "protocols/brain/BrainPluginLoader.h"
+#include "snapshot/ActionLog.h"
+#include "telemetry/Telemetry.h"
 
 #include "utilities/PerlinNoise2D.h"
+#include "utilities/ThreadPool.h"
 
 
 Simulation::Simulation(std::shared_ptr<const SimulationSettings> settings_)
-    : unit(settings_->simulationSizeSettings.unit),
+    : random(settings_->seed != 0 ? settings_->seed : uint64_t(std::random_device()()) << 32 | std::random_device()()),
+      unit(settings_->simulationSizeSettings.unit),
       chunkManager(
           std::make_unique<ChunkManager>(
               settings_->simulationSizeSettings.numberOfChunksX,
@@ -29,32 +37,319 @@ Simulation::Simulation(std::shared_ptr<const SimulationSettings> settings_)
       camera(float(chunkManager->mapWidth), float(chunkManager->mapHeight)),
       settings(settings_)
 {
+    brainContext = std::make_shared<BrainContext>(random.stream(RandomService::BrainContextSeed, 0)());
+    brainProfiler.setEnabled(settings->profilingSettings.profileBrains);
+    brainProfiler.setTimeBudgetUs(settings->profilingSettings.brainTimeBudgetUs);
+    tickProfiler.setCapacity(settings->profilingSettings.profiledTicks);
+    tickProfiler.setEnabled(settings->profilingSettings.profileTicks);
+    tickProfiler.setCountersEnabled(settings->profilingSettings.profileCounters);
+    if (settings->mapGenerationSettings.randomSpawnFood && settings->mapGenerationSettings.foodDensityField)
+    {
+        foodField = std::make_unique<FoodField>(chunkManager->numberOfChunksX, chunkManager->numberOfChunksY);
+    }
 }
 
 void Simulation::update(bool isSimulationRunning)
 {
+    // Paused frames are recorded too, they still have render phases
+    tickProfiler.beginTick();
     if (!isSimulationRunning)
     {
         return;
     }
+    ticks++;
+    const auto tickStart = BrainProfiler::Clock::now();
 
     if (settings->mapGenerationSettings.randomSpawnFood) {
+        TickProfiler::Scope scope(tickProfiler, TickProfiler::FoodGeneration,
+                                  size_t(chunkManager->numberOfChunksX) * chunkManager->numberOfChunksY);
+        if (foodField) {
+            updateFoodField();
+        }
         randomGenerationFood();
     }
 
-    std::vector<std::shared_ptr<SimulationObject>> objects_to_update = objects;
+    // Objects are grouped by type, so time of each type can be measured as one phase.
+    // Order of objects inside one type is kept
+    std::vector<std::shared_ptr<SimulationObject>> food_to_update;
+    std::vector<std::shared_ptr<SimulationObject>> trees_to_update;
+    std::vector<std::shared_ptr<SimulationObject>> others_to_update;
+    std::vector<std::shared_ptr<BotObject>> bots_to_update;
+
+    for (auto &obj : objects)
+    {
+        if (obj == nullptr)
+        {
+            continue;
+        }
+        switch (obj->type())
+        {
+        // Bots are updated in batches after all other objects
+        case SimulationObjectType::BotObject:
+            bots_to_update.push_back(std::static_pointer_cast<BotObject>(obj));
+            break;
+        case SimulationObjectType::FoodObject:
+            food_to_update.push_back(obj);
+            break;
+        case SimulationObjectType::TreeObject:
+            trees_to_update.push_back(obj);
+            break;
+        default:
+            others_to_update.push_back(obj);
+            break;
+        }
+    }
 
-    for (auto &obj : objects_to_update)
+    auto updateObjects = [this](const std::vector<std::shared_ptr<SimulationObject>> &objectsToUpdate, TickProfiler::Phase phase)
     {
-        if (obj != nullptr)
+        TickProfiler::Scope scope(tickProfiler, phase, objectsToUpdate.size());
+        for (auto &obj : objectsToUpdate)
         {
             obj->update();
         }
+    };
+    updateObjects(food_to_update, TickProfiler::FoodUpdate);
+    updateObjects(trees_to_update, TickProfiler::TreeUpdate);
+    updateObjects(others_to_update, TickProfiler::OtherUpdate);
+
+    {
+        TickProfiler::Scope scope(tickProfiler, TickProfiler::Environment, bots_to_update.size());
+        applyChunkEffects(bots_to_update);
+    }
+
+    if (actionReplay)
+    {
+        actionReplay->replayBots(bots_to_update);
+    }
+    else
+    {
+        updateBots(bots_to_update);
+    }
+
+    if (brainProfiler.isEnabled())
+    {
+        brainProfiler.addTick(BrainProfiler::microsecondsSince(tickStart));
     }
 }
 
+void Simulation::updateBots(const std::vector<std::shared_ptr<BotObject>> &bots)
+{
+    using Clock = BrainProfiler::Clock;
+    const bool profiling = brainProfiler.isEnabled();
+    const float timeBudgetUs = brainProfiler.getTimeBudgetUs();
+
+    for (auto &[key, population] : populationBatches)
+    {
+        population.batch.clear();
+        population.bots.clear();
+        population.botIndices.clear();
+        population.brainTimeUs = 0.0f;
+        population.profile = nullptr;
+    }
+    intentBots.clear();
+    intentBotIndices.clear();
+    lastBotUpdateStats = BotUpdateStats();
+    lastBotUpdateStats.bots = static_cast<int>(bots.size());
+
+    // Perception: every bot see the world as it was before any bot acted
+    std::optional<TickProfiler::Scope> phaseScope(std::in_place, tickProfiler, TickProfiler::Perception, bots.size());
+    for (size_t botIndex = 0; botIndex < bots.size(); botIndex++)
+    {
+        auto &bot = bots[botIndex];
+        const auto perceptionStart = profiling ? Clock::now() : Clock::time_point();
+        bot->prepareUpdate();
+
+        // Bots that continue persistent action dont need vision and brain call
+        if (bot->hasActiveIntent())
+        {
+            bot->finishPerception();
+            intentBots.push_back(bot);
+            if (actionRecorder)
+            {
+                intentBotIndices.push_back(uint32_t(botIndex));
+            }
+            if (profiling)
+            {
+                brainProfiler.population(bot->getBrain()->populationName)
+                    .phases[BrainProfiler::Perception]
+                    .add(BrainProfiler::microsecondsSince(perceptionStart));
+            }
+            continue;
+        }
+
+        BotBrain *brain = bot->getBrain().get();
+        auto &population = populationBatches[{brain->populationName, std::type_index(typeid(*brain))}];
+        if (population.batch.empty())
+        {
+            population.batch.populationName = brain->populationName;
+            population.batch.measureCalls = profiling;
+            population.batch.timeBudgetUs = timeBudgetUs;
+            population.profile = profiling ? &brainProfiler.population(brain->populationName) : nullptr;
+        }
+
+        bot->packProtocol(brain->needsVisibleSets());
+
+        population.batch.perceptions.emplace_back();
+        bot->fillPerception(population.batch.perceptions.back());
+        // Attacks of action phase below are perceived on the next tick
+        bot->finishPerception();
+        population.batch.brains.push_back(brain);
+        population.bots.push_back(bot);
+        if (actionRecorder)
+        {
+            population.botIndices.push_back(uint32_t(botIndex));
+        }
+
+        if (population.profile)
+        {
+            population.profile->phases[BrainProfiler::Perception].add(BrainProfiler::microsecondsSince(perceptionStart));
+        }
+    }
+
+    // Time is measured only when profiler is on or there is a budget to check
+    const bool timed = profiling || timeBudgetUs > 0.0f;
+
+    phaseScope.emplace(tickProfiler, TickProfiler::Brain, bots.size());
+
+    // Decision: one brain call per population.
+    // Asynchronous brains (e.g. remote ones) get their batches first, so they think
+    // while local populations are updated
+    for (auto &[key, population] : populationBatches)
+    {
+        population.started = false;
+        if (population.batch.empty())
+        {
+            continue;
+        }
+        population.batch.responces.assign(population.batch.size(), UpdateProtocolResponce());
+        const auto start = timed ? Clock::now() : Clock::time_point();
+        population.started = population.batch.brains.front()->startBatch(population.batch);
+        if (timed)
+        {
+            population.brainTimeUs += BrainProfiler::microsecondsSince(start);
+        }
+    }
+    for (auto &[key, population] : populationBatches)
+    {
+        if (population.batch.empty())
+        {
+            continue;
+        }
+        if (!population.started)
+        {
+            const auto start = timed ? Clock::now() : Clock::time_point();
+            population.batch.brains.front()->updateBatch(population.batch);
+            if (timed)
+            {
+                population.brainTimeUs += BrainProfiler::microsecondsSince(start);
+            }
+        }
+        lastBotUpdateStats.brainCalls += static_cast<int>(population.batch.size());
+        lastBotUpdateStats.batchCalls++;
+    }
+    for (auto &[key, population] : populationBatches)
+    {
+        if (population.batch.empty())
+        {
+            continue;
+        }
+        if (population.started)
+        {
+            const auto start = timed ? Clock::now() : Clock::time_point();
+            population.batch.brains.front()->finishBatch(population.batch);
+            if (timed)
+            {
+                population.brainTimeUs += BrainProfiler::microsecondsSince(start);
+            }
+        }
+        auto &batch = population.batch;
+        // Per-bot adapter check every call itself, for batched brains the budget is shared by whole batch
+        if (timeBudgetUs > 0.0f && !batch.budgetChecked && population.brainTimeUs > timeBudgetUs * batch.size())
+        {
+            batch.responces.assign(batch.size(), UpdateProtocolResponce());
+            batch.overBudget = static_cast<int>(batch.size());
+        }
+        if (population.profile)
+        {
+            auto &brainStats = population.profile->phases[BrainProfiler::Brain];
+            if (batch.callTimesUs.size() == batch.size())
+            {
+                // Adapter measured every bot separately, so percentiles are per call
+                for (float callTimeUs : batch.callTimesUs)
+                {
+                    brainStats.add(callTimeUs);
+                }
+                // Overhead of the batch itself
+                float callsTimeUs = 0.0f;
+                for (float callTimeUs : batch.callTimesUs)
+                {
+                    callsTimeUs += callTimeUs;
+                }
+                brainStats.totalUs += std::max(0.0f, population.brainTimeUs - callsTimeUs);
+            }
+            else
+            {
+                brainStats.add(population.brainTimeUs, batch.size());
+            }
+            population.profile->overBudget += batch.overBudget;
+        }
+    }
+
+    // Action
+    phaseScope.emplace(tickProfiler, TickProfiler::Action, bots.size());
+    for (auto &[key, population] : populationBatches)
+    {
+        for (size_t i = 0; i < population.bots.size(); i++)
+        {
+            const auto start = population.profile ? Clock::now() : Clock::time_point();
+            if (actionRecorder)
+            {
+                actionRecorder->recordAction(population.botIndices[i], population.batch.responces[i]);
+            }
+            population.bots[i]->parseProtocolResponce(population.batch.responces[i]);
+            population.bots[i]->finishUpdate();
+            if (population.profile)
+            {
+                population.profile->phases[BrainProfiler::Action].add(BrainProfiler::microsecondsSince(start));
+            }
+        }
+    }
+    for (size_t i = 0; i < intentBots.size(); i++)
+    {
+        auto &bot = intentBots[i];
+        const auto start = profiling ? Clock::now() : Clock::time_point();
+        if (actionRecorder)
+        {
+            actionRecorder->recordIntent(intentBotIndices[i]);
+        }
+        bot->performIntent();
+        bot->finishUpdate();
+        if (profiling)
+        {
+            brainProfiler.population(bot->getBrain()->populationName)
+                .phases[BrainProfiler::Action]
+                .add(BrainProfiler::microsecondsSince(start));
+        }
+    }
+    lastBotUpdateStats.intentActions = static_cast<int>(intentBots.size());
+}
+
+std::map<std::string, int> Simulation::getPopulationSizes() const
+{
+    std::map<std::string, int> sizes;
+    for (const auto &[populationName, stats] : brainContext->getAllPopulationStats())
+    {
+        sizes[populationName] = stats.population;
+    }
+    return sizes;
+}
+
 void Simulation::afterUpdate()
 {
+    std::optional<TickProfiler::Scope> phaseScope(std::in_place, tickProfiler, TickProfiler::Deaths, deathNote.size());
+    // Dead objects leave object list in one pass, many deaths of one tick (e.g. food absorbed
+    // by FoodField) don't cost a search through the list each
+    std::unordered_set<std::shared_ptr<SimulationObject>> dead;
     while (!deathNote.empty())
     {
         auto &obj = deathNote.front();
@@ -67,26 +362,117 @@ void Simulation::afterUpdate()
             {
                 chunk->removeObject(obj);
             }
-
-            auto it = std::find(objects.begin(), objects.end(), obj);
-            if (it != objects.end())
-            {
-                objects.erase(it);
-            }
+            dead.insert(obj);
         }
         deathNote.pop();
         // log(Logger::LOG, "Object deleted successfully!\n");
     }
+    if (!dead.empty())
+    {
+        objects.erase(std::remove_if(objects.begin(), objects.end(), [&](const std::shared_ptr<SimulationObject> &obj)
+        {
+            if (!obj || !dead.count(obj))
+            {
+                return false;
+            }
+            if (trackDeletedIds)
+            {
+                deletedIds.push_back(obj->id.get());
+            }
+            return true;
+        }), objects.end());
+    }
+    phaseScope.emplace(tickProfiler, TickProfiler::Births, bornQueue.size());
     while (!bornQueue.empty()) {
         auto& bornArgs = bornQueue.front();
         addSmartBot(std::get<0>(bornArgs), std::get<1>(bornArgs), 0.1f, 0.5f, std::get<2>(bornArgs));
+        if (actionRecorder)
+        {
+            // Brain of child already answered init(), so its body can be created without brain on replay
+            actionRecorder->recordBirth(*std::get<0>(bornArgs));
+        }
         bornQueue.pop();
     } 
+    if (actionRecorder)
+    {
+        actionRecorder->endTick();
+    }
+    if (telemetry)
+    {
+        telemetry->afterTick();
+    }
+}
+
+MemoryStats Simulation::collectMemoryStats() const
+{
+    MemoryStats stats;
+    for (const auto &obj : objects)
+    {
+        if (obj)
+        {
+            obj->accountMemory(stats);
+        }
+    }
+
+    for (const auto &chunk : *chunkManager)
+    {
+        stats.add(MemoryStats::ChunkContainers, MemoryStats::sharedObjectBytes<Chunk>() + MemoryStats::hashSetBytes(chunk->objects));
+    }
+
+    // Queue elements are estimated as if they were stored in vector
+    stats.add(MemoryStats::ObjectLists,
+              MemoryStats::vectorBytes(objects) + MemoryStats::vectorBytes(objectsToDraw) +
+              MemoryStats::vectorBytes(intentBots) + MemoryStats::vectorBytes(selectedObjects) +
+              deathNote.size() * sizeof(std::shared_ptr<SimulationObject>) +
+              bornQueue.size() * sizeof(std::tuple<std::shared_ptr<BotBrain>, Vec2<float>, int>),
+              objects.size());
+
+    for (const auto &[key, population] : populationBatches)
+    {
+        const UpdateBatch &batch = population.batch;
+        stats.add(MemoryStats::BatchBuffers,
+                  sizeof(PopulationBatch) + MemoryStats::vectorBytes(batch.perceptions) +
+                  MemoryStats::vectorBytes(batch.responces) + MemoryStats::vectorBytes(batch.brains) +
+                  MemoryStats::vectorBytes(batch.callTimesUs) + MemoryStats::vectorBytes(population.bots));
+    }
+
+    stats.add(MemoryStats::ProfilerBuffers, brainProfiler.memoryBytes() + tickProfiler.memoryBytes(), 2);
+    stats.add(MemoryStats::LoggerBuffer, logger.memoryBytes());
+    if (noiseField)
+    {
+        stats.add(MemoryStats::NoiseFieldCache, sizeof(NoiseField) + noiseField->memoryBytes());
+    }
+    if (foodField)
+    {
+        stats.add(MemoryStats::FoodFieldCells, sizeof(FoodField) + foodField->memoryBytes(), foodField->getChunks());
+    }
+    return stats;
+}
+
+std::vector<MemoryStats::TypeSize> Simulation::getObjectLayout()
+{
+    return {
+        {"SimulationObject", sizeof(SimulationObject)},
+        {"BotObject", sizeof(BotObject)},
+        {"FoodObject", sizeof(FoodObject)},
+        {"TreeObject", sizeof(TreeObject)},
+        {"ShadowSimulationObject", sizeof(ShadowSimulationObject)},
+        {"ShadowBotObject", sizeof(ShadowBotObject)},
+        {"ShadowFoodObject", sizeof(ShadowFoodObject)},
+        {"ShadowTreeObject", sizeof(ShadowTreeObject)},
+        {"ProtocolsHolder", sizeof(ProtocolsHolder)},
+        {"UpdateProtocol", sizeof(UpdateProtocol)},
+        {"UpdateProtocolResponce", sizeof(UpdateProtocolResponce)},
+        {"BotPerception", sizeof(BotPerception)},
+        {"Chunk", sizeof(Chunk)},
+        {"shared_ptr control block", MemoryStats::sharedControlBlockBytes},
+    };
 }
 
 void Simulation::render(ImDrawList *draw_list, ImVec2 window_pos, ImVec2 window_size, bool drawDebugLayer)
 {
 
+    std::optional<TickProfiler::Scope> phaseScope(std::in_place, tickProfiler, TickProfiler::RenderCulling);
     camera.setSize(window_size.x - 20, window_size.y - 40);
     camera.update();
     ImVec2 drawing_delta_pos = ImVec2(window_pos.x - camera.x(), window_pos.y - camera.y());
@@ -155,17 +541,8 @@ void Simulation::render(ImDrawList *draw_list, ImVec2 window_pos, ImVec2 window_
             }
         }
     }
-    // Draw map mesh
-    chunkManager->drawChunksMesh(draw_list, drawing_delta_pos, camera.zoom.get());
-
-    // If chunk is selected, draw it before anything else
-    if (auto validSelectedChunk = selectedChunk.lock())
-    {
-        draw_list->AddRect(toImVec2(Vec2<float>(drawing_delta_pos) + validSelectedChunk->startPos * camera.zoom.get()),
-                           toImVec2(Vec2<float>(drawing_delta_pos) + validSelectedChunk->endPos * camera.zoom.get()), ImColor(colorInt(255, 255, 0, 50)), 0, 0, 2);
-    }
-
-    // Draw objects within visible chunks
+    // Objects within visible chunks
+    objectsToDraw.clear();
     for (int chunkY = startChunkY; chunkY <= endChunkY; ++chunkY)
     {
         for (int chunkX = startChunkX; chunkX <= endChunkX; ++chunkX)
@@ -175,11 +552,31 @@ void Simulation::render(ImDrawList *draw_list, ImVec2 window_pos, ImVec2 window_
             {
                 if (auto validObj = obj.lock())
                 {
-                    validObj->draw(draw_list, drawing_delta_pos, camera.zoom.get());
+                    objectsToDraw.push_back(validObj);
                 }
             }
         }
     }
+    phaseScope->setItems(objectsToDraw.size());
+
+    phaseScope.emplace(tickProfiler, TickProfiler::DrawList, objectsToDraw.size());
+
+    // Draw map mesh
+    chunkManager->drawChunksMesh(draw_list, drawing_delta_pos, camera.zoom.get());
+
+    // If chunk is selected, draw it before anything else
+    if (auto validSelectedChunk = selectedChunk.lock())
+    {
+        draw_list->AddRect(toImVec2(Vec2<float>(drawing_delta_pos) + validSelectedChunk->startPos * camera.zoom.get()),
+                           toImVec2(Vec2<float>(drawing_delta_pos) + validSelectedChunk->endPos * camera.zoom.get()), ImColor(colorInt(255, 255, 0, 50)), 0, 0, 2);
+    }
+
+    // Draw objects within visible chunks
+    for (auto &obj : objectsToDraw)
+    {
+        obj->draw(draw_list, drawing_delta_pos, camera.zoom.get());
+    }
+    objectsToDraw.clear();
 
     // Draw debug layer
     if (drawDebugLayer)
@@ -257,40 +654,122 @@ void Simulation::addObject(SimulationObjectType objectType, std::shared_ptr<Simu
     }
 }
 
-void Simulation::log(Logger::LogType logType, const char *fmt, ...)
+void Simulation::addObjects(const std::vector<std::shared_ptr<SimulationObject>> &newObjects)
 {
-    const char *prefix = "";
-    switch (logType)
+    // Chunks are found before anything is added, so invalid object leaves simulation unchanged
+    std::vector<Chunk *> objectChunks(newObjects.size());
+    std::vector<size_t> addedToChunk(size_t(chunkManager->numberOfChunksX) * chunkManager->numberOfChunksY, 0);
+    for (size_t i = 0; i < newObjects.size(); i++)
     {
-    case Logger::LOG:
-        prefix = "(LOG) ";
-        break;
-    case Logger::WARNING:
-        prefix = "[WARNING] ";
-        break;
-    case Logger::ERROR:
-        prefix = "<ERROR> ";
-        break;
-    default:
-        prefix = ".UNKNOWN. ";
-        break;
+        const auto &obj = newObjects[i];
+        if (obj->pos.x < 0 || obj->pos.y < 0 || obj->pos.x > chunkManager->mapWidth || obj->pos.y > chunkManager->mapHeight)
+        {
+            throw std::invalid_argument("Position of object is out of simualtion map. Pos: " + obj->pos.text());
+        }
+        auto chunk = chunkManager->whatChunkHere(obj->pos);
+        if (!chunk)
+        {
+            throw std::invalid_argument("No chunk found for the given position. Pos: " + obj->pos.text());
+        }
+        objectChunks[i] = chunk.get();
+        addedToChunk[size_t(chunk->yIndex) * chunkManager->numberOfChunksX + chunk->xIndex]++;
     }
 
-    // Create a buffer for the full message (prefix + formatted message)
-    char formattedMessage[512]; // Adjust size as needed
+    for (const auto &chunk : *chunkManager)
+    {
+        if (const size_t added = addedToChunk[size_t(chunk->yIndex) * chunkManager->numberOfChunksX + chunk->xIndex])
+        {
+            chunk->objects.reserve(chunk->objects.size() + added);
+        }
+    }
+    objects.reserve(objects.size() + newObjects.size());
+    for (size_t i = 0; i < newObjects.size(); i++)
+    {
+        objectChunks[i]->addObject(newObjects[i]);
+        newObjects[i]->setID(idManger.getAssignValue());
+        objects.push_back(newObjects[i]);
+    }
+}
 
-    // Format the variadic arguments into a separate buffer
-    char messageBody[512];
+void Simulation::addFood(std::shared_ptr<FoodObject> food)
+{
+    const auto &mapSettings = settings->mapGenerationSettings;
+    auto chunk = (mapSettings.mergeFood || mapSettings.maxFoodPerCell > 0) ? chunkManager->whatChunkHere(food->pos) : nullptr;
+    if (!chunk)
+    {
+        addObject(SimulationObjectType::FoodObject, food);
+        return;
+    }
+
+    // The nearest food that overlaps new one and the nearest food of its cell. Ties go to smaller id,
+    // so result does not depend on order of chunk set
+    const int cellX = int(food->pos.x / unit);
+    const int cellY = int(food->pos.y / unit);
+    const float radius = float(food->getRadius());
+    std::shared_ptr<FoodObject> overlapping, nearestInCell;
+    float overlappingDistance = 0.0f, nearestInCellDistance = 0.0f;
+    unsigned int cellFood = 0;
+    auto isCloser = [](const std::shared_ptr<FoodObject> &candidate, float distance,
+                       const std::shared_ptr<FoodObject> &best, float bestDistance)
+    {
+        return !best || distance < bestDistance || (distance == bestDistance && candidate->id.get() < best->id.get());
+    };
+    for (const auto &weakObject : chunk->objects)
+    {
+        auto obj = weakObject.lock();
+        if (!obj || obj->type() != SimulationObjectType::FoodObject || obj->isMarkedForDeletion())
+        {
+            continue;
+        }
+        auto other = std::static_pointer_cast<FoodObject>(obj);
+        const float distance = other->pos.sqrDistanceTo(food->pos);
+        if (mapSettings.mergeFood)
+        {
+            const float touchDistance = radius + float(other->getRadius());
+            if (distance < touchDistance * touchDistance && isCloser(other, distance, overlapping, overlappingDistance))
+            {
+                overlapping = other;
+                overlappingDistance = distance;
+            }
+        }
+        if (int(other->pos.x / unit) == cellX && int(other->pos.y / unit) == cellY)
+        {
+            cellFood++;
+            if (isCloser(other, distance, nearestInCell, nearestInCellDistance))
+            {
+                nearestInCell = other;
+                nearestInCellDistance = distance;
+            }
+        }
+    }
+
+    if (overlapping)
+    {
+        overlapping->merge(*food);
+        foodMergeStats.merged++;
+    }
+    else if (mapSettings.maxFoodPerCell > 0 && cellFood >= mapSettings.maxFoodPerCell)
+    {
+        nearestInCell->merge(*food);
+        foodMergeStats.capped++;
+    }
+    else
+    {
+        addObject(SimulationObjectType::FoodObject, food);
+    }
+}
+
+void Simulation::log(Logger::LogType logType, const char *fmt, ...)
+{
+    // Message of filtered level is not even formatted
+    if (!logger.isEnabled(logType))
+    {
+        return;
+    }
     va_list args;
     va_start(args, fmt);
-    vsnprintf(messageBody, sizeof(messageBody), fmt, args);
+    logger.addV(logType, fmt, args);
     va_end(args);
-
-    // Combine the prefix with the formatted message
-    snprintf(formattedMessage, sizeof(prefix) + sizeof(formattedMessage), "%s%s", prefix, messageBody);
-
-    // Call AddLog with the combined message
-    logger.AddLog("%s", formattedMessage);
 }
 
 std::shared_ptr<BotObject> Simulation::addSmartBot(std::shared_ptr<BotBrain> brain,
@@ -299,6 +778,11 @@ std::shared_ptr<BotObject> Simulation::addSmartBot(std::shared_ptr<BotBrain> bra
                                                    float startingFoodKoef,
                                                    int evolutionPoints)
 {
+    brain->context = brainContext;
+    auto &populationStats = brainContext->populationStats(brain->populationName);
+    populationStats.population++;
+    populationStats.born++;
+
     brain->protocolsHolder->initProtocol.botSpawnPosition = pos;
     brain->protocolsHolder->initProtocol.evolutionPoints = evolutionPoints == -1 ? settings->evolutionPointsSettings.amountOfPoints : evolutionPoints;
     brain->init(brain->protocolsHolder->initProtocol, brain->protocolsHolder->initProtocolResponce);
@@ -379,53 +863,209 @@ std::shared_ptr<BotObject> Simulation::addSmartBot(std::shared_ptr<BotBrain> bra
 }
 
 void Simulation::randomGenerationFood() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<int> foodCountDist(1, static_cast<int>(settings->mapGenerationSettings.foodPerChunk));
+    const float spawnChance = settings->mapGenerationSettings.foodSpawnChance;
+    if (spawnChance <= 0.0f) { return; }
+    const int maxFoodCount = std::max(1, static_cast<int>(settings->mapGenerationSettings.foodPerChunk));
+    const size_t chunksX = chunkManager->numberOfChunksX;
+    const size_t chunksCount = chunksX * chunkManager->numberOfChunksY;
+    // Every chunk spawns with probability spawnChance, so gaps between spawning chunks are geometric.
+    // Skipping whole gap costs one draw per spawning chunk instead of one per chunk
+    RandomStream chunkRandom = this->random.stream(RandomService::FoodSpawnChunks, 0, ticks);
+    const double logMiss = std::log1p(-double(std::min(spawnChance, 1.0f)));
+    auto nextGap = [&]() -> size_t {
+        if (spawnChance >= 1.0f) { return 0; }
+        const double gap = std::floor(std::log1p(-chunkRandom.uniformDouble()) / logMiss);
+        return gap < double(chunksCount) ? size_t(gap) : chunksCount;
+    };
+    for (size_t chunkIndex = nextGap(); chunkIndex < chunksCount; chunkIndex += 1 + nextGap()) {
+        const auto chunkPtr = chunkManager->getChunk(int(chunkIndex % chunksX), int(chunkIndex / chunksX));
+        // Every chunk has own stream, so chunks dont depend on each other
+        RandomStream random = this->random.stream(RandomService::FoodSpawn, chunkIndex, ticks);
+        int foodCount = random.range(1, maxFoodCount);
+        // No bot can see food of this chunk, so it is kept as calories
+        if (foodField && !foodField->isMaterialised(chunkIndex)) {
+            foodField->deposit(chunkIndex, foodCount * FoodField::foodMaxCalories, foodCount);
+            continue;
+        }
+        for (int i = 0; i < foodCount; ++i) {
+            float x = chunkPtr->startPos.x + random.uniform() * chunkPtr->chunkSize;
+            float y = chunkPtr->startPos.y + random.uniform() * chunkPtr->chunkSize;
+            spawnAmbientFood(Vec2<float>(x, y));
+        }
+    }
+}
 
-    for (const auto& chunkPtr : *chunkManager) {
-        // Determine whether to spawn food in this chunk
-        float chance = static_cast<float>(rand()) / RAND_MAX; // Random value [0.0, 1.0]
+void Simulation::applyChunkEffects(const std::vector<std::shared_ptr<BotObject>> &bots)
+{
+    // Effects are edited in place by GUI, so they are copied every tick. Chunks are read once, not once per bot
+    const int chunksX = chunkManager->numberOfChunksX;
+    const int chunksY = chunkManager->numberOfChunksY;
+    chunkEffects.resize(size_t(chunksX) * chunksY);
+    for (const auto &chunk : *chunkManager)
+    {
+        chunkEffects[size_t(chunk->yIndex) * chunksX + chunk->xIndex] = chunk->getEffects();
+    }
 
-        if (chance > settings->mapGenerationSettings.foodSpawnChance) {
+    const float chunkSize = chunkManager->chunkSize;
+    for (const auto &bot : bots)
+    {
+        // Chunk of bot from its position, the same as ChunkManager::whatChunkHere() gives
+        const int x = std::min(int(std::max(0.0f, bot->pos.x - 1.0f) / chunkSize), chunksX - 1);
+        const int y = std::min(int(std::max(0.0f, bot->pos.y - 1.0f) / chunkSize), chunksY - 1);
+        const ChunkEffects &effects = chunkEffects[size_t(y) * chunksX + x];
+        bot->setEnvironment(effects, maxSeeDistance);
+        if (!effects.hasEvents())
+        {
             continue;
         }
+        // Stream of bot, so events dont depend on order of bots
+        RandomStream random = this->random.stream(RandomService::ChunkEvents, bot->id.get(), ticks);
+        if (random.uniform() < effects.lostLifeChance)
+        {
+            bot->loseLife();
+        }
+        if (random.uniform() < effects.findFoodChance)
+        {
+            bot->findFood();
+        }
+    }
+}
 
-        int foodCount = foodCountDist(gen);
+void Simulation::spawnAmbientFood(Vec2<float> position)
+{
+    auto food = std::make_shared<FoodObject>(
+        shared_from_this(),
+        position,
+        colorInt(100, 0, 0),
+        FoodField::foodMaxCalories,
+        FoodField::foodCalories,
+        FoodField::foodGrowthRate,
+        FoodField::foodDecayRate,
+        false);
+    food->setAmbient(foodField != nullptr);
+    addFood(food);
+}
 
-        for (int i = 0; i < foodCount; ++i) {
-            float x = chunkPtr->startPos.x + static_cast<float>(rand()) / RAND_MAX * chunkPtr->chunkSize;
-            float y = chunkPtr->startPos.y + static_cast<float>(rand()) / RAND_MAX * chunkPtr->chunkSize;
-            Vec2<float> foodPosition(x, y);
-
-            addObject(
-                SimulationObjectType::FoodObject,
-                std::dynamic_pointer_cast<SimulationObject>(
-                    std::make_shared<FoodObject>(
-                        shared_from_this(),
-                        foodPosition,
-                        colorInt(100, 0, 0),
-                        50,                
-                        350,                
-                        0.5f,                
-                        1.0f,                
-                        false                
-                    )
-                )
-            );
+void Simulation::updateFoodField()
+{
+    // Bots see at most maxSeeDistance, chunks out of it are not near
+    const float chunkSize = chunkManager->chunkSize;
+    for (const auto &obj : objects)
+    {
+        if (obj && obj->type() == SimulationObjectType::BotObject)
+        {
+            foodField->markNear(int(std::floor((obj->pos.x - maxSeeDistance) / chunkSize)),
+                                int(std::floor((obj->pos.y - maxSeeDistance) / chunkSize)),
+                                int(std::floor((obj->pos.x + maxSeeDistance) / chunkSize)),
+                                int(std::floor((obj->pos.y + maxSeeDistance) / chunkSize)),
+                                ticks);
+        }
+    }
+
+    foodField->decay();
+    const uint64_t releaseTicks = settings->mapGenerationSettings.foodFieldReleaseTicks;
+    for (const auto &chunk : *chunkManager)
+    {
+        const size_t chunkIndex = foodField->chunkIndex(chunk->xIndex, chunk->yIndex);
+        if (foodField->isNear(chunkIndex, ticks))
+        {
+            if (!foodField->isMaterialised(chunkIndex))
+            {
+                foodField->setMaterialised(chunkIndex, true);
+                RandomStream random = this->random.stream(RandomService::FoodFieldSpawn, chunkIndex, ticks);
+                for (int count = foodField->takeFood(chunkIndex); count > 0; count--)
+                {
+                    const float x = chunk->startPos.x + random.uniform() * chunk->chunkSize;
+                    const float y = chunk->startPos.y + random.uniform() * chunk->chunkSize;
+                    spawnAmbientFood(Vec2<float>(x, y));
+                }
+            }
+        }
+        else if (foodField->isMaterialised(chunkIndex) && foodField->ticksSinceNear(chunkIndex, ticks) >= releaseTicks)
+        {
+            // Food of trees stays, only randomly spawned food goes back to field
+            foodField->setMaterialised(chunkIndex, false);
+            for (const auto &weakObject : chunk->objects)
+            {
+                auto obj = weakObject.lock();
+                if (!obj || obj->type() != SimulationObjectType::FoodObject || obj->isMarkedForDeletion())
+                {
+                    continue;
+                }
+                auto food = std::static_pointer_cast<FoodObject>(obj);
+                if (food->isAmbient())
+                {
+                    foodField->absorb(chunkIndex, food->getCalories());
+                    food->markForDeletion();
+                }
+            }
         }
     }
 }
 
 void Simulation::initBotClasses() {
+    initBotClasses(BrainsRegistry::getInstance());
+}
+
+void Simulation::initBotClasses(const BrainsRegistry& registry) {
+    auto botNames = registry.listRegisteredBots();
+
+    for (const auto& name : botNames) {
+        spawnPopulation([&]() { return registry.createBot(name, *brainContext); });
+    }
+}
+
+int Simulation::replaceBrains(const std::string &populationName, const BrainsRegistry &registry)
+{
+    int replaced = 0;
+    for (auto &obj : objects)
+    {
+        if (!obj || obj->type() != SimulationObjectType::BotObject)
+        {
+            continue;
+        }
+        auto bot = std::static_pointer_cast<BotObject>(obj);
+        auto oldBrain = bot->getBrain();
+        if (oldBrain->populationName != populationName)
+        {
+            continue;
+        }
+
+        auto brain = registry.createBot(populationName, *brainContext);
+        brain->context = brainContext;
+        brain->protocolsHolder->initProtocol = oldBrain->protocolsHolder->initProtocol;
+        // Responce is ignored, brain only prepare its own state
+        brain->init(brain->protocolsHolder->initProtocol, brain->protocolsHolder->initProtocolResponce);
+        bot->setBrainObject(brain);
+        replaced++;
+    }
+    return replaced;
+}
+
+int Simulation::reloadBrainPlugins()
+{
+    if (!brainPlugins)
+    {
+        return 0;
+    }
+    int replaced = 0;
+    for (const auto &populationName : brainPlugins->reloadChanged())
+    {
+        replaced += replaceBrains(populationName, brainPlugins->getRegistry());
+        log(Logger::LOG, "Brain of population %s reloaded\n", populationName.c_str());
+    }
+    return replaced;
+}
+
+void Simulation::spawnPopulation(const std::function<std::shared_ptr<BotBrain>()>& createBrain) {
     if (!settings) {
         log(Logger::ERROR, "Simulation settings are not initialized.");
         return;
     }
 
     const auto& mapSettings = settings->mapGenerationSettings;
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    // Id counter differs for every call, so populations spawned on the same tick get different streams
+    RandomStream random = this->random.stream(RandomService::BotSpawn, idManger.getCurrentIdCounter(), ticks);
 
     // Calculate the map center
     Vec2<float> mapCenter(
@@ -436,12 +1076,11 @@ void Simulation::initBotClasses() {
     // Set spawn radius for circle type to 75% of the smallest map dimension
     float circleRadius = 0.30f * std::min(chunkManager->mapWidth, chunkManager->mapHeight);
 
-    // Distributions for random coordinates
-    std::uniform_int_distribution<int> distX(0, chunkManager->mapWidth - 1);
-    std::uniform_int_distribution<int> distY(0, chunkManager->mapHeight - 1);
-
-    std::uniform_real_distribution<float> angleDist(0.0f, 2.0f * M_PI);
-    std::uniform_real_distribution<float> radiusDist(0.0f, mapSettings.spawnRadius);  // Radius for random spawn
+    // Random coordinates and offsets
+    auto randomX = [&]() { return random.range(0, int(chunkManager->mapWidth) - 1); };
+    auto randomY = [&]() { return random.range(0, int(chunkManager->mapHeight) - 1); };
+    auto randomAngle = [&]() { return random.uniform() * 2.0f * float(M_PI); };
+    auto randomRadius = [&]() { return random.uniform() * mapSettings.spawnRadius; };  // Radius for random spawn
 
     // Lambda to clamp positions to stay within map bounds
     auto clampPosition = [&](const Vec2<float>& pos) {
@@ -451,88 +1090,107 @@ void Simulation::initBotClasses() {
         );
         };
 
-    auto botNames = BrainsRegistry::getInstance().listRegisteredBots();
+    // Only generate random values if spawn type is Random
+    for (unsigned int i = 0; i < mapSettings.numberOfBotsPerPopulation; ++i) {
+        Vec2<float> spawnPos;
 
-    for (const auto& name : botNames) {
-        // Only generate random values if spawn type is Random
-        for (unsigned int i = 0; i < mapSettings.numberOfBotsPerPopulation; ++i) {
-            Vec2<float> spawnPos;
-
-            // Start with the correct spawn type logic
-            switch (mapSettings.spawnType) {
-            case SpawnType::Random: {
-                spawnPos = Vec2<float>(distX(gen), distY(gen));
-                break;
-            }
+        // Start with the correct spawn type logic
+        switch (mapSettings.spawnType) {
+        case SpawnType::Random: {
+            spawnPos = Vec2<float>(randomX(), randomY());
+            break;
+        }
 
-            case SpawnType::Circle: {
-                float angle = angleDist(gen);
-                spawnPos = Vec2<float>(mapCenter.x + circleRadius * std::cos(angle),
-                    mapCenter.y + circleRadius * std::sin(angle));
-                break;
-            }
+        case SpawnType::Circle: {
+            float angle = randomAngle();
+            spawnPos = Vec2<float>(mapCenter.x + circleRadius * std::cos(angle),
+                mapCenter.y + circleRadius * std::sin(angle));
+            break;
+        }
 
-            case SpawnType::OnePlace:
-                // Spawn all bots in one central location (e.g., map center)
-                spawnPos = mapCenter;
-                break;
+        case SpawnType::OnePlace:
+            // Spawn all bots in one central location (e.g., map center)
+            spawnPos = mapCenter;
+            break;
 
-            default:
-                log(Logger::WARNING, "Unknown spawn type. Defaulting to random.");
-                spawnPos = Vec2<float>(distX(gen), distY(gen));
-                break;
-            }
+        default:
+            log(Logger::WARNING, "Unknown spawn type. Defaulting to random.");
+            spawnPos = Vec2<float>(randomX(), randomY());
+            break;
+        }
 
-            // Add additional random offset using spawnRadius
-            float angle = angleDist(gen);
-            float radius = radiusDist(gen);
-            spawnPos += {radius * std::cos(angle), radius * std::sin(angle)};
+        // Add additional random offset using spawnRadius
+        float angle = randomAngle();
+        float radius = randomRadius();
+        spawnPos += {radius * std::cos(angle), radius * std::sin(angle)};
 
-            // Clamp the final spawn position to ensure it's within the map bounds
-            spawnPos = clampPosition(spawnPos);
+        // Clamp the final spawn position to ensure it's within the map bounds
+        spawnPos = clampPosition(spawnPos);
 
-            // Create and add the bot to the simulation
-            addSmartBot(
-                BrainsRegistry::getInstance().createBot(name),
-                spawnPos
-            );
-        }
+        // Create and add the bot to the simulation
+        addSmartBot(
+            createBrain(),
+            spawnPos
+        );
     }
 }
 
+const NoiseField &Simulation::getNoiseField() {
+    if (!noiseField) {
+        const auto &mapSettings = settings->mapGenerationSettings;
+        PerlinNoise2D perlinNoise(this->random.stream(RandomService::TreeGeneration, 0));
+        noiseField = std::make_shared<const NoiseField>(NoiseField::generate(
+            perlinNoise,
+            chunkManager->numberOfChunksX * settings->simulationSizeSettings.unitsPerChunk,
+            chunkManager->numberOfChunksY * settings->simulationSizeSettings.unitsPerChunk,
+            mapSettings.positiveScale, mapSettings.negativeScale));
+    }
+    return *noiseField;
+}
+
 void Simulation::generateTree() {
-    PerlinNoise2D perlinNoise;
-
-    float noiseValue = 0.0f;
-    float upThresholdValue = 0.0f;
-
-    std::random_device rd;
-    std::mt19937 gen;
-    std::uniform_int_distribution<int> spawnChance = std::uniform_int_distribution<int>(0, settings->mapGenerationSettings.treeRarety);
-
-    for (int x = 1; x < chunkManager->numberOfChunksX * settings->simulationSizeSettings.unitsPerChunk - 1; x++) {
-        for (int y = 1; y < chunkManager->numberOfChunksY * settings->simulationSizeSettings.unitsPerChunk - 1; y++) {
-            noiseValue = std::clamp<float>(
-                perlinNoise.getValue(x * settings->mapGenerationSettings.positiveScale, y * settings->mapGenerationSettings.positiveScale)
-                - perlinNoise.getValue(x * settings->mapGenerationSettings.negativeScale, y * settings->mapGenerationSettings.negativeScale),
-                0.0f, 1.0f);
-            if (noiseValue > settings->mapGenerationSettings.perlinThreshold && spawnChance(gen) == 0) {
-                upThresholdValue = noiseValue - settings->mapGenerationSettings.perlinThreshold;
-                addObject(SimulationObjectType::TreeObject,
-                    std::dynamic_pointer_cast<SimulationObject> (
-                        std::make_shared<TreeObject>(
-                            shared_from_this(),
-                            Vec2<float>(x, y) * settings->simulationSizeSettings.unit,
-                            3 + int(3 * upThresholdValue),
-                            100.0f + int(200 * upThresholdValue),
-                            0.5f,
-                            1.5f,
-                            900 - int(450 * upThresholdValue),
-                            false
-                            )
-                        )
-                    );
+    const NoiseField &field = getNoiseField();
+    const float perlinThreshold = settings->mapGenerationSettings.perlinThreshold;
+    const float fruitingRate = std::max(0.001f, settings->mapGenerationSettings.treeFruitingRate);
+    const float unit = settings->simulationSizeSettings.unit;
+
+    // Places are chosen by one stream in row order, so map depends only on seed
+    struct TreePlace {
+        int x;
+        int y;
+        float upThresholdValue;
+    };
+    std::vector<TreePlace> places;
+    RandomStream random = this->random.stream(RandomService::TreeGeneration, 1);
+    const int treeRarety = int(settings->mapGenerationSettings.treeRarety);
+    for (int y = 1; y < field.getHeight() - 1; y++) {
+        const float *row = field.row(y);
+        for (int x = 1; x < field.getWidth() - 1; x++) {
+            if (row[x] > perlinThreshold && random.range(0, treeRarety) == 0) {
+                places.push_back({x, y, row[x] - perlinThreshold});
             }
         }
     }
+
+    // Trees are built by several threads and added to simulation at once
+    std::vector<std::shared_ptr<SimulationObject>> trees(places.size());
+    const auto self = shared_from_this();
+    constexpr size_t treesPerTask = 4096;
+    ThreadPool pool;
+    pool.parallelFor((places.size() + treesPerTask - 1) / treesPerTask, [&](size_t task) {
+        const size_t end = std::min(places.size(), (task + 1) * treesPerTask);
+        for (size_t i = task * treesPerTask; i < end; i++) {
+            const TreePlace &place = places[i];
+            trees[i] = std::make_shared<TreeObject>(
+                self,
+                Vec2<float>(place.x, place.y) * unit,
+                3 + int(3 * place.upThresholdValue),
+                100.0f + int(200 * place.upThresholdValue),
+                0.5f,
+                1.5f,
+                (900 - int(450 * place.upThresholdValue)) / fruitingRate,
+                false);
+        }
+    });
+    addObjects(trees);
 }
\ No newline at end of file
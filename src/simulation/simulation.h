@@ -6,24 +6,30 @@
 #include <algorithm>
 #include <memory>
 #include <tuple>
+#include <map>
+#include <string>
+#include <typeindex>
+#include <functional>
+#include <random>
+#include <cstdint>
 
 #include "imgui.h"
 #include "utilities/utilities.h"
 #include "chunks.h"
+#include "ChunkEffects.h"
 #include "objects/SimulationObject.h"
+#include "objects/SimulationObjectType.h"
 #include "settings/SimulationSettings.h"
+#include "protocols/BatchProtocol.h"
+#include "protocols/brain/BrainContext.h"
+#include "utilities/BrainProfiler.h"
+#include "utilities/TickProfiler.h"
+#include "utilities/MemoryStats.h"
+#include "utilities/RandomService.h"
+#include "utilities/NoiseField.h"
+#include "FoodField.h"
 // #include "protocols/brain/BrainsRegistry.h"
 
-#ifndef SIMULATION_OBJECT_TYPE_ENUM
-#define SIMULATION_OBJECT_TYPE_ENUM
-enum class SimulationObjectType {
-    BaseObject,
-    BotObject,
-    FoodObject,
-    TreeObject,
-};
-#endif
-
 class IDManager;
 class Camera;
 class ChunkManager;
@@ -33,12 +39,24 @@ class FoodObject;
 class TreeObject;
 class BotObject;
 class BotBrain;
+class BrainsRegistry;
+class BrainPluginLoader;
+class ActionRecorder;
+class Telemetry;
+class ActionReplay;
 
 class Simulation;
 
 class Simulation : public std::enable_shared_from_this<Simulation>
 {
 private:
+    friend class WorldSnapshot;
+    friend class WorldImage;
+    friend class DeltaCheckpointer;
+    friend class ActionRecorder;
+    friend class ActionReplay;
+    friend class Telemetry;
+
     std::vector<std::shared_ptr<SimulationObject>> objects;
 
     // std::weak_ptr<SimulationObject> viewInfoObject;
@@ -51,6 +69,94 @@ private:
     std::queue<std::shared_ptr<SimulationObject>> deathNote;
 
     std::queue<std::tuple<std::shared_ptr<BotBrain>, Vec2<float>, int>> bornQueue;
+
+    /// @brief Bots of one population (same population name and brain class) gathered for batched update
+    struct PopulationBatch
+    {
+        UpdateBatch batch;
+        std::vector<std::shared_ptr<BotObject>> bots;
+        /// @brief Position of every bot in list of updated bots. Filled only for action recorder
+        std::vector<uint32_t> botIndices;
+        /// @brief Brain accepted batch with BotBrain::startBatch() and will finish it later
+        bool started = false;
+        /// @brief Time spent in brain calls of this batch on current tick. Measured only if needed
+        float brainTimeUs = 0.0f;
+        /// @brief Profile of population if brain profiler is enabled
+        BrainProfiler::PopulationProfile *profile = nullptr;
+    };
+    // Kept between ticks to reuse allocated memory of batches
+    std::map<std::pair<std::string, std::type_index>, PopulationBatch> populationBatches;
+
+    /// @brief Bots that continue intent on current tick instead of calling brain
+    std::vector<std::shared_ptr<BotObject>> intentBots;
+    std::vector<uint32_t> intentBotIndices;
+
+    /// @brief Number of ticks simulated (paused frames are not counted)
+    unsigned long ticks = 0;
+    /// @brief Ids of objects deleted by afterUpdate(), collected only if trackDeletedIds is set
+    std::vector<unsigned long> deletedIds;
+    bool trackDeletedIds = false;
+
+    /// @brief Writes actions of bots and births of every tick to action log. Set by ActionRecorder itself
+    ActionRecorder *actionRecorder = nullptr;
+    /// @brief Applies recorded actions instead of perception and brains. Set by ActionReplay itself
+    ActionReplay *actionReplay = nullptr;
+    /// @brief Samples metrics after every tick. Set by Telemetry itself
+    Telemetry *telemetry = nullptr;
+
+public:
+    /// @brief Counters of the last Simulation::updateBots() call
+    struct BotUpdateStats
+    {
+        /// @brief Number of updated bots
+        int bots = 0;
+        /// @brief Number of bots decided by brain (rows of all batches)
+        int brainCalls = 0;
+        /// @brief Number of BotBrain::updateBatch() calls
+        int batchCalls = 0;
+        /// @brief Number of bots that repeated persistent action without calling brain
+        int intentActions = 0;
+    };
+
+    /// @brief Food objects not created since start of simulation (see addFood())
+    struct FoodMergeStats
+    {
+        /// @brief New food merged into food it overlapped (MapGenerationSettings::mergeFood)
+        uint64_t merged = 0;
+        /// @brief New food merged into food of its full cell (MapGenerationSettings::maxFoodPerCell)
+        uint64_t capped = 0;
+
+        uint64_t saved() const { return merged + capped; }
+    };
+
+private:
+    BotUpdateStats lastBotUpdateStats;
+    FoodMergeStats foodMergeStats;
+
+    /// @brief Random streams of this simulation. Do not use global rand(), it is shared by all simulations of process
+    RandomService random;
+    /// @brief Noise of map, generated on first use (see getNoiseField())
+    std::shared_ptr<const NoiseField> noiseField;
+    /// @brief Calories of randomly spawned food far from bots, if MapGenerationSettings::foodDensityField is on
+    std::unique_ptr<FoodField> foodField;
+    /// @brief Effects of every chunk, index y * numberOfChunksX + x. Copied from chunks by applyChunkEffects()
+    std::vector<ChunkEffects> chunkEffects;
+
+    /// @brief State shared by brains of this simulation
+    std::shared_ptr<BrainContext> brainContext;
+
+    /// @brief Time spent on bots of each population. Turned on by settings or GUI
+    BrainProfiler brainProfiler;
+    /// @brief Time of each phase of the last ticks. Turned on by settings or GUI
+    TickProfiler tickProfiler;
+    /// @brief Objects of visible chunks collected by render(). Kept to reuse memory
+    std::vector<std::shared_ptr<SimulationObject>> objectsToDraw;
+
+    /// @brief Plugins whose brains can be reloaded between ticks. Can be null
+    std::shared_ptr<BrainPluginLoader> brainPlugins;
+
+    /// @brief Update all given bots: perceive world, call brain once per population, perform actions
+    void updateBots(const std::vector<std::shared_ptr<BotObject>> &bots);
 public:
     IDManager idManger;
     // This property must be first
@@ -86,6 +192,13 @@ public:
     void render(ImDrawList *draw_list, ImVec2 window_pos, ImVec2 window_size, bool drawDebugLayer = true); // definition in simulation.cpp
     
     void addObject(SimulationObjectType type, std::shared_ptr<SimulationObject> obj);
+    /// @brief Add many objects at once. Unlike addObject() objects are not copied, chunks and object list
+    /// grow once and ids are assigned in order of given objects
+    /// @throw std::invalid_argument if some object is outside of map, then nothing is added
+    void addObjects(const std::vector<std::shared_ptr<SimulationObject>> &newObjects);
+    /// @brief Add new food, merging it into food already on map if MapGenerationSettings::mergeFood or
+    /// maxFoodPerCell asks so. Only food of the same chunk is checked
+    void addFood(std::shared_ptr<FoodObject> food);
 
     void selectSingleObject(std::shared_ptr<SimulationObject> objectToSelect);
 
@@ -117,15 +230,18 @@ public:
     /// @param parentWindowTitle Title of logger parent window
     void drawLogger(const char *parentWindowTitle)
     {
-        logger.Draw(parentWindowTitle);
+        logger.draw(parentWindowTitle);
     }
 
-    /// @brief  Output log to simulation logger window
+    /// @brief  Output log to simulation logger window. Thread safe, so parallel workers can log too
     /// @example log(Logger::LOG, "Radius: %i \n ObjectInVision: %i\n", getSeeDistance(), objectsInVision.size());
-    /// @param logType Type of log: LOG, WARNING, ERROR
+    /// @param logType Type of log: LOG, WARNING, ERROR. Types below Logger::getMinLevel() are skipped
     /// @param fmt Formating string
     /// @param `...` Args for formating string
-    void log(Logger::LogType logType, const char *fmt, ...);
+    void log(Logger::LogType logType, const char *fmt, ...) IM_FMTARGS(3);
+
+    /// @brief Log of simulation, e.g. to set minimal level or file sink
+    Logger &getLogger() { return logger; }
 
     std::shared_ptr<std::vector<std::shared_ptr<SimulationObject>>> getObjects()
     {
@@ -148,9 +264,70 @@ public:
         bornQueue.push(bornArgs);
     }
 
+    /// @brief Spawn population of every brain registered in global BrainsRegistry
     void initBotClasses();
 
+    /// @brief Spawn population of every brain registered in given registry
+    void initBotClasses(const BrainsRegistry &registry);
+
+    /// @brief Spawn one population according to map generation settings
+    /// @param createBrain Called once for every spawned bot. Must return new brain of the population
+    void spawnPopulation(const std::function<std::shared_ptr<BotBrain>()> &createBrain);
+
+    std::shared_ptr<BrainContext> getBrainContext() { return brainContext; }
+
+    /// @brief Give brains of living bots of population new brain created by registry.
+    /// New brain get init() with InitProtocol of the old one, but body of bot is kept as it is
+    /// @return Number of bots that got new brain
+    int replaceBrains(const std::string &populationName, const BrainsRegistry &registry);
+
+    void setBrainPlugins(std::shared_ptr<BrainPluginLoader> brainPlugins_) { brainPlugins = brainPlugins_; }
+    std::shared_ptr<BrainPluginLoader> getBrainPlugins() const { return brainPlugins; }
+
+    /// @brief Reload changed brain plugins and replace brains of their living bots.
+    /// Must be called between ticks
+    /// @return Number of bots that got new brain
+    int reloadBrainPlugins();
+
+    /// @brief Get how many bots were decided by brains and how many continued intents on the last tick
+    const BotUpdateStats &getLastBotUpdateStats() const { return lastBotUpdateStats; }
+    const FoodMergeStats &getFoodMergeStats() const { return foodMergeStats; }
+
+    BrainProfiler &getBrainProfiler() { return brainProfiler; }
+    TickProfiler &getTickProfiler() { return tickProfiler; }
+
+    /// @brief Estimate memory used by objects and subsystems of simulation. Walks all objects
+    MemoryStats collectMemoryStats() const;
+    /// @brief Sizes of object, shadow and protocol types, to measure layout changes
+    static std::vector<MemoryStats::TypeSize> getObjectLayout();
+
+    const RandomService &getRandom() const { return random; }
+
+    unsigned long getTicks() const { return ticks; }
+
+    /// @brief Count alive bots of each population
+    /// @return Map from population name to number of its bots in simulation
+    std::map<std::string, int> getPopulationSizes() const;
+
+    /// @brief Noise of every unit cell of map, trees grow where it is above perlinThreshold.
+    /// Generated from seed on first call and kept, so it is the same after snapshot load
+    const NoiseField &getNoiseField();
+
     void generateTree();
 
+    /// @brief Spawn random food in chunks chosen with probability foodSpawnChance. Only chosen chunks are visited
     void randomGenerationFood();
+
+    /// @brief Apply effects of chunks to given bots in one pass: multipliers of see distance, speed and hunger,
+    /// and random events (lost life, found food). Effects are read from flat copy, not from chunk of every bot
+    void applyChunkEffects(const std::vector<std::shared_ptr<BotObject>> &bots);
+
+    /// @brief Food field of simulation, nullptr if MapGenerationSettings::foodDensityField is off
+    const FoodField *getFoodField() const { return foodField.get(); }
+
+private:
+    /// @brief Add food object the same as randomGenerationFood() spawns
+    void spawnAmbientFood(Vec2<float> position);
+    /// @brief Mark chunks near bots, materialise food of chunks bots came to and absorb food of chunks they left
+    void updateFoodField();
 };
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "protocols/UpdateProtocol.h"
+#include "snapshot/BinaryStream.h"
+
+/*
+ * Compact binary form of UpdateProtocolResponce: action type, arguments of this action only
+ * and persistence. Brain of Spawn action is not written (only evolution points),
+ * read responce has null spawnArgs.brain.
+ */
+
+inline void writeResponce(BinaryWriter &writer, const UpdateProtocolResponce &responce)
+{
+    writer.write<uint8_t>(uint8_t(responce.actionType));
+    switch (responce.actionType)
+    {
+    case BotAction::Move:
+        writer.write<float>(responce.moveArgs.direction.x);
+        writer.write<float>(responce.moveArgs.direction.y);
+        writer.write<float>(responce.moveArgs.speedMultiplier);
+        break;
+    case BotAction::GoTo:
+        writer.write<float>(responce.goToArgs.targetPosition.x);
+        writer.write<float>(responce.goToArgs.targetPosition.y);
+        break;
+    case BotAction::EatByID:
+        writer.write<uint64_t>(responce.eatByIDArgs.objectID);
+        break;
+    case BotAction::AttackNearest:
+        writer.write<uint8_t>(responce.attackNearestArgs.attackOwnKind);
+        break;
+    case BotAction::AttackByID:
+        writer.write<uint8_t>(responce.attackByIDArgs.attackOwnKind);
+        writer.write<uint64_t>(responce.attackByIDArgs.targetID);
+        break;
+    case BotAction::Spawn:
+        writer.write<int32_t>(responce.spawnArgs.evolutionPoints);
+        break;
+    default:
+        break;
+    }
+    const auto &persist = responce.persistArgs;
+    writer.write<int32_t>(persist.ticks);
+    writer.write<uint8_t>(uint8_t(persist.untilArrival | persist.untilFull << 1 |
+                                  persist.interruptOnAttack << 2 | persist.interruptOnEnemy << 3));
+}
+
+inline UpdateProtocolResponce readResponce(BinaryReader &reader)
+{
+    UpdateProtocolResponce responce;
+    const uint8_t actionType = reader.read<uint8_t>();
+    if (actionType > BotAction::Suicide)
+    {
+        throw std::runtime_error("Unknown action type in snapshot: " + std::to_string(actionType));
+    }
+    responce.actionType = BotAction(actionType);
+    switch (responce.actionType)
+    {
+    case BotAction::Move:
+        responce.moveArgs.direction.x = reader.read<float>();
+        responce.moveArgs.direction.y = reader.read<float>();
+        responce.moveArgs.speedMultiplier = reader.read<float>();
+        break;
+    case BotAction::GoTo:
+        responce.goToArgs.targetPosition.x = reader.read<float>();
+        responce.goToArgs.targetPosition.y = reader.read<float>();
+        break;
+    case BotAction::EatByID:
+        responce.eatByIDArgs.objectID = reader.read<uint64_t>();
+        break;
+    case BotAction::AttackNearest:
+        responce.attackNearestArgs.attackOwnKind = reader.read<uint8_t>() != 0;
+        break;
+    case BotAction::AttackByID:
+        responce.attackByIDArgs.attackOwnKind = reader.read<uint8_t>() != 0;
+        responce.attackByIDArgs.targetID = reader.read<uint64_t>();
+        break;
+    case BotAction::Spawn:
+        responce.spawnArgs.evolutionPoints = reader.read<int32_t>();
+        break;
+    default:
+        break;
+    }
+    auto &persist = responce.persistArgs;
+    persist.ticks = reader.read<int32_t>();
+    const uint8_t flags = reader.read<uint8_t>();
+    persist.untilArrival = flags & 1;
+    persist.untilFull = flags & 2;
+    persist.interruptOnAttack = flags & 4;
+    persist.interruptOnEnemy = flags & 8;
+    return responce;
+}
@@ -0,0 +1,287 @@
+#include "ActionLog.h"
+
+#include <sstream>
+#include <stdexcept>
+
+#include "simulation.h"
+#include "objects/Bot.h"
+#include "protocols/brain/BotBrain.h"
+#include "protocols/brain/BrainsRegistry.h"
+#include "snapshot/ActionCodec.h"
+#include "snapshot/WorldSnapshot.h"
+
+namespace
+{
+    /// @brief Size of frame header after its size: tick, actions, births, objects and id counter
+    constexpr size_t frameHeaderSize = sizeof(uint64_t) + 4 * sizeof(uint32_t);
+
+    /// @brief Brain of bot born on replay. It answers init() as the real brain did and is never updated
+    class ReplayBrain : public BotBrain
+    {
+    private:
+        InitProtocolResponce recorded;
+
+    public:
+        ReplayBrain(const std::string &populationName_, const InitProtocolResponce &recorded_)
+            : BotBrain(populationName_), recorded(recorded_) {}
+
+        void init(InitProtocol &data, InitProtocolResponce &responce) override
+        {
+            responce = recorded;
+        }
+    };
+}
+
+ActionRecorder::ActionRecorder(std::shared_ptr<Simulation> simulation_, const std::string &path)
+    : simulation(simulation_), file(path, std::ios::binary | std::ios::trunc), writer(&file)
+{
+    if (!file)
+    {
+        throw std::runtime_error("Can't open action log for writing: " + path);
+    }
+    if (simulation->actionRecorder)
+    {
+        throw std::runtime_error("Simulation is already recorded to other action log!");
+    }
+
+    std::ostringstream snapshot;
+    WorldSnapshot::save(*simulation, snapshot);
+    const std::string data = std::move(snapshot).str();
+    writer.write(magic);
+    writer.write(version);
+    writer.write<uint64_t>(data.size());
+    writer.writeArray(data.data(), data.size());
+    writer.flush();
+    stats.snapshotBytes = data.size();
+    stats.bytes = writer.size();
+
+    recordedTick = simulation->ticks;
+    simulation->actionRecorder = this;
+}
+
+ActionRecorder::~ActionRecorder()
+{
+    simulation->actionRecorder = nullptr;
+    try
+    {
+        flush();
+    }
+    catch (const std::exception &)
+    {
+        // Destructor must not throw, log just ends at the last written frame
+    }
+}
+
+void ActionRecorder::recordAction(uint32_t botIndex, const UpdateProtocolResponce &responce)
+{
+    actions.write(botIndex);
+    writeResponce(actions, responce);
+    actionCount++;
+    stats.actions++;
+}
+
+void ActionRecorder::recordIntent(uint32_t botIndex)
+{
+    actions.write(botIndex | intentFlag);
+    actionCount++;
+    stats.intents++;
+}
+
+void ActionRecorder::recordBirth(const BotBrain &brain)
+{
+    births.writeString(brain.populationName);
+    births.write(brain.protocolsHolder->initProtocolResponce);
+    birthCount++;
+    stats.births++;
+}
+
+void ActionRecorder::endTick()
+{
+    if (simulation->ticks == recordedTick)
+    {
+        return;
+    }
+    recordedTick = simulation->ticks;
+
+    const auto &actionData = actions.data();
+    const auto &birthData = births.data();
+    writer.write<uint32_t>(uint32_t(frameHeaderSize + actionData.size() + birthData.size()));
+    writer.write<uint64_t>(simulation->ticks);
+    writer.write(actionCount);
+    writer.write(birthCount);
+    writer.write<uint32_t>(uint32_t(simulation->objects.size()));
+    writer.write<uint32_t>(uint32_t(simulation->idManger.getCurrentIdCounter()));
+    writer.writeArray(actionData.data(), actionData.size());
+    writer.writeArray(birthData.data(), birthData.size());
+    writer.flushIfFull();
+
+    actions.clear();
+    births.clear();
+    actionCount = 0;
+    birthCount = 0;
+    stats.ticks++;
+    stats.bytes = writer.size();
+}
+
+void ActionRecorder::flush()
+{
+    writer.flush();
+    file.flush();
+}
+
+ActionReplay::ActionReplay(const std::string &path, const BrainsRegistry &registry_)
+    : file(path), registry(registry_)
+{
+    BinaryReader reader(file.data(), file.size());
+    if (reader.read<uint32_t>() != ActionRecorder::magic)
+    {
+        throw std::runtime_error(path + " is not an action log!");
+    }
+    if (reader.read<uint32_t>() != ActionRecorder::version)
+    {
+        throw std::runtime_error("Action log " + path + " has unsupported version!");
+    }
+    snapshotSize = size_t(reader.read<uint64_t>());
+    snapshotOffset = reader.position();
+    reader.skip(snapshotSize);
+
+    // Frames are indexed at once, so seek() knows where the log ends
+    while (reader.remaining() >= sizeof(uint32_t))
+    {
+        const size_t offset = reader.position();
+        const uint32_t size = reader.read<uint32_t>();
+        if (size < frameHeaderSize || reader.remaining() < size)
+        {
+            break;
+        }
+        frames.push_back(offset);
+        reader.skip(size);
+    }
+
+    rewind();
+}
+
+ActionReplay::~ActionReplay()
+{
+    if (simulation)
+    {
+        simulation->actionReplay = nullptr;
+    }
+}
+
+void ActionReplay::rewind()
+{
+    if (simulation)
+    {
+        simulation->actionReplay = nullptr;
+    }
+    simulation = WorldSnapshot::load(file.data() + snapshotOffset, snapshotSize, registry);
+    simulation->actionReplay = this;
+    startTick = simulation->ticks;
+    nextFrame = 0;
+}
+
+bool ActionReplay::step()
+{
+    if (nextFrame >= frames.size())
+    {
+        return false;
+    }
+    BinaryReader reader(file.data() + frames[nextFrame], file.size() - frames[nextFrame]);
+    const uint32_t size = reader.read<uint32_t>();
+    const uint64_t tick = reader.read<uint64_t>();
+    actionCount = reader.read<uint32_t>();
+    birthCount = reader.read<uint32_t>();
+    const uint32_t objects = reader.read<uint32_t>();
+    const uint32_t idCounter = reader.read<uint32_t>();
+    // Actions and births are read from the same range, births start where actions end
+    actions = BinaryReader(file.data() + frames[nextFrame] + sizeof(uint32_t) + frameHeaderSize, size - frameHeaderSize);
+    nextFrame++;
+
+    if (tick != simulation->ticks + 1)
+    {
+        diverged("frame of tick " + std::to_string(tick) + " follows tick " + std::to_string(simulation->ticks));
+    }
+    simulation->update(true);
+    replayBirths();
+    simulation->afterUpdate();
+
+    if (simulation->objects.size() != objects)
+    {
+        diverged(std::to_string(simulation->objects.size()) + " objects instead of " + std::to_string(objects));
+    }
+    if (uint32_t(simulation->idManger.getCurrentIdCounter()) != idCounter)
+    {
+        diverged("id counter differs");
+    }
+    return true;
+}
+
+unsigned long ActionReplay::seek(unsigned long tick)
+{
+    if (tick < getTick())
+    {
+        rewind();
+    }
+    while (getTick() < tick && step())
+    {
+    }
+    return getTick();
+}
+
+void ActionReplay::replayBots(const std::vector<std::shared_ptr<BotObject>> &bots)
+{
+    if (actionCount != bots.size())
+    {
+        diverged(std::to_string(bots.size()) + " bots instead of " + std::to_string(actionCount));
+    }
+    // Metabolism and perception of attacks of all bots go before any action, as in Simulation::updateBots()
+    for (auto &bot : bots)
+    {
+        bot->prepareUpdate();
+        bot->finishPerception();
+    }
+    for (uint32_t i = 0; i < actionCount; i++)
+    {
+        const uint32_t entry = actions.read<uint32_t>();
+        const uint32_t botIndex = entry & ~ActionRecorder::intentFlag;
+        if (botIndex >= bots.size())
+        {
+            diverged("action of unknown bot " + std::to_string(botIndex));
+        }
+        auto &bot = bots[botIndex];
+        if (entry & ActionRecorder::intentFlag)
+        {
+            bot->performIntent();
+        }
+        else
+        {
+            bot->parseProtocolResponce(readResponce(actions));
+        }
+        bot->finishUpdate();
+    }
+    births = actions;
+}
+
+void ActionReplay::replayBirths()
+{
+    auto &bornQueue = simulation->bornQueue;
+    if (bornQueue.size() != birthCount)
+    {
+        diverged(std::to_string(bornQueue.size()) + " births instead of " + std::to_string(birthCount));
+    }
+    // Queue is rotated once, so order of births is kept
+    for (uint32_t i = 0; i < birthCount; i++)
+    {
+        auto bornArgs = bornQueue.front();
+        bornQueue.pop();
+        const std::string populationName = births.readString();
+        std::get<0>(bornArgs) = std::make_shared<ReplayBrain>(populationName, births.read<InitProtocolResponce>());
+        bornQueue.push(bornArgs);
+    }
+}
+
+void ActionReplay::diverged(const std::string &reason) const
+{
+    throw std::runtime_error("Replay diverged from action log at tick " + std::to_string(simulation->ticks) + ": " + reason);
+}
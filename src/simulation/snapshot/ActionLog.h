@@ -0,0 +1,144 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "snapshot/BinaryStream.h"
+#include "utilities/MappedFile.h"
+
+class Simulation;
+class BrainsRegistry;
+class BotBrain;
+class BotObject;
+struct UpdateProtocolResponce;
+
+/*
+ * Action log: world at the start of recording (WorldSnapshot, it holds random seed of simulation)
+ * and then one frame per tick with everything brains decided on that tick:
+ * - action of every bot in the order simulation performed them: index of bot among updated bots and
+ *   its responce (see ActionCodec.h), or only index if bot continued its intent;
+ * - population and InitProtocolResponce of every bot born on the tick;
+ * - number of objects and id counter after the tick, to detect divergence.
+ *
+ * Everything else of tick (food generation, food and trees, metabolism, deaths) is computed by
+ * simulation itself, so ActionReplay reaches any recorded tick without perception and brains,
+ * much faster than live simulation. Replay is exact only if world was changed by ticks alone:
+ * edits from GUI are not recorded. Brains are not called on replay, so their own state
+ * (e.g. BrainContext::random()) stays as it was at the start of recording.
+ *
+ * File is append-only, every frame is prefixed by its size; a frame cut by crash is ignored by replay.
+ */
+
+/// @brief Writes action log of simulation. Simulation calls it from Simulation::updateBots() and Simulation::afterUpdate()
+class ActionRecorder
+{
+public:
+    static constexpr uint32_t magic = 0x474F4C41; // "ALOG"
+    static constexpr uint32_t version = 2;
+    /// @brief Set in index of bot that continued its intent, such entry has no responce
+    static constexpr uint32_t intentFlag = 0x80000000u;
+
+    struct Stats
+    {
+        unsigned long ticks = 0;
+        size_t actions = 0;
+        size_t intents = 0;
+        size_t births = 0;
+        /// @brief Size of log, including starting snapshot
+        size_t bytes = 0;
+        size_t snapshotBytes = 0;
+    };
+
+private:
+    std::shared_ptr<Simulation> simulation;
+    std::ofstream file;
+    BinaryWriter writer;
+    /// @brief Actions and births of current tick, written to file at the end of tick
+    BinaryWriter actions;
+    BinaryWriter births;
+    uint32_t actionCount = 0;
+    uint32_t birthCount = 0;
+    unsigned long recordedTick = 0;
+    Stats stats;
+
+public:
+    /// @brief Write snapshot of simulation to new log and start recording. Must be called between ticks
+    /// @throw std::runtime_error if file cant be written
+    ActionRecorder(std::shared_ptr<Simulation> simulation_, const std::string &path);
+    /// @brief Stop recording and flush log
+    ~ActionRecorder();
+
+    ActionRecorder(const ActionRecorder &) = delete;
+    ActionRecorder &operator=(const ActionRecorder &) = delete;
+
+    void recordAction(uint32_t botIndex, const UpdateProtocolResponce &responce);
+    void recordIntent(uint32_t botIndex);
+    /// @brief Remember population and init responce of brain of born bot
+    void recordBirth(const BotBrain &brain);
+    /// @brief Write frame of finished tick. Does nothing on paused frames
+    void endTick();
+
+    /// @brief Write buffered frames to file
+    void flush();
+
+    const Stats &getStats() const { return stats; }
+};
+
+/// @brief Replays action log: loads its starting world and applies recorded ticks to it
+class ActionReplay
+{
+private:
+    friend class Simulation;
+
+    MappedFile file;
+    const BrainsRegistry &registry;
+    std::shared_ptr<Simulation> simulation;
+
+    size_t snapshotOffset = 0;
+    size_t snapshotSize = 0;
+    /// @brief Offset of every complete frame
+    std::vector<size_t> frames;
+    unsigned long startTick = 0;
+    /// @brief Index of the next frame to apply
+    size_t nextFrame = 0;
+
+    /// @brief Actions and births of frame being applied
+    BinaryReader actions{nullptr, 0};
+    BinaryReader births{nullptr, 0};
+    uint32_t actionCount = 0;
+    uint32_t birthCount = 0;
+
+    /// @brief Called by Simulation::update() instead of Simulation::updateBots()
+    void replayBots(const std::vector<std::shared_ptr<BotObject>> &bots);
+    /// @brief Give born bots brains that answer init() with recorded responce
+    void replayBirths();
+    [[noreturn]] void diverged(const std::string &reason) const;
+
+public:
+    /// @param registry Registry that creates brains of bots of starting world. Brains are created, but not called
+    /// @throw std::runtime_error if file is not an action log
+    ActionReplay(const std::string &path, const BrainsRegistry &registry);
+    ~ActionReplay();
+
+    ActionReplay(const ActionReplay &) = delete;
+    ActionReplay &operator=(const ActionReplay &) = delete;
+
+    /// @brief Apply next recorded tick
+    /// @return False if log has no more ticks
+    /// @throw std::runtime_error if simulation does not match the log
+    bool step();
+    /// @brief Reach given tick, going back to the start of log if it is already passed
+    /// @return Reached tick: the given one or the last recorded one
+    unsigned long seek(unsigned long tick);
+    /// @brief Load world at the start of log again
+    void rewind();
+
+    /// @brief Replayed world. It is replaced by rewind() and seek() back
+    std::shared_ptr<Simulation> getSimulation() const { return simulation; }
+    unsigned long getStartTick() const { return startTick; }
+    unsigned long getLastTick() const { return startTick + frames.size(); }
+    unsigned long getTick() const { return startTick + nextFrame; }
+};
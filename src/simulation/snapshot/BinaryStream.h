@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Plain binary encoding used by world snapshots (see WorldSnapshot).
+ * Values are written as they lay in memory, so snapshot can be read only by build
+ * for the same platform (the same assumption as in remote/RemoteProtocol.h).
+ */
+
+class BinaryWriter
+{
+private:
+    std::vector<char> buffer;
+    /// @brief Stream buffer is flushed to. Can be null, then everything stays in buffer
+    std::ostream *out;
+    size_t flushedBytes = 0;
+    /// @brief Index of every object written by writeShared()
+    std::unordered_map<const void *, uint32_t> sharedIndices;
+
+public:
+    static constexpr size_t flushThreshold = 1 << 20;
+
+    explicit BinaryWriter(std::ostream *out_ = nullptr) : out(out_) {}
+
+    template <typename T>
+    void write(const T &value)
+    {
+        writeArray(&value, 1);
+    }
+
+    template <typename T>
+    void writeArray(const T *values, size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const size_t offset = buffer.size();
+        buffer.resize(offset + sizeof(T) * count);
+        std::memcpy(buffer.data() + offset, values, sizeof(T) * count);
+    }
+
+    void writeString(const std::string &text)
+    {
+        write<uint32_t>(uint32_t(text.size()));
+        writeArray(text.data(), text.size());
+    }
+
+    /// @brief Write object shared by several owners (e.g. weights of population) only once.
+    /// The first call with given object writes its index and content (by writeContent(writer)),
+    /// next calls write only the index. Read it with BinaryReader::readShared()
+    template <typename F>
+    void writeShared(const void *object, F &&writeContent)
+    {
+        const auto [it, inserted] = sharedIndices.try_emplace(object, uint32_t(sharedIndices.size()));
+        write<uint32_t>(it->second);
+        write<uint8_t>(inserted);
+        if (inserted)
+        {
+            writeContent(*this);
+        }
+    }
+
+    /// @brief Write placeholder for uint32 value that is known only later (e.g. size of following block)
+    /// @return Position for patch()
+    size_t reserveUint32()
+    {
+        write<uint32_t>(0);
+        return buffer.size() - sizeof(uint32_t);
+    }
+
+    void patch(size_t position, uint32_t value)
+    {
+        std::memcpy(buffer.data() + position, &value, sizeof(value));
+    }
+
+    /// @brief Bytes written since given position (returned by reserveUint32() or position())
+    size_t bytesSince(size_t position) const { return buffer.size() - position; }
+    size_t position() const { return buffer.size(); }
+
+    /// @brief Move buffered data to stream if there is a lot of it.
+    /// Call it only between records, reserved placeholders must be already patched
+    void flushIfFull()
+    {
+        if (out && buffer.size() >= flushThreshold)
+        {
+            flush();
+        }
+    }
+
+    void flush()
+    {
+        if (!out)
+        {
+            return;
+        }
+        out->write(buffer.data(), std::streamsize(buffer.size()));
+        if (!*out)
+        {
+            throw std::runtime_error("Can't write snapshot data!");
+        }
+        flushedBytes += buffer.size();
+        buffer.clear();
+    }
+
+    /// @brief Forget everything written, keeping allocated memory. For writers without stream
+    void clear()
+    {
+        buffer.clear();
+        flushedBytes = 0;
+        sharedIndices.clear();
+    }
+
+    /// @brief Total number of written bytes
+    size_t size() const { return flushedBytes + buffer.size(); }
+    /// @brief Buffered data (all data if writer has no stream)
+    const std::vector<char> &data() const { return buffer; }
+};
+
+class BinaryReader
+{
+private:
+    const char *data;
+    size_t size;
+    size_t offset = 0;
+    /// @brief Objects read by readShared() by their index
+    std::vector<std::shared_ptr<const void>> shared;
+
+public:
+    BinaryReader(const char *data_, size_t size_) : data(data_), size(size_) {}
+
+    template <typename T>
+    T read()
+    {
+        T value;
+        readArray(&value, 1);
+        return value;
+    }
+
+    template <typename T>
+    void read(T &value)
+    {
+        readArray(&value, 1);
+    }
+
+    template <typename T>
+    void readArray(T *values, size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        require(sizeof(T) * count);
+        std::memcpy(values, data + offset, sizeof(T) * count);
+        offset += sizeof(T) * count;
+    }
+
+    std::string readString()
+    {
+        const uint32_t length = read<uint32_t>();
+        require(length);
+        std::string text(data + offset, length);
+        offset += length;
+        return text;
+    }
+
+    /// @brief Read object written by BinaryWriter::writeShared()
+    /// @param readContent Called with reader if object is read for the first time, must return its pointer
+    template <typename T, typename F>
+    std::shared_ptr<T> readShared(F &&readContent)
+    {
+        static_assert(std::is_const_v<T>, "Shared objects are read only");
+        const uint32_t index = read<uint32_t>();
+        if (read<uint8_t>())
+        {
+            if (index != shared.size())
+            {
+                throw std::runtime_error("Snapshot has shared objects out of order!");
+            }
+            shared.push_back(std::shared_ptr<T>(readContent(*this)));
+        }
+        if (index >= shared.size())
+        {
+            throw std::runtime_error("Snapshot refers to unknown shared object!");
+        }
+        return std::static_pointer_cast<T>(shared[index]);
+    }
+
+    /// @brief Throw if less than given number of bytes is left
+    void require(size_t bytes) const
+    {
+        if (bytes > size - offset)
+        {
+            throw std::runtime_error("Snapshot is truncated!");
+        }
+    }
+
+    void skip(size_t bytes)
+    {
+        require(bytes);
+        offset += bytes;
+    }
+
+    size_t position() const { return offset; }
+    size_t remaining() const { return size - offset; }
+};
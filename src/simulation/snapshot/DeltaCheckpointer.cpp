@@ -0,0 +1,376 @@
+#include "DeltaCheckpointer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "simulation.h"
+#include "objects/SimulationObject.h"
+#include "snapshot/WorldSnapshot.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief Written instead of type of object after the last changed object of delta
+    constexpr uint8_t endOfObjects = 0xFF;
+
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+}
+
+DeltaCheckpointer::DeltaCheckpointer(std::shared_ptr<Simulation> simulation_, const Options &options_)
+    : simulation(simulation_), options(options_)
+{
+    if (options.interval < 1 || options.fullEvery < 1 || options.maxPending < 1)
+    {
+        throw std::invalid_argument("Checkpoint interval, fullEvery and maxPending must be positive!");
+    }
+    std::error_code error;
+    std::filesystem::create_directories(options.directory, error);
+    if (error)
+    {
+        throw std::runtime_error("Can't create checkpoint directory " + options.directory + ": " + error.message());
+    }
+
+    simulation->trackDeletedIds = true;
+    simulation->deletedIds.clear();
+    writer = std::thread(&DeltaCheckpointer::writerLoop, this);
+    checkpoint();
+}
+
+DeltaCheckpointer::~DeltaCheckpointer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    pendingChanged.notify_all();
+    writer.join();
+    simulation->trackDeletedIds = false;
+    simulation->deletedIds.clear();
+}
+
+std::string DeltaCheckpointer::checkpointPath(const std::string &directory, int sequence, bool full)
+{
+    char name[64];
+    std::snprintf(name, sizeof(name), "checkpoint_%06d.%s", sequence, full ? "full" : "delta");
+    return (std::filesystem::path(directory) / name).string();
+}
+
+bool DeltaCheckpointer::afterTick()
+{
+    if (simulation->ticks - lastCheckpointTick < static_cast<unsigned long>(options.interval))
+    {
+        return false;
+    }
+    checkpoint();
+    return true;
+}
+
+int DeltaCheckpointer::checkpoint()
+{
+    rethrowWriterError();
+    const auto start = Clock::now();
+    sequence++;
+    const bool full = sequence % options.fullEvery == 0;
+    std::string data = full ? serializeFull() : serializeDelta();
+    lastCheckpointTick = simulation->ticks;
+    if (full)
+    {
+        stats.fullCheckpoints++;
+        stats.fullBytes += data.size();
+    }
+    else
+    {
+        stats.deltaCheckpoints++;
+        stats.deltaBytes += data.size();
+    }
+    stats.serializeSeconds += secondsSince(start);
+
+    enqueue(checkpointPath(options.directory, sequence, full), std::move(data));
+    return sequence;
+}
+
+std::string DeltaCheckpointer::serializeFull()
+{
+    std::ostringstream out;
+    WorldSnapshot::save(*simulation, out);
+    for (auto &object : simulation->objects)
+    {
+        if (object)
+        {
+            object->clearDirty();
+        }
+    }
+    simulation->deletedIds.clear();
+    rememberEffects();
+    return std::move(out).str();
+}
+
+std::string DeltaCheckpointer::serializeDelta()
+{
+    std::ostringstream out;
+    BinaryWriter writer(&out);
+    writer.write(deltaMagic);
+    writer.write(deltaVersion);
+    writer.write<uint32_t>(uint32_t(sequence));
+    writer.write<uint64_t>(simulation->ticks - lastCheckpointTick);
+    WorldSnapshot::writeRuntimeState(writer, *simulation);
+
+    // Chunk effects change rarely (only from GUI), so only changed ones are written
+    std::vector<uint32_t> changedChunks;
+    uint32_t chunkIndex = 0;
+    for (const auto &chunk : *simulation->chunkManager)
+    {
+        const Chunk::Effects effects = chunk->getEffects();
+        if (std::memcmp(&effects, &lastEffects[chunkIndex], sizeof(effects)) != 0)
+        {
+            changedChunks.push_back(chunkIndex);
+            lastEffects[chunkIndex] = effects;
+        }
+        chunkIndex++;
+    }
+    writer.write<uint32_t>(uint32_t(changedChunks.size()));
+    for (uint32_t index : changedChunks)
+    {
+        writer.write(index);
+        writer.write(lastEffects[index]);
+    }
+
+    auto &deletedIds = simulation->deletedIds;
+    writer.write<uint64_t>(deletedIds.size());
+    for (unsigned long id : deletedIds)
+    {
+        writer.write<uint64_t>(id);
+    }
+    deletedIds.clear();
+
+    // Created objects are dirty too. They are at the end of Simulation::objects, so restore appends them in the same order
+    for (auto &object : simulation->objects)
+    {
+        if (object && object->isDirty())
+        {
+            WorldSnapshot::writeObject(writer, *object, WorldSnapshot::chunkIndex(*simulation, *object));
+            object->clearDirty();
+            stats.deltaObjects++;
+            writer.flushIfFull();
+        }
+    }
+    writer.write(endOfObjects);
+    writer.write(deltaMagic);
+    writer.flush();
+    return std::move(out).str();
+}
+
+void DeltaCheckpointer::rememberEffects()
+{
+    lastEffects.clear();
+    for (const auto &chunk : *simulation->chunkManager)
+    {
+        lastEffects.push_back(chunk->getEffects());
+    }
+}
+
+void DeltaCheckpointer::enqueue(std::string path, std::string data)
+{
+    const auto start = Clock::now();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        pendingChanged.wait(lock, [this]() { return pending.size() < options.maxPending; });
+        pending.push_back(PendingFile{std::move(path), std::move(data)});
+    }
+    pendingChanged.notify_all();
+    stats.waitSeconds += secondsSince(start);
+}
+
+void DeltaCheckpointer::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        pendingChanged.wait(lock, [this]() { return stopping || !pending.empty(); });
+        if (pending.empty())
+        {
+            return;
+        }
+        // File stays in queue while it is written, so flush() waits for it. References to
+        // elements of deque stay valid when other elements are pushed back
+        const PendingFile &file = pending.front();
+        lock.unlock();
+        try
+        {
+            const std::string temporaryPath = file.path + ".tmp";
+            {
+                std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+                out.write(file.data.data(), std::streamsize(file.data.size()));
+                if (!out.flush())
+                {
+                    throw std::runtime_error("Can't write checkpoint " + temporaryPath);
+                }
+            }
+            std::filesystem::rename(temporaryPath, file.path);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> errorLock(mutex);
+            if (!writerError)
+            {
+                writerError = std::current_exception();
+            }
+        }
+        lock.lock();
+        pending.pop_front();
+        pendingChanged.notify_all();
+    }
+}
+
+void DeltaCheckpointer::flush()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        pendingChanged.wait(lock, [this]() { return pending.empty(); });
+    }
+    rethrowWriterError();
+}
+
+void DeltaCheckpointer::rethrowWriterError()
+{
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(error, writerError);
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void DeltaCheckpointer::applyDelta(const std::shared_ptr<Simulation> &simulation, const std::string &path,
+                                   int sequence, const BrainsRegistry &registry)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("Checkpoint " + path + " is missing!");
+    }
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    BinaryReader reader(data.data(), data.size());
+    if (reader.read<uint32_t>() != deltaMagic || reader.read<uint32_t>() != deltaVersion ||
+        reader.read<uint32_t>() != uint32_t(sequence))
+    {
+        throw std::runtime_error(path + " is not delta checkpoint " + std::to_string(sequence) + "!");
+    }
+    const uint64_t ticks = reader.read<uint64_t>();
+    WorldSnapshot::readRuntimeState(reader, *simulation);
+
+    auto &chunkManager = *simulation->chunkManager;
+    const uint32_t changedChunks = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < changedChunks; i++)
+    {
+        const uint32_t index = reader.read<uint32_t>();
+        auto chunk = chunkManager.getChunk(index % chunkManager.numberOfChunksX, index / chunkManager.numberOfChunksX);
+        if (!chunk)
+        {
+            throw std::runtime_error(path + " changes unknown chunk " + std::to_string(index));
+        }
+        chunk->setEffects(reader.read<Chunk::Effects>());
+    }
+
+    auto &objects = simulation->objects;
+    std::unordered_map<unsigned long, size_t> positions;
+    positions.reserve(objects.size());
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        if (objects[i])
+        {
+            positions[objects[i]->id.get()] = i;
+        }
+    }
+
+    // Objects created and deleted between checkpoints are unknown here
+    const uint64_t deletedCount = reader.read<uint64_t>();
+    for (uint64_t i = 0; i < deletedCount; i++)
+    {
+        const auto it = positions.find(reader.read<uint64_t>());
+        if (it == positions.end())
+        {
+            continue;
+        }
+        auto &object = objects[it->second];
+        if (auto chunk = object->getChunk())
+        {
+            chunk->removeObject(object);
+        }
+        object = nullptr;
+        positions.erase(it);
+    }
+
+    // Objects that were not changed only lived their own life. Changed ones are replaced right after
+    for (auto &object : objects)
+    {
+        if (object)
+        {
+            object->ageBy(int(ticks));
+        }
+    }
+
+    uint8_t type;
+    while ((type = reader.read<uint8_t>()) != endOfObjects)
+    {
+        std::shared_ptr<Chunk> chunk;
+        auto object = WorldSnapshot::readObject(reader, type, registry, simulation, chunk);
+        const auto it = positions.find(object->id.get());
+        if (it != positions.end())
+        {
+            auto &old = objects[it->second];
+            if (auto oldChunk = old->getChunk())
+            {
+                oldChunk->removeObject(old);
+            }
+            old = object;
+        }
+        else
+        {
+            positions[object->id.get()] = objects.size();
+            objects.push_back(object);
+        }
+        chunk->addObject(object);
+    }
+    if (reader.read<uint32_t>() != deltaMagic)
+    {
+        throw std::runtime_error(path + " has invalid end marker!");
+    }
+
+    objects.erase(std::remove(objects.begin(), objects.end(), nullptr), objects.end());
+}
+
+std::shared_ptr<Simulation> DeltaCheckpointer::restore(const std::string &directory, int sequence, const BrainsRegistry &registry)
+{
+    int base = sequence;
+    while (base >= 0 && !std::filesystem::exists(checkpointPath(directory, base, true)))
+    {
+        base--;
+    }
+    if (base < 0)
+    {
+        throw std::runtime_error("No full checkpoint before checkpoint " + std::to_string(sequence) + " in " + directory);
+    }
+
+    auto simulation = WorldSnapshot::load(checkpointPath(directory, base, true), registry);
+    for (int delta = base + 1; delta <= sequence; delta++)
+    {
+        applyDelta(simulation, checkpointPath(directory, delta, false), delta, registry);
+    }
+    return simulation;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chunks.h"
+
+class Simulation;
+class BrainsRegistry;
+
+/*
+ * Checkpoints of running simulation every N ticks. Most of them are deltas: only objects
+ * created or changed since previous checkpoint (SimulationObject::markDirty(), set by movement,
+ * eating, damage, spawn and edits in GUI), ids of objects deleted by Simulation::afterUpdate(),
+ * changed chunk effects and runtime state (WorldSnapshot::writeRuntimeState()).
+ * Own timers of food and trees dont make them dirty, restore replays them with SimulationObject::ageBy().
+ * Every fullEvery-th checkpoint is full WorldSnapshot.
+ *
+ * Checkpoint is serialised on simulation thread between ticks and written to file by background thread.
+ * Files are written under temporary name and renamed, so directory never has partial checkpoints.
+ * restore() loads the nearest full checkpoint and applies deltas after it.
+ */
+class DeltaCheckpointer
+{
+public:
+    static constexpr uint32_t deltaMagic = 0x41544C44; // "DLTA"
+    static constexpr uint32_t deltaVersion = 2;
+
+    struct Options
+    {
+        /// @brief Directory for checkpoint files. Created if missing
+        std::string directory = "checkpoints";
+        /// @brief Ticks between checkpoints
+        int interval = 100;
+        /// @brief Every fullEvery-th checkpoint is full snapshot, others are deltas
+        int fullEvery = 10;
+        /// @brief Checkpoints waiting for background writer. When limit is reached, simulation thread waits
+        size_t maxPending = 4;
+    };
+
+    struct Stats
+    {
+        int fullCheckpoints = 0;
+        int deltaCheckpoints = 0;
+        size_t fullBytes = 0;
+        size_t deltaBytes = 0;
+        /// @brief Objects written to deltas
+        size_t deltaObjects = 0;
+        /// @brief Time of simulation thread spent on serialisation and waiting for writer
+        double serializeSeconds = 0.0;
+        double waitSeconds = 0.0;
+    };
+
+private:
+    std::shared_ptr<Simulation> simulation;
+    Options options;
+
+    int sequence = -1;
+    unsigned long lastCheckpointTick = 0;
+    /// @brief Chunk effects written by previous checkpoint, to write only changed ones
+    std::vector<Chunk::Effects> lastEffects;
+    Stats stats;
+
+    struct PendingFile
+    {
+        std::string path;
+        std::string data;
+    };
+    std::deque<PendingFile> pending;
+    std::mutex mutex;
+    std::condition_variable pendingChanged;
+    bool stopping = false;
+    std::exception_ptr writerError;
+    std::thread writer;
+
+    void writerLoop();
+    /// @brief Give file to background writer, waiting if it has too much work
+    void enqueue(std::string path, std::string data);
+    void rethrowWriterError();
+
+    std::string serializeFull();
+    std::string serializeDelta();
+    void rememberEffects();
+
+    static void applyDelta(const std::shared_ptr<Simulation> &simulation, const std::string &path,
+                           int sequence, const BrainsRegistry &registry);
+
+public:
+    /// @brief Start tracking changes of simulation and write the first, full checkpoint
+    /// @throw std::runtime_error if directory cant be created
+    DeltaCheckpointer(std::shared_ptr<Simulation> simulation_, const Options &options_);
+    /// @brief Wait for pending checkpoints and stop tracking
+    ~DeltaCheckpointer();
+
+    DeltaCheckpointer(const DeltaCheckpointer &) = delete;
+    DeltaCheckpointer &operator=(const DeltaCheckpointer &) = delete;
+
+    /// @brief Take checkpoint if interval passed since previous one. Call it after Simulation::afterUpdate()
+    /// @return True if checkpoint was taken
+    bool afterTick();
+    /// @brief Take checkpoint now. Must be called between ticks
+    /// @return Sequence number of checkpoint
+    int checkpoint();
+    /// @brief Wait until every taken checkpoint is written
+    /// @throw std::runtime_error if background writer failed
+    void flush();
+
+    int getLastSequence() const { return sequence; }
+    const Stats &getStats() const { return stats; }
+
+    static std::string checkpointPath(const std::string &directory, int sequence, bool full);
+
+    /// @brief Create simulation as it was at given checkpoint
+    /// @throw std::runtime_error if there is no full checkpoint before it or some delta is missing or damaged
+    static std::shared_ptr<Simulation> restore(const std::string &directory, int sequence, const BrainsRegistry &registry);
+};
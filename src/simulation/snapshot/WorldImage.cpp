@@ -0,0 +1,371 @@
+#include "WorldImage.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "simulation.h"
+#include "chunks.h"
+#include "objects/SimulationObject.h"
+#include "objects/Bot.h"
+#include "protocols/brain/BotBrain.h"
+#include "protocols/brain/BrainsRegistry.h"
+#include "utilities/MappedFile.h"
+#include "utilities/ThreadPool.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    constexpr size_t typesCount = 4;
+    constexpr uint8_t botType = uint8_t(SimulationObjectType::BotObject);
+    constexpr uint64_t sectionAlignment = 64;
+
+    struct Section
+    {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+    };
+
+    struct TypeSection
+    {
+        /// @brief Records of objects of this type, stride bytes each
+        uint64_t recordsOffset = 0;
+        /// @brief Position in Simulation::objects of every record, uint32 each
+        uint64_t ordersOffset = 0;
+        uint32_t stride = 0;
+        uint32_t count = 0;
+    };
+
+    struct Header
+    {
+        uint32_t magic = 0;
+        uint32_t version = 0;
+        uint32_t chunksX = 0;
+        uint32_t chunksY = 0;
+        uint64_t objectsCount = 0;
+        Section state;
+        Section chunks;
+        Section brains;
+        TypeSection types[typesCount];
+    };
+
+    struct ChunkRecord
+    {
+        Chunk::Effects effects;
+        /// @brief Range of records of every type that belong to chunk
+        uint32_t first[typesCount];
+        uint32_t count[typesCount];
+    };
+
+    uint64_t align(uint64_t offset)
+    {
+        return (offset + sectionAlignment - 1) / sectionAlignment * sectionAlignment;
+    }
+
+    template <typename T>
+    T readAt(const char *data)
+    {
+        T value;
+        std::memcpy(&value, data, sizeof(T));
+        return value;
+    }
+}
+
+WorldImage::Stats WorldImage::write(const Simulation &simulation, const std::string &path)
+{
+    const auto start = Clock::now();
+    const ChunkManager &chunkManager = *simulation.chunkManager;
+    const size_t chunksCount = size_t(chunkManager.numberOfChunksX) * chunkManager.numberOfChunksY;
+
+    struct Entry
+    {
+        const SimulationObject *object;
+        uint32_t chunk;
+        uint32_t order;
+    };
+    std::array<std::vector<Entry>, typesCount> entries;
+    uint32_t objectsCount = 0;
+    for (const auto &object : simulation.objects)
+    {
+        if (!object)
+        {
+            continue;
+        }
+        const uint8_t type = uint8_t(object->type());
+        if (type >= typesCount)
+        {
+            throw std::runtime_error("Object type " + std::to_string(type) + " can't be written to world image!");
+        }
+        entries[type].push_back(Entry{object.get(), WorldSnapshot::chunkIndex(simulation, *object), objectsCount++});
+    }
+
+    std::vector<ChunkRecord> chunkTable(chunksCount);
+    size_t chunkNumber = 0;
+    for (const auto &chunk : chunkManager)
+    {
+        chunkTable[chunkNumber++].effects = chunk->getEffects();
+    }
+
+    Header header;
+    header.magic = magic;
+    header.version = version;
+    header.chunksX = uint32_t(chunkManager.numberOfChunksX);
+    header.chunksY = uint32_t(chunkManager.numberOfChunksY);
+    header.objectsCount = objectsCount;
+
+    BinaryWriter state;
+    WorldSnapshot::writeWorldState(state, simulation);
+    BinaryWriter brains;
+    std::array<std::vector<char>, typesCount> records;
+    std::array<std::vector<uint32_t>, typesCount> orders;
+    for (size_t type = 0; type < typesCount; type++)
+    {
+        auto &typeEntries = entries[type];
+        // Stable, so objects of chunk keep their order
+        std::stable_sort(typeEntries.begin(), typeEntries.end(),
+                         [](const Entry &a, const Entry &b) { return a.chunk < b.chunk; });
+
+        BinaryWriter states;
+        std::vector<size_t> offsets;
+        offsets.reserve(typeEntries.size() + 1);
+        for (const Entry &entry : typeEntries)
+        {
+            offsets.push_back(states.position());
+            entry.object->saveState(states);
+            orders[type].push_back(entry.order);
+            chunkTable[entry.chunk].count[type]++;
+            if (type == botType)
+            {
+                WorldSnapshot::writeBrain(brains, *static_cast<const BotObject *>(entry.object)->getBrain());
+            }
+        }
+        offsets.push_back(states.position());
+
+        size_t stride = 0;
+        for (size_t i = 0; i + 1 < offsets.size(); i++)
+        {
+            stride = std::max(stride, offsets[i + 1] - offsets[i]);
+        }
+        stride = (stride + 7) / 8 * 8;
+        records[type].assign(stride * typeEntries.size(), 0);
+        for (size_t i = 0; i + 1 < offsets.size(); i++)
+        {
+            std::memcpy(records[type].data() + i * stride, states.data().data() + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+        header.types[type].stride = uint32_t(stride);
+        header.types[type].count = uint32_t(typeEntries.size());
+
+        uint32_t first = 0;
+        for (auto &chunk : chunkTable)
+        {
+            chunk.first[type] = first;
+            first += chunk.count[type];
+        }
+    }
+
+    // Layout of file
+    uint64_t offset = align(sizeof(Header));
+    header.state = Section{offset, state.size()};
+    offset = align(offset + header.state.size);
+    header.chunks = Section{offset, sizeof(ChunkRecord) * chunksCount};
+    offset = align(offset + header.chunks.size);
+    for (size_t type = 0; type < typesCount; type++)
+    {
+        header.types[type].recordsOffset = offset;
+        offset = align(offset + records[type].size());
+        header.types[type].ordersOffset = offset;
+        offset = align(offset + orders[type].size() * sizeof(uint32_t));
+    }
+    header.brains = Section{offset, brains.size()};
+    const uint64_t fileSize = offset + header.brains.size;
+
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        throw std::runtime_error("Can't open world image file for writing: " + path);
+    }
+    uint64_t written = 0;
+    auto writeAt = [&](uint64_t position, const void *data, size_t size)
+    {
+        static const char zeros[sectionAlignment] = {};
+        out.write(zeros, std::streamsize(position - written));
+        out.write(static_cast<const char *>(data), std::streamsize(size));
+        written = position + size;
+    };
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.state.offset, state.data().data(), state.data().size());
+    writeAt(header.chunks.offset, chunkTable.data(), header.chunks.size);
+    for (size_t type = 0; type < typesCount; type++)
+    {
+        writeAt(header.types[type].recordsOffset, records[type].data(), records[type].size());
+        writeAt(header.types[type].ordersOffset, orders[type].data(), orders[type].size() * sizeof(uint32_t));
+    }
+    writeAt(header.brains.offset, brains.data().data(), brains.data().size());
+    if (!out.flush())
+    {
+        throw std::runtime_error("Can't write world image file: " + path);
+    }
+
+    return Stats{objectsCount, size_t(fileSize), std::chrono::duration<double>(Clock::now() - start).count()};
+}
+
+std::shared_ptr<Simulation> WorldImage::load(const std::string &path, const BrainsRegistry &registry, size_t threads, Stats *stats)
+{
+    const auto start = Clock::now();
+    MappedFile file(path);
+    file.prefetch();
+    const char *data = file.data();
+
+    if (file.size() < sizeof(Header) || readAt<uint32_t>(data) != magic)
+    {
+        throw std::runtime_error(path + " is not a world image!");
+    }
+    const Header header = readAt<Header>(data);
+    if (header.version != version)
+    {
+        throw std::runtime_error("Unsupported world image version " + std::to_string(header.version));
+    }
+    auto inFile = [&](uint64_t offset, uint64_t size) { return offset <= file.size() && size <= file.size() - offset; };
+    bool valid = inFile(header.state.offset, header.state.size) && inFile(header.chunks.offset, header.chunks.size) &&
+                 inFile(header.brains.offset, header.brains.size);
+    uint64_t recordsCount = 0;
+    for (const TypeSection &type : header.types)
+    {
+        valid = valid && inFile(type.recordsOffset, uint64_t(type.stride) * type.count) &&
+                inFile(type.ordersOffset, uint64_t(type.count) * sizeof(uint32_t)) && (type.stride > 0 || type.count == 0);
+        recordsCount += type.count;
+    }
+    if (!valid || recordsCount != header.objectsCount)
+    {
+        throw std::runtime_error("World image " + path + " is damaged!");
+    }
+
+    BinaryReader stateReader(data + header.state.offset, header.state.size);
+    auto simulation = WorldSnapshot::readWorldState(stateReader);
+    auto &chunkManager = *simulation->chunkManager;
+    const size_t chunksCount = size_t(chunkManager.numberOfChunksX) * chunkManager.numberOfChunksY;
+    if (header.chunksX != uint32_t(chunkManager.numberOfChunksX) || header.chunksY != uint32_t(chunkManager.numberOfChunksY) ||
+        header.chunks.size != sizeof(ChunkRecord) * chunksCount)
+    {
+        throw std::runtime_error("Chunks of world image " + path + " dont match its settings!");
+    }
+
+    // Chunk table must cover every array of records without gaps, orders must be permutation of objects
+    std::vector<ChunkRecord> chunkTable(chunksCount);
+    std::memcpy(chunkTable.data(), data + header.chunks.offset, header.chunks.size);
+    for (size_t type = 0; type < typesCount; type++)
+    {
+        uint64_t first = 0;
+        for (const ChunkRecord &chunk : chunkTable)
+        {
+            valid = valid && chunk.first[type] == first;
+            first += chunk.count[type];
+        }
+        valid = valid && first == header.types[type].count;
+    }
+    std::vector<uint8_t> placed(header.objectsCount, 0);
+    for (const TypeSection &type : header.types)
+    {
+        for (uint32_t record = 0; record < type.count && valid; record++)
+        {
+            const uint32_t order = readAt<uint32_t>(data + type.ordersOffset + record * sizeof(uint32_t));
+            valid = order < header.objectsCount && !placed[order];
+            placed[order] = valid;
+        }
+    }
+    if (!valid)
+    {
+        throw std::runtime_error("World image " + path + " has invalid object tables!");
+    }
+
+    size_t chunkNumber = 0;
+    for (const auto &chunk : chunkManager)
+    {
+        const ChunkRecord &record = chunkTable[chunkNumber++];
+        chunk->setEffects(record.effects);
+        uint32_t objectsInChunk = 0;
+        for (size_t type = 0; type < typesCount; type++)
+        {
+            objectsInChunk += record.count[type];
+        }
+        chunk->objects.reserve(objectsInChunk);
+    }
+
+    simulation->objects.resize(header.objectsCount);
+    auto buildObject = [&](uint8_t type, uint32_t record, const std::shared_ptr<Chunk> &chunk, const std::shared_ptr<BotBrain> &brain)
+    {
+        const TypeSection &section = header.types[type];
+        auto object = WorldSnapshot::createObject(type, simulation, brain);
+        BinaryReader recordReader(data + section.recordsOffset + uint64_t(record) * section.stride, section.stride);
+        object->loadState(recordReader);
+        chunk->addObject(object);
+        simulation->objects[readAt<uint32_t>(data + section.ordersOffset + record * sizeof(uint32_t))] = object;
+    };
+    auto chunkAt = [&](size_t index)
+    {
+        return chunkManager.getChunk(int(index % chunkManager.numberOfChunksX), int(index / chunkManager.numberOfChunksX));
+    };
+
+    // Brains are created by registry and may share population state, so bots are built in order
+    BinaryReader brainsReader(data + header.brains.offset, header.brains.size);
+    for (size_t index = 0; index < chunksCount; index++)
+    {
+        const ChunkRecord &chunkRecord = chunkTable[index];
+        const auto chunk = chunkAt(index);
+        for (uint32_t record = chunkRecord.first[botType]; record < chunkRecord.first[botType] + chunkRecord.count[botType]; record++)
+        {
+            buildObject(botType, record, chunk, WorldSnapshot::readBrain(brainsReader, registry, *simulation));
+        }
+    }
+    if (brainsReader.remaining() != 0)
+    {
+        throw std::runtime_error("World image " + path + " has unread brain data!");
+    }
+
+    // Other objects by blocks of chunks
+    auto buildChunks = [&](size_t firstChunk, size_t lastChunk)
+    {
+        for (size_t index = firstChunk; index < lastChunk; index++)
+        {
+            const ChunkRecord &chunkRecord = chunkTable[index];
+            const auto chunk = chunkAt(index);
+            for (uint8_t type = 0; type < typesCount; type++)
+            {
+                if (type == botType)
+                {
+                    continue;
+                }
+                for (uint32_t record = chunkRecord.first[type]; record < chunkRecord.first[type] + chunkRecord.count[type]; record++)
+                {
+                    buildObject(type, record, chunk, nullptr);
+                }
+            }
+        }
+    };
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threads == 1)
+    {
+        buildChunks(0, chunksCount);
+    }
+    else
+    {
+        ThreadPool pool(threads);
+        // Several blocks per worker to even out dense and empty parts of map
+        const size_t blocks = std::min(chunksCount, threads * 8);
+        pool.parallelFor(blocks, [&](size_t block)
+                         { buildChunks(block * chunksCount / blocks, (block + 1) * chunksCount / blocks); });
+    }
+
+    if (stats)
+    {
+        *stats = Stats{size_t(header.objectsCount), file.size(), std::chrono::duration<double>(Clock::now() - start).count()};
+    }
+    return simulation;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "snapshot/WorldSnapshot.h"
+
+class Simulation;
+class BrainsRegistry;
+
+/*
+ * Prepared world in form that is mapped to memory instead of parsed, for fast startup
+ * of big worlds (WorldSnapshot is streaming form for checkpoints).
+ *
+ * Layout, every section is aligned to 64 bytes and all offsets are relative to start of file,
+ * so image doesn't depend on address it is mapped at:
+ * - header with offsets of sections;
+ * - world state: settings, id counter, random seed and generator of brains, population stats;
+ * - chunk table: effects of every chunk and range of its records of every object type;
+ * - for every object type flat array of fixed size records (SimulationObject::saveState() padded
+ *   to the longest one) sorted by chunk, and position of every record in Simulation::objects;
+ * - brains of bots in order of bot records.
+ *
+ * File is mapped read-only and private (see MappedFile), records are read in place.
+ * Bots are built in order, because brains may share state; food, trees and other objects are built
+ * by workers, each of them owns whole chunks, so sets of chunks are filled without locks.
+ * The same rules as for WorldSnapshot apply: save between ticks, load only by the same build.
+ */
+class WorldImage
+{
+public:
+    static constexpr uint32_t magic = 0x474D4957; // "WIMG"
+    static constexpr uint32_t version = 5;
+
+    using Stats = WorldSnapshot::Stats;
+
+    /// @throw std::runtime_error if file cant be written
+    static Stats write(const Simulation &simulation, const std::string &path);
+
+    /// @brief Create new simulation from world image
+    /// @param registry Registry that creates brains by population name
+    /// @param threads Number of workers that build objects. If 0, use number of hardware threads
+    /// @throw std::runtime_error if file is not a valid world image
+    static std::shared_ptr<Simulation> load(const std::string &path, const BrainsRegistry &registry,
+                                            size_t threads = 0, Stats *stats = nullptr);
+};
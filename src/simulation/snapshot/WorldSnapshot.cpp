@@ -0,0 +1,388 @@
+#include "WorldSnapshot.h"
+
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include "simulation.h"
+#include "chunks.h"
+#include "objects/SimulationObject.h"
+#include "objects/Food.h"
+#include "objects/Tree.h"
+#include "objects/Bot.h"
+#include "protocols/brain/BotBrain.h"
+#include "protocols/brain/BrainsRegistry.h"
+#include "settings/SimulationSettings.h"
+#include "snapshot/ActionCodec.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    /// @brief Settings structs are written as they are, with size to detect changed layout
+    template <typename T>
+    void writeStruct(BinaryWriter &writer, const T &value)
+    {
+        writer.write<uint32_t>(sizeof(T));
+        writer.write(value);
+    }
+
+    template <typename T>
+    void readStruct(BinaryReader &reader, T &value, const char *name)
+    {
+        if (reader.read<uint32_t>() != sizeof(T))
+        {
+            throw std::runtime_error(std::string("Snapshot has different layout of ") + name + "!");
+        }
+        reader.read(value);
+    }
+
+    /// @brief Text state of standard random generator
+    template <typename Generator>
+    std::string generatorState(const Generator &generator)
+    {
+        std::ostringstream state;
+        state << generator;
+        return state.str();
+    }
+
+    template <typename Generator>
+    void restoreGenerator(Generator &generator, const std::string &state)
+    {
+        std::istringstream in(state);
+        in >> generator;
+        if (!in)
+        {
+            throw std::runtime_error("Snapshot has invalid state of random generator!");
+        }
+    }
+}
+
+void WorldSnapshot::writeSettings(BinaryWriter &writer, const SimulationSettings &settings)
+{
+    writeStruct(writer, settings.evolutionPointsSettings);
+    writeStruct(writer, settings.simulationSizeSettings);
+    writeStruct(writer, settings.mapGenerationSettings);
+    writeStruct(writer, settings.profilingSettings);
+    writer.write<uint8_t>(settings.drawGui);
+    writer.write<uint64_t>(settings.seed);
+}
+
+void WorldSnapshot::readSettings(BinaryReader &reader, SimulationSettings &settings)
+{
+    readStruct(reader, settings.evolutionPointsSettings, "EvolutionPointsSettings");
+    readStruct(reader, settings.simulationSizeSettings, "SimulationSizeSettings");
+    readStruct(reader, settings.mapGenerationSettings, "MapGenerationSettings");
+    readStruct(reader, settings.profilingSettings, "ProfilingSettings");
+    settings.drawGui = reader.read<uint8_t>() != 0;
+    settings.seed = reader.read<uint64_t>();
+}
+
+void WorldSnapshot::writeWorldState(BinaryWriter &writer, const Simulation &simulation)
+{
+    writeSettings(writer, *simulation.settings);
+    writeRuntimeState(writer, simulation);
+}
+
+std::shared_ptr<Simulation> WorldSnapshot::readWorldState(BinaryReader &reader)
+{
+    auto settings = std::make_shared<SimulationSettings>();
+    readSettings(reader, *settings);
+    auto simulation = std::make_shared<Simulation>(settings);
+    readRuntimeState(reader, *simulation);
+    return simulation;
+}
+
+void WorldSnapshot::writeRuntimeState(BinaryWriter &writer, const Simulation &simulation)
+{
+    writer.write<uint64_t>(simulation.ticks);
+    writer.write<uint64_t>(simulation.idManger.getCurrentIdCounter());
+    // Streams of random service have no state, the seed it was created with is enough
+    writer.write<uint64_t>(simulation.random.getSeed());
+    writer.writeString(generatorState(simulation.brainContext->random()));
+    const auto &populationStats = simulation.brainContext->getAllPopulationStats();
+    writer.write<uint32_t>(uint32_t(populationStats.size()));
+    for (const auto &[populationName, stats] : populationStats)
+    {
+        writer.writeString(populationName);
+        writer.write<int32_t>(stats.population);
+        writer.write<int32_t>(stats.death);
+        writer.write<uint64_t>(stats.born);
+    }
+    writer.write(simulation.foodMergeStats);
+    writer.write<uint8_t>(simulation.foodField != nullptr);
+    if (simulation.foodField)
+    {
+        simulation.foodField->save(writer);
+    }
+}
+
+void WorldSnapshot::readRuntimeState(BinaryReader &reader, Simulation &simulation)
+{
+    simulation.ticks = reader.read<uint64_t>();
+    simulation.idManger.restore(reader.read<uint64_t>());
+    simulation.random = RandomService(reader.read<uint64_t>());
+    auto &brainContext = *simulation.brainContext;
+    restoreGenerator(brainContext.random(), reader.readString());
+    const uint32_t populationsCount = reader.read<uint32_t>();
+    for (uint32_t i = 0; i < populationsCount; i++)
+    {
+        auto &populationStats = brainContext.populationStats(reader.readString());
+        populationStats.population = reader.read<int32_t>();
+        populationStats.death = reader.read<int32_t>();
+        populationStats.born = reader.read<uint64_t>();
+    }
+    reader.read(simulation.foodMergeStats);
+    if (reader.read<uint8_t>() != (simulation.foodField != nullptr))
+    {
+        throw std::runtime_error("Snapshot and settings disagree on food field!");
+    }
+    if (simulation.foodField)
+    {
+        simulation.foodField->load(reader);
+    }
+}
+
+void WorldSnapshot::writeBrain(BinaryWriter &writer, const BotBrain &brain)
+{
+    writer.writeString(brain.populationName);
+    writer.write(brain.protocolsHolder->initProtocol);
+    writer.write(brain.protocolsHolder->initProtocolResponce);
+    writeResponce(writer, brain.protocolsHolder->updateProtocolResponce);
+    const size_t sizePosition = writer.reserveUint32();
+    brain.saveState(writer);
+    writer.patch(sizePosition, uint32_t(writer.bytesSince(sizePosition) - sizeof(uint32_t)));
+}
+
+std::shared_ptr<BotBrain> WorldSnapshot::readBrain(BinaryReader &reader, const BrainsRegistry &registry, Simulation &simulation)
+{
+    const std::string populationName = reader.readString();
+    std::shared_ptr<BotBrain> brain = registry.createBot(populationName, *simulation.brainContext);
+    brain->context = simulation.brainContext;
+    reader.read(brain->protocolsHolder->initProtocol);
+    reader.read(brain->protocolsHolder->initProtocolResponce);
+    brain->protocolsHolder->updateProtocolResponce = readResponce(reader);
+    const uint32_t stateSize = reader.read<uint32_t>();
+    const size_t stateStart = reader.position();
+    brain->loadState(reader);
+    if (reader.position() - stateStart != stateSize)
+    {
+        throw std::runtime_error("Brain of population " + populationName + " read " +
+                                 std::to_string(reader.position() - stateStart) + " bytes of state, but " +
+                                 std::to_string(stateSize) + " were saved!");
+    }
+    return brain;
+}
+
+std::shared_ptr<SimulationObject> WorldSnapshot::createObject(uint8_t type, const std::shared_ptr<Simulation> &simulation,
+                                                              const std::shared_ptr<BotBrain> &brain)
+{
+    switch (SimulationObjectType(type))
+    {
+    case SimulationObjectType::BaseObject:
+        return std::make_shared<SimulationObject>(simulation, Vec2<float>(), 0, ImVec4());
+    case SimulationObjectType::FoodObject:
+        return std::make_shared<FoodObject>(simulation, Vec2<float>(), ImVec4(), 1.0f, 1.0f, 1.0f, 1.0f, false);
+    case SimulationObjectType::TreeObject:
+        return std::make_shared<TreeObject>(simulation, Vec2<float>(), 3, 1.0f, 1.0f, 1.0f, 1.0f, false);
+    case SimulationObjectType::BotObject:
+    {
+        auto bot = std::make_shared<BotObject>(simulation, Vec2<int>(), 1.0f, 1.0f, 0, 0.0f, 0.0f);
+        bot->setBrainObject(brain);
+        return bot;
+    }
+    default:
+        throw std::runtime_error("Unknown object type in snapshot: " + std::to_string(type));
+    }
+}
+
+uint32_t WorldSnapshot::chunkIndex(const Simulation &simulation, SimulationObject &object)
+{
+    const auto chunk = object.getChunk();
+    if (!chunk)
+    {
+        throw std::runtime_error("Object " + std::to_string(object.id.get()) + " has no chunk!");
+    }
+    return uint32_t(chunk->yIndex * simulation.chunkManager->numberOfChunksX + chunk->xIndex);
+}
+
+void WorldSnapshot::writeObject(BinaryWriter &writer, const SimulationObject &object, uint32_t chunkIndex)
+{
+    const SimulationObjectType type = object.type();
+    writer.write<uint8_t>(uint8_t(type));
+    writer.write<uint32_t>(chunkIndex);
+    if (type == SimulationObjectType::BotObject)
+    {
+        // Brain first: it must be set before state of bot is loaded
+        writeBrain(writer, *static_cast<const BotObject &>(object).getBrain());
+    }
+    object.saveState(writer);
+}
+
+std::shared_ptr<SimulationObject> WorldSnapshot::readObject(BinaryReader &reader, uint8_t type, const BrainsRegistry &registry,
+                                                            const std::shared_ptr<Simulation> &simulation, std::shared_ptr<Chunk> &chunk)
+{
+    auto &chunkManager = *simulation->chunkManager;
+    const uint32_t chunkIndex = reader.read<uint32_t>();
+    chunk = chunkManager.getChunk(chunkIndex % chunkManager.numberOfChunksX, chunkIndex / chunkManager.numberOfChunksX);
+    if (!chunk)
+    {
+        throw std::runtime_error("Object of snapshot is in unknown chunk " + std::to_string(chunkIndex));
+    }
+    std::shared_ptr<BotBrain> brain;
+    if (SimulationObjectType(type) == SimulationObjectType::BotObject)
+    {
+        brain = readBrain(reader, registry, *simulation);
+    }
+    auto object = createObject(type, simulation, brain);
+    object->loadState(reader);
+    return object;
+}
+
+WorldSnapshot::Stats WorldSnapshot::save(const Simulation &simulation, std::ostream &out)
+{
+    const auto start = Clock::now();
+    BinaryWriter writer(&out);
+
+    writer.write(magic);
+    writer.write(version);
+    writeWorldState(writer, simulation);
+
+    // Chunk of every object is written explicitly: objects on chunk borders may stay
+    // in chunk other than whatChunkHere() gives. Sets of chunks can hold expired objects,
+    // so number of objects in chunk is counted here
+    std::vector<uint32_t> chunkIndices;
+    std::vector<uint32_t> chunkObjects(size_t(simulation.chunkManager->numberOfChunksX) * simulation.chunkManager->numberOfChunksY, 0);
+    chunkIndices.reserve(simulation.objects.size());
+    for (const auto &object : simulation.objects)
+    {
+        if (object)
+        {
+            chunkIndices.push_back(chunkIndex(simulation, *object));
+            chunkObjects[chunkIndices.back()]++;
+        }
+    }
+
+    // Chunks, with number of their objects to reserve sets on load
+    size_t chunkNumber = 0;
+    for (const auto &chunk : *simulation.chunkManager)
+    {
+        writer.write(chunk->getEffects());
+        writer.write<uint32_t>(chunkObjects[chunkNumber++]);
+    }
+
+    // Objects
+    const size_t objectsCount = chunkIndices.size();
+    writer.write<uint64_t>(objectsCount);
+    size_t objectIndex = 0;
+    for (const auto &object : simulation.objects)
+    {
+        if (!object)
+        {
+            continue;
+        }
+        writeObject(writer, *object, chunkIndices[objectIndex++]);
+        writer.flushIfFull();
+    }
+    writer.write(magic);
+    writer.flush();
+
+    return Stats{objectsCount, writer.size(), secondsSince(start)};
+}
+
+WorldSnapshot::Stats WorldSnapshot::save(const Simulation &simulation, const std::string &path)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        throw std::runtime_error("Can't open snapshot file for writing: " + path);
+    }
+    return save(simulation, out);
+}
+
+std::shared_ptr<Simulation> WorldSnapshot::load(const char *data, size_t size, const BrainsRegistry &registry, Stats *stats)
+{
+    const auto start = Clock::now();
+    BinaryReader reader(data, size);
+
+    if (reader.read<uint32_t>() != magic)
+    {
+        throw std::runtime_error("Data is not a world snapshot!");
+    }
+    const uint32_t fileVersion = reader.read<uint32_t>();
+    if (fileVersion != version)
+    {
+        throw std::runtime_error("Unsupported snapshot version " + std::to_string(fileVersion));
+    }
+    auto simulation = readWorldState(reader);
+
+    auto &chunkManager = *simulation->chunkManager;
+    for (const auto &chunk : chunkManager)
+    {
+        chunk->setEffects(reader.read<Chunk::Effects>());
+        chunk->objects.reserve(reader.read<uint32_t>());
+    }
+
+    // Objects
+    const uint64_t objectsCount = reader.read<uint64_t>();
+    simulation->objects.reserve(objectsCount);
+    for (uint64_t i = 0; i < objectsCount; i++)
+    {
+        const uint8_t type = reader.read<uint8_t>();
+        std::shared_ptr<Chunk> chunk;
+        auto object = readObject(reader, type, registry, simulation, chunk);
+        chunk->addObject(object);
+        simulation->objects.push_back(object);
+    }
+    if (reader.read<uint32_t>() != magic)
+    {
+        throw std::runtime_error("Snapshot has invalid end marker!");
+    }
+
+    if (stats)
+    {
+        *stats = Stats{size_t(objectsCount), size, secondsSince(start)};
+    }
+    return simulation;
+}
+
+std::shared_ptr<Simulation> WorldSnapshot::load(std::istream &in, const BrainsRegistry &registry, Stats *stats)
+{
+    const auto start = Clock::now();
+    std::vector<char> data;
+    in.seekg(0, std::ios::end);
+    const std::streamoff size = in.tellg();
+    if (size >= 0)
+    {
+        in.seekg(0, std::ios::beg);
+        data.resize(size_t(size));
+        in.read(data.data(), size);
+    }
+    if (size < 0 || !in)
+    {
+        throw std::runtime_error("Can't read snapshot data!");
+    }
+    auto simulation = load(data.data(), data.size(), registry, stats);
+    if (stats)
+    {
+        // Include reading of file
+        stats->seconds = secondsSince(start);
+    }
+    return simulation;
+}
+
+std::shared_ptr<Simulation> WorldSnapshot::load(const std::string &path, const BrainsRegistry &registry, Stats *stats)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("Can't open snapshot file: " + path);
+    }
+    return load(in, registry, stats);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+
+#include "snapshot/BinaryStream.h"
+
+class Simulation;
+class SimulationSettings;
+class BrainsRegistry;
+class BotBrain;
+class SimulationObject;
+class Chunk;
+
+/*
+ * Full state of simulation in compact binary form: settings, chunk effects, tick and id counters,
+ * random seed, generator of brains, population and food merge counters, food field and every object with its own state
+ * (SimulationObject::saveState()) and chunk, including brains of bots (BotBrain::saveState()).
+ *
+ * Snapshot must be taken between ticks (after Simulation::afterUpdate()), when death note
+ * and born queue are empty. Not saved: objects of BrainContext::populationState() unless brains
+ * write them with writeShared(), brains of remote brain host, camera and selection.
+ * Snapshot can be loaded only by build of the same version for the same platform.
+ */
+class WorldSnapshot
+{
+public:
+    static constexpr uint32_t magic = 0x50414E53; // "SNAP"
+    static constexpr uint32_t version = 5;
+
+    struct Stats
+    {
+        size_t objects = 0;
+        size_t bytes = 0;
+        double seconds = 0.0;
+    };
+
+    static Stats save(const Simulation &simulation, std::ostream &out);
+    /// @throw std::runtime_error if file cant be written
+    static Stats save(const Simulation &simulation, const std::string &path);
+
+    /// @brief Create new simulation from snapshot data
+    /// @param registry Registry that creates brains by population name
+    /// @throw std::runtime_error if data is not a valid snapshot
+    static std::shared_ptr<Simulation> load(const char *data, size_t size, const BrainsRegistry &registry, Stats *stats = nullptr);
+    static std::shared_ptr<Simulation> load(std::istream &in, const BrainsRegistry &registry, Stats *stats = nullptr);
+    static std::shared_ptr<Simulation> load(const std::string &path, const BrainsRegistry &registry, Stats *stats = nullptr);
+
+private:
+    // Parts of snapshot, also used by WorldImage and DeltaCheckpointer
+    friend class WorldImage;
+    friend class DeltaCheckpointer;
+
+    static void writeSettings(BinaryWriter &writer, const SimulationSettings &settings);
+    static void readSettings(BinaryReader &reader, SimulationSettings &settings);
+
+    /// @brief Settings and runtime state
+    static void writeWorldState(BinaryWriter &writer, const Simulation &simulation);
+    /// @brief Create simulation without objects from data written by writeWorldState()
+    static std::shared_ptr<Simulation> readWorldState(BinaryReader &reader);
+
+    /// @brief Tick counter, id counter, random seed, generator of brains, population and food merge stats and food field
+    static void writeRuntimeState(BinaryWriter &writer, const Simulation &simulation);
+    static void readRuntimeState(BinaryReader &reader, Simulation &simulation);
+
+    /// @brief Type, chunk, brain of bot and state of object
+    static void writeObject(BinaryWriter &writer, const SimulationObject &object, uint32_t chunkIndex);
+    /// @brief Read object written by writeObject() whose type is already read
+    /// @param chunk Set to chunk of object. Object is not added to it
+    static std::shared_ptr<SimulationObject> readObject(BinaryReader &reader, uint8_t type, const BrainsRegistry &registry,
+                                                        const std::shared_ptr<Simulation> &simulation, std::shared_ptr<Chunk> &chunk);
+
+    /// @brief Population name, protocols, current action and state of brain
+    static void writeBrain(BinaryWriter &writer, const BotBrain &brain);
+    static std::shared_ptr<BotBrain> readBrain(BinaryReader &reader, const BrainsRegistry &registry, Simulation &simulation);
+
+    /// @brief Create object of given type with placeholder values, loadState() must be called next
+    /// @param brain Brain of bot, ignored for other types
+    static std::shared_ptr<SimulationObject> createObject(uint8_t type, const std::shared_ptr<Simulation> &simulation,
+                                                          const std::shared_ptr<BotBrain> &brain);
+
+    /// @brief Index of chunk of object in row-major order
+    static uint32_t chunkIndex(const Simulation &simulation, SimulationObject &object);
+};
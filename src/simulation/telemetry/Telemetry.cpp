@@ -0,0 +1,423 @@
+#include "Telemetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+
+#include "simulation.h"
+#include "objects/Bot.h"
+#include "objects/Food.h"
+#include "protocols/brain/BotBrain.h"
+#include "protocols/brain/BrainContext.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using Column = TelemetryTable::Column;
+    using ColumnType = TelemetryTable::ColumnType;
+
+    double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    std::vector<Column> tableColumns(Telemetry::Table table)
+    {
+        switch (table)
+        {
+        case Telemetry::Ticks:
+            return {{"tick", ColumnType::Int}, {"objects", ColumnType::Int}, {"bots", ColumnType::Int},
+                    {"food", ColumnType::Int}, {"trees", ColumnType::Int}, {"food_calories", ColumnType::Float},
+                    {"field_calories", ColumnType::Float}, {"food_merged", ColumnType::Int},
+                    {"born", ColumnType::Int}, {"died", ColumnType::Int}};
+        case Telemetry::Populations:
+            return {{"tick", ColumnType::Int}, {"population", ColumnType::Text}, {"alive", ColumnType::Int},
+                    {"born", ColumnType::Int}, {"died", ColumnType::Int}, {"health", ColumnType::Float},
+                    {"food", ColumnType::Float}, {"speed", ColumnType::Float}, {"see_distance", ColumnType::Float},
+                    {"damage", ColumnType::Float}};
+        default:
+            return {{"tick", ColumnType::Int}, {"x", ColumnType::Int}, {"y", ColumnType::Int},
+                    {"bots", ColumnType::Int}, {"food", ColumnType::Int}, {"food_calories", ColumnType::Float},
+                    {"field_calories", ColumnType::Float}};
+        }
+    }
+}
+
+std::string Telemetry::tablePath(const Options &options, Table table)
+{
+    return options.path + "." + tableNames[table] + (options.format == Format::Csv ? ".csv" : ".tlm");
+}
+
+Telemetry::Telemetry(std::shared_ptr<Simulation> simulation_, const Options &options_)
+    : simulation(simulation_), options(options_)
+{
+    if (options.interval < 1 || options.chunkInterval < 0 || options.blockRows < 1 || options.maxPendingBlocks < 1)
+    {
+        throw std::invalid_argument("Telemetry interval, blockRows and maxPendingBlocks must be positive!");
+    }
+    if (simulation->telemetry)
+    {
+        throw std::runtime_error("Simulation already has telemetry!");
+    }
+    const auto directory = std::filesystem::path(options.path).parent_path();
+    if (!directory.empty())
+    {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error)
+        {
+            throw std::runtime_error("Can't create telemetry directory " + directory.string() + ": " + error.message());
+        }
+    }
+
+    for (int table = 0; table < TablesCount; table++)
+    {
+        tables.emplace_back(tableColumns(Table(table)));
+        tables.back().reserve(options.blockRows);
+
+        const std::string path = tablePath(options, Table(table));
+        auto &file = files[table];
+        file.file.open(path, std::ios::binary | std::ios::trunc);
+        if (!file.file)
+        {
+            throw std::runtime_error("Can't open telemetry file for writing: " + path);
+        }
+        if (options.format == Format::Csv)
+        {
+            std::string header;
+            tables.back().appendCsvHeader(header);
+            file.writer.writeArray(header.data(), header.size());
+        }
+        else
+        {
+            tables.back().writeBinaryHeader(file.writer);
+        }
+        file.writer.flush();
+        writtenBytes += file.writer.size();
+    }
+
+    // Births and deaths before telemetry are not counted
+    for (const auto &[name, populationStats] : simulation->getBrainContext()->getAllPopulationStats())
+    {
+        auto &populationSample = population(name);
+        populationSample.lastBorn = populationStats.born;
+        populationSample.lastDeaths = populationStats.death;
+    }
+    lastFoodMerged = simulation->getFoodMergeStats().saved();
+    chunks.resize(size_t(simulation->chunkManager->numberOfChunksX) * simulation->chunkManager->numberOfChunksY);
+    sampledTick = simulation->ticks;
+    chunkSampledTick = simulation->ticks;
+
+    writer = std::thread(&Telemetry::writerLoop, this);
+    simulation->telemetry = this;
+}
+
+Telemetry::~Telemetry()
+{
+    simulation->telemetry = nullptr;
+    try
+    {
+        for (int table = 0; table < TablesCount; table++)
+        {
+            submit(Table(table), true);
+        }
+    }
+    catch (const std::exception &)
+    {
+        // Destructor must not throw, files just end at the last written block
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    pendingChanged.notify_all();
+    writer.join();
+}
+
+void Telemetry::afterTick()
+{
+    // Paused frames dont change ticks, so they are never sampled
+    if (simulation->ticks - sampledTick < static_cast<unsigned long>(options.interval))
+    {
+        return;
+    }
+    sample();
+}
+
+Telemetry::PopulationSample &Telemetry::population(const std::string &name)
+{
+    // Few populations and bots of one population are often neighbours in objects, so linear search is enough
+    for (auto &populationSample : populations)
+    {
+        if (populationSample.name == name)
+        {
+            return populationSample;
+        }
+    }
+    populations.push_back(PopulationSample{name});
+    return populations.back();
+}
+
+void Telemetry::sample()
+{
+    rethrowWriterError();
+    const auto start = Clock::now();
+    const int64_t tick = int64_t(simulation->ticks);
+    const bool sampleChunks = options.chunkInterval > 0 &&
+                              simulation->ticks - chunkSampledTick >= static_cast<unsigned long>(options.chunkInterval);
+    const int numberOfChunksX = simulation->chunkManager->numberOfChunksX;
+
+    for (auto &populationSample : populations)
+    {
+        populationSample.alive = 0;
+        populationSample.health = populationSample.food = populationSample.speed = 0.0;
+        populationSample.seeDistance = populationSample.damage = 0.0;
+    }
+    if (sampleChunks)
+    {
+        std::fill(chunks.begin(), chunks.end(), ChunkSample{});
+    }
+
+    int64_t objectCount = 0, botCount = 0, foodCount = 0, treeCount = 0;
+    double foodCalories = 0.0;
+    PopulationSample *lastPopulation = nullptr;
+    for (const auto &object : simulation->objects)
+    {
+        if (!object)
+        {
+            continue;
+        }
+        objectCount++;
+        ChunkSample *chunkSample = nullptr;
+        if (sampleChunks)
+        {
+            if (auto chunk = object->getChunk())
+            {
+                chunkSample = &chunks[size_t(chunk->yIndex) * numberOfChunksX + chunk->xIndex];
+            }
+        }
+
+        switch (object->type())
+        {
+        case SimulationObjectType::BotObject:
+        {
+            const auto &bot = static_cast<const BotObject &>(*object);
+            botCount++;
+            if (chunkSample)
+            {
+                chunkSample->bots++;
+            }
+            const auto &brain = bot.getBrain();
+            if (!brain)
+            {
+                break;
+            }
+            if (!lastPopulation || lastPopulation->name != brain->populationName)
+            {
+                lastPopulation = &population(brain->populationName);
+            }
+            lastPopulation->alive++;
+            lastPopulation->health += bot.getHealth();
+            lastPopulation->food += bot.getFood();
+            lastPopulation->speed += bot.getSpeed();
+            lastPopulation->seeDistance += bot.getBaseSeeDistance();
+            lastPopulation->damage += bot.getDamage();
+            break;
+        }
+        case SimulationObjectType::FoodObject:
+        {
+            const float calories = static_cast<const FoodObject &>(*object).getCalories();
+            foodCount++;
+            foodCalories += calories;
+            if (chunkSample)
+            {
+                chunkSample->food++;
+                chunkSample->foodCalories += calories;
+            }
+            break;
+        }
+        case SimulationObjectType::TreeObject:
+            treeCount++;
+            break;
+        default:
+            break;
+        }
+    }
+
+    auto &populationTable = tables[Populations];
+    int64_t born = 0, died = 0;
+    for (const auto &[name, populationStats] : simulation->getBrainContext()->getAllPopulationStats())
+    {
+        auto &populationSample = population(name);
+        const int64_t populationBorn = int64_t(populationStats.born - populationSample.lastBorn);
+        const int64_t populationDied = int64_t(populationStats.death - populationSample.lastDeaths);
+        populationSample.lastBorn = populationStats.born;
+        populationSample.lastDeaths = populationStats.death;
+        born += populationBorn;
+        died += populationDied;
+
+        const double alive = double(std::max<size_t>(populationSample.alive, 1));
+        populationTable.addInt(tick);
+        populationTable.addText(name);
+        populationTable.addInt(int64_t(populationSample.alive));
+        populationTable.addInt(populationBorn);
+        populationTable.addInt(populationDied);
+        populationTable.addFloat(float(populationSample.health / alive));
+        populationTable.addFloat(float(populationSample.food / alive));
+        populationTable.addFloat(float(populationSample.speed / alive));
+        populationTable.addFloat(float(populationSample.seeDistance / alive));
+        populationTable.addFloat(float(populationSample.damage / alive));
+        stats.rows++;
+    }
+
+    // Food kept by food field is not in objects
+    const FoodField *foodField = simulation->getFoodField();
+    auto &tickTable = tables[Ticks];
+    tickTable.addInt(tick);
+    tickTable.addInt(objectCount);
+    tickTable.addInt(botCount);
+    tickTable.addInt(foodCount);
+    tickTable.addInt(treeCount);
+    tickTable.addFloat(float(foodCalories));
+    tickTable.addFloat(foodField ? foodField->getTotalCalories() : 0.0f);
+    const uint64_t foodMerged = simulation->getFoodMergeStats().saved();
+    tickTable.addInt(int64_t(foodMerged - lastFoodMerged));
+    lastFoodMerged = foodMerged;
+    tickTable.addInt(born);
+    tickTable.addInt(died);
+    stats.rows++;
+
+    if (sampleChunks)
+    {
+        auto &chunkTable = tables[Chunks];
+        for (size_t index = 0; index < chunks.size(); index++)
+        {
+            chunkTable.addInt(tick);
+            chunkTable.addInt(int64_t(index % numberOfChunksX));
+            chunkTable.addInt(int64_t(index / numberOfChunksX));
+            chunkTable.addInt(int64_t(chunks[index].bots));
+            chunkTable.addInt(int64_t(chunks[index].food));
+            chunkTable.addFloat(float(chunks[index].foodCalories));
+            chunkTable.addFloat(foodField ? foodField->getCalories(index) : 0.0f);
+        }
+        stats.rows += chunks.size();
+        stats.chunkSamples++;
+        chunkSampledTick = simulation->ticks;
+    }
+
+    sampledTick = simulation->ticks;
+    stats.samples++;
+    stats.collectSeconds += secondsSince(start);
+
+    for (int table = 0; table < TablesCount; table++)
+    {
+        submit(Table(table), false);
+    }
+}
+
+void Telemetry::submit(Table table, bool force)
+{
+    auto &block = tables[table];
+    if (block.getRows() == 0 || (!force && block.getRows() < options.blockRows))
+    {
+        return;
+    }
+    const auto start = Clock::now();
+    PendingBlock pendingBlock{table, TelemetryTable(block.getColumns())};
+    std::swap(pendingBlock.block, block);
+    block.reserve(options.blockRows);
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        pendingChanged.wait(lock, [this]() { return pending.size() < options.maxPendingBlocks; });
+        pending.push_back(std::move(pendingBlock));
+    }
+    pendingChanged.notify_all();
+    stats.waitSeconds += secondsSince(start);
+}
+
+void Telemetry::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        pendingChanged.wait(lock, [this]() { return stopping || !pending.empty(); });
+        if (pending.empty())
+        {
+            return;
+        }
+        // Block stays in queue while it is written, so flush() waits for it
+        const PendingBlock &block = pending.front();
+        lock.unlock();
+        try
+        {
+            writeBlock(block.table, block.block);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> errorLock(mutex);
+            if (!writerError)
+            {
+                writerError = std::current_exception();
+            }
+        }
+        lock.lock();
+        pending.pop_front();
+        pendingChanged.notify_all();
+    }
+}
+
+void Telemetry::writeBlock(Table table, const TelemetryTable &block)
+{
+    auto &file = files[table];
+    const size_t before = file.writer.size();
+    if (options.format == Format::Csv)
+    {
+        std::string text;
+        block.appendCsv(text);
+        file.writer.writeArray(text.data(), text.size());
+    }
+    else
+    {
+        block.writeBinaryBlock(file.writer);
+    }
+    file.writer.flush();
+    if (!file.file.flush())
+    {
+        throw std::runtime_error("Can't write telemetry file " + tablePath(options, table));
+    }
+    writtenBytes += file.writer.size() - before;
+}
+
+void Telemetry::flush()
+{
+    for (int table = 0; table < TablesCount; table++)
+    {
+        submit(Table(table), true);
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        pendingChanged.wait(lock, [this]() { return pending.empty(); });
+    }
+    rethrowWriterError();
+}
+
+void Telemetry::rethrowWriterError()
+{
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(error, writerError);
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+Telemetry::Stats Telemetry::getStats() const
+{
+    Stats result = stats;
+    result.bytes = writtenBytes;
+    return result;
+}
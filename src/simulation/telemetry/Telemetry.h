@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "snapshot/BinaryStream.h"
+#include "telemetry/TelemetryTable.h"
+
+class Simulation;
+
+/*
+ * Per tick metrics of running simulation, written to three tables:
+ * - ticks: number of objects, bots, food and trees, calories of food and of food field, food merges,
+ *   births and deaths;
+ * - populations: alive bots, births and deaths and average traits of every population;
+ * - chunks: bots, food, calories of food and of food field in every chunk (less often, it is the largest table).
+ * Births, deaths and food merges are counted since the previous sample.
+ *
+ * Simulation thread only walks objects once per sample and appends values to column blocks
+ * (TelemetryTable). Full blocks go to background thread that encodes them as CSV or binary
+ * columnar blocks and writes them to files, so sampling every tick costs one pass over objects.
+ * Like DeltaCheckpointer, simulation thread waits only when writer has too many blocks.
+ */
+class Telemetry
+{
+public:
+    enum class Format
+    {
+        Csv,
+        Binary,
+    };
+
+    enum Table
+    {
+        Ticks,
+        Populations,
+        Chunks,
+        TablesCount
+    };
+    static constexpr std::array<const char *, TablesCount> tableNames = {"ticks", "populations", "chunks"};
+
+    struct Options
+    {
+        /// @brief Prefix of files: <path>.ticks.csv, <path>.populations.csv, ... (.tlm for binary format).
+        /// Its directory is created if missing
+        std::string path = "telemetry/run";
+        Format format = Format::Csv;
+        /// @brief Ticks between samples
+        int interval = 1;
+        /// @brief Ticks between samples of chunks table, checked on every sample. 0 turns it off
+        int chunkInterval = 100;
+        /// @brief Rows of one table collected before they are given to writer
+        size_t blockRows = 4096;
+        /// @brief Blocks waiting for background writer. When limit is reached, simulation thread waits
+        size_t maxPendingBlocks = 16;
+    };
+
+    struct Stats
+    {
+        unsigned long samples = 0;
+        unsigned long chunkSamples = 0;
+        size_t rows = 0;
+        /// @brief Written to files by background writer
+        size_t bytes = 0;
+        /// @brief Time of simulation thread spent on sampling and waiting for writer
+        double collectSeconds = 0.0;
+        double waitSeconds = 0.0;
+    };
+
+    /// @brief File of table for given options
+    static std::string tablePath(const Options &options, Table table);
+
+private:
+    std::shared_ptr<Simulation> simulation;
+    Options options;
+
+    /// @brief Accumulated values of population during sample and counters of previous sample
+    struct PopulationSample
+    {
+        std::string name;
+        size_t alive = 0;
+        double health = 0.0;
+        double food = 0.0;
+        double speed = 0.0;
+        double seeDistance = 0.0;
+        double damage = 0.0;
+        unsigned long lastBorn = 0;
+        int lastDeaths = 0;
+    };
+    std::vector<PopulationSample> populations;
+
+    struct ChunkSample
+    {
+        size_t bots = 0;
+        size_t food = 0;
+        double foodCalories = 0.0;
+    };
+    std::vector<ChunkSample> chunks;
+    /// @brief Food merges of simulation at previous sample
+    uint64_t lastFoodMerged = 0;
+
+    unsigned long sampledTick = 0;
+    unsigned long chunkSampledTick = 0;
+    std::vector<TelemetryTable> tables;
+    Stats stats;
+
+    /// @brief Files are used only by background writer after construction
+    struct TableFile
+    {
+        std::ofstream file;
+        BinaryWriter writer{&file};
+    };
+    std::array<TableFile, TablesCount> files;
+    std::atomic<size_t> writtenBytes = 0;
+
+    struct PendingBlock
+    {
+        Table table;
+        TelemetryTable block;
+    };
+    std::deque<PendingBlock> pending;
+    std::mutex mutex;
+    std::condition_variable pendingChanged;
+    bool stopping = false;
+    std::exception_ptr writerError;
+    std::thread writer;
+
+    void sample();
+    PopulationSample &population(const std::string &name);
+    /// @brief Give block of table to background writer if it is full or if forced
+    void submit(Table table, bool force);
+    void writerLoop();
+    void writeBlock(Table table, const TelemetryTable &block);
+    void rethrowWriterError();
+
+public:
+    /// @brief Create table files and start sampling simulation after every tick
+    /// @throw std::runtime_error if files cant be created
+    Telemetry(std::shared_ptr<Simulation> simulation_, const Options &options_);
+    /// @brief Write collected rows and stop sampling
+    ~Telemetry();
+
+    Telemetry(const Telemetry &) = delete;
+    Telemetry &operator=(const Telemetry &) = delete;
+
+    /// @brief Called by Simulation::afterUpdate(). Samples if interval passed, does nothing on paused frames
+    void afterTick();
+    /// @brief Give all collected rows to writer and wait until they are written
+    /// @throw std::runtime_error if background writer failed
+    void flush();
+
+    Stats getStats() const;
+};
@@ -0,0 +1,312 @@
+#include "TelemetryTable.h"
+
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "snapshot/BinaryStream.h"
+#include "utilities/MappedFile.h"
+
+namespace
+{
+    void appendCsvText(std::string &out, const std::string &text)
+    {
+        if (text.find_first_of(",\"\n") == std::string::npos)
+        {
+            out += text;
+            return;
+        }
+        out += '"';
+        for (char symbol : text)
+        {
+            if (symbol == '"')
+            {
+                out += '"';
+            }
+            out += symbol;
+        }
+        out += '"';
+    }
+
+    template <typename T>
+    void appendNumber(std::string &out, T value)
+    {
+        char buffer[32];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        out.append(buffer, result.ptr);
+    }
+}
+
+TelemetryTable::TelemetryTable(std::vector<Column> columns_)
+    : columns(std::move(columns_)), ints(columns.size()), floats(columns.size()), texts(columns.size())
+{
+    if (columns.empty())
+    {
+        throw std::invalid_argument("Telemetry table must have columns!");
+    }
+}
+
+void TelemetryTable::checkNext(ColumnType type) const
+{
+    if (columns[nextColumn].type != type)
+    {
+        throw std::logic_error("Value of wrong type for telemetry column " + columns[nextColumn].name);
+    }
+}
+
+void TelemetryTable::advance()
+{
+    if (++nextColumn == columns.size())
+    {
+        nextColumn = 0;
+        rows++;
+    }
+}
+
+void TelemetryTable::addInt(int64_t value)
+{
+    checkNext(ColumnType::Int);
+    ints[nextColumn].push_back(value);
+    advance();
+}
+
+void TelemetryTable::addFloat(float value)
+{
+    checkNext(ColumnType::Float);
+    floats[nextColumn].push_back(value);
+    advance();
+}
+
+void TelemetryTable::addText(const std::string &value)
+{
+    checkNext(ColumnType::Text);
+    texts[nextColumn].push_back(value);
+    advance();
+}
+
+void TelemetryTable::clear()
+{
+    for (size_t column = 0; column < columns.size(); column++)
+    {
+        ints[column].clear();
+        floats[column].clear();
+        texts[column].clear();
+    }
+    rows = 0;
+    nextColumn = 0;
+}
+
+void TelemetryTable::reserve(size_t rowCount)
+{
+    for (size_t column = 0; column < columns.size(); column++)
+    {
+        switch (columns[column].type)
+        {
+        case ColumnType::Int:
+            ints[column].reserve(rowCount);
+            break;
+        case ColumnType::Float:
+            floats[column].reserve(rowCount);
+            break;
+        case ColumnType::Text:
+            texts[column].reserve(rowCount);
+            break;
+        }
+    }
+}
+
+void TelemetryTable::appendCsvHeader(std::string &out) const
+{
+    for (size_t column = 0; column < columns.size(); column++)
+    {
+        if (column > 0)
+        {
+            out += ',';
+        }
+        appendCsvText(out, columns[column].name);
+    }
+    out += '\n';
+}
+
+void TelemetryTable::appendCsv(std::string &out) const
+{
+    for (size_t row = 0; row < rows; row++)
+    {
+        for (size_t column = 0; column < columns.size(); column++)
+        {
+            if (column > 0)
+            {
+                out += ',';
+            }
+            switch (columns[column].type)
+            {
+            case ColumnType::Int:
+                appendNumber(out, ints[column][row]);
+                break;
+            case ColumnType::Float:
+                appendNumber(out, floats[column][row]);
+                break;
+            case ColumnType::Text:
+                appendCsvText(out, texts[column][row]);
+                break;
+            }
+        }
+        out += '\n';
+    }
+}
+
+void TelemetryTable::writeBinaryHeader(BinaryWriter &writer) const
+{
+    writer.write(magic);
+    writer.write(version);
+    writer.write<uint32_t>(uint32_t(columns.size()));
+    for (const auto &column : columns)
+    {
+        writer.writeString(column.name);
+        writer.write(column.type);
+    }
+}
+
+void TelemetryTable::writeBinaryBlock(BinaryWriter &writer) const
+{
+    const size_t sizePosition = writer.reserveUint32();
+    writer.write<uint32_t>(uint32_t(rows));
+    for (size_t column = 0; column < columns.size(); column++)
+    {
+        switch (columns[column].type)
+        {
+        case ColumnType::Int:
+        {
+            // Most counters fit into 32 bits, then block keeps them so
+            const auto &values = ints[column];
+            const bool narrow = std::all_of(values.begin(), values.begin() + rows, [](int64_t value)
+                                            { return value >= INT32_MIN && value <= INT32_MAX; });
+            writer.write<uint8_t>(narrow ? sizeof(int32_t) : sizeof(int64_t));
+            if (narrow)
+            {
+                std::vector<int32_t> narrowed(values.begin(), values.begin() + rows);
+                writer.writeArray(narrowed.data(), rows);
+            }
+            else
+            {
+                writer.writeArray(values.data(), rows);
+            }
+            break;
+        }
+        case ColumnType::Float:
+            writer.writeArray(floats[column].data(), rows);
+            break;
+        case ColumnType::Text:
+        {
+            // Texts repeat a lot (e.g. names of populations), so every distinct one is written once
+            std::unordered_map<std::string, uint32_t> dictionary;
+            std::vector<const std::string *> distinct;
+            std::vector<uint32_t> indices(rows);
+            for (size_t row = 0; row < rows; row++)
+            {
+                const auto [it, inserted] = dictionary.try_emplace(texts[column][row], uint32_t(distinct.size()));
+                if (inserted)
+                {
+                    distinct.push_back(&it->first);
+                }
+                indices[row] = it->second;
+            }
+            writer.write<uint32_t>(uint32_t(distinct.size()));
+            for (const std::string *text : distinct)
+            {
+                writer.writeString(*text);
+            }
+            writer.writeArray(indices.data(), rows);
+            break;
+        }
+        }
+    }
+    writer.patch(sizePosition, uint32_t(writer.bytesSince(sizePosition) - sizeof(uint32_t)));
+}
+
+TelemetryTable TelemetryTable::readBinary(const std::string &path)
+{
+    MappedFile file(path);
+    BinaryReader reader(file.data(), file.size());
+    if (reader.read<uint32_t>() != magic)
+    {
+        throw std::runtime_error(path + " is not a telemetry table!");
+    }
+    if (reader.read<uint32_t>() != version)
+    {
+        throw std::runtime_error("Telemetry table " + path + " has unsupported version!");
+    }
+    std::vector<Column> columns(reader.read<uint32_t>());
+    for (auto &column : columns)
+    {
+        column.name = reader.readString();
+        column.type = reader.read<ColumnType>();
+    }
+
+    TelemetryTable table(std::move(columns));
+    while (reader.remaining() >= sizeof(uint32_t))
+    {
+        const uint32_t size = reader.read<uint32_t>();
+        if (reader.remaining() < size)
+        {
+            break;
+        }
+        const size_t blockRows = reader.read<uint32_t>();
+        for (size_t column = 0; column < table.columns.size(); column++)
+        {
+            switch (table.columns[column].type)
+            {
+            case ColumnType::Int:
+            {
+                auto &values = table.ints[column];
+                values.resize(table.rows + blockRows);
+                const uint8_t width = reader.read<uint8_t>();
+                if (width == sizeof(int32_t))
+                {
+                    std::vector<int32_t> narrowed(blockRows);
+                    reader.readArray(narrowed.data(), blockRows);
+                    std::copy(narrowed.begin(), narrowed.end(), values.begin() + table.rows);
+                }
+                else if (width == sizeof(int64_t))
+                {
+                    reader.readArray(values.data() + table.rows, blockRows);
+                }
+                else
+                {
+                    throw std::runtime_error("Telemetry table " + path + " has integers of unknown width!");
+                }
+                break;
+            }
+            case ColumnType::Float:
+            {
+                auto &values = table.floats[column];
+                values.resize(table.rows + blockRows);
+                reader.readArray(values.data() + table.rows, blockRows);
+                break;
+            }
+            case ColumnType::Text:
+            {
+                std::vector<std::string> distinct(reader.read<uint32_t>());
+                for (auto &text : distinct)
+                {
+                    text = reader.readString();
+                }
+                for (size_t row = 0; row < blockRows; row++)
+                {
+                    const uint32_t index = reader.read<uint32_t>();
+                    if (index >= distinct.size())
+                    {
+                        throw std::runtime_error("Telemetry table " + path + " refers to unknown text!");
+                    }
+                    table.texts[column].push_back(distinct[index]);
+                }
+                break;
+            }
+            }
+        }
+        table.rows += blockRows;
+    }
+    return table;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class BinaryWriter;
+
+/*
+ * Block of rows of one telemetry table, stored by columns. Rows are appended value by value
+ * in column order, then the whole block is encoded at once as CSV or as binary columnar block.
+ *
+ * Binary table file: magic, version, columns (name and type), then blocks until the end of file.
+ * Block: its size, number of rows and one array per column: integers (width byte, then int32 values
+ * if all of them fit, otherwise int64), floats, or for text columns a dictionary of distinct strings
+ * of the block followed by uint32 index per row.
+ * Block cut by crash is ignored by readBinary().
+ */
+class TelemetryTable
+{
+public:
+    static constexpr uint32_t magic = 0x4D4C4554; // "TELM"
+    static constexpr uint32_t version = 1;
+
+    enum class ColumnType : uint8_t
+    {
+        Int,
+        Float,
+        Text,
+    };
+
+    struct Column
+    {
+        std::string name;
+        ColumnType type;
+    };
+
+private:
+    std::vector<Column> columns;
+    /// @brief Values by column. Only vector of column type is used
+    std::vector<std::vector<int64_t>> ints;
+    std::vector<std::vector<float>> floats;
+    std::vector<std::vector<std::string>> texts;
+    size_t rows = 0;
+    /// @brief Column of the next added value
+    size_t nextColumn = 0;
+
+    void checkNext(ColumnType type) const;
+    void advance();
+
+public:
+    explicit TelemetryTable(std::vector<Column> columns_);
+
+    /// @brief Append value to current row. Values must be added in order of columns,
+    /// row is complete after its last column
+    /// @throw std::logic_error if column of value has other type
+    void addInt(int64_t value);
+    void addFloat(float value);
+    void addText(const std::string &value);
+
+    /// @brief Forget all rows, keeping allocated memory
+    void clear();
+    void reserve(size_t rowCount);
+
+    const std::vector<Column> &getColumns() const { return columns; }
+    /// @brief Number of complete rows
+    size_t getRows() const { return rows; }
+    int64_t getInt(size_t column, size_t row) const { return ints[column][row]; }
+    float getFloat(size_t column, size_t row) const { return floats[column][row]; }
+    const std::string &getText(size_t column, size_t row) const { return texts[column][row]; }
+
+    /// @brief Append line with names of columns
+    void appendCsvHeader(std::string &out) const;
+    /// @brief Append rows as CSV lines. Floats are written in the shortest form that reads back exactly
+    void appendCsv(std::string &out) const;
+
+    void writeBinaryHeader(BinaryWriter &writer) const;
+    void writeBinaryBlock(BinaryWriter &writer) const;
+    /// @brief Read all rows of binary table file
+    /// @throw std::runtime_error if file cant be read or is not a telemetry table
+    static TelemetryTable readBinary(const std::string &path);
+};
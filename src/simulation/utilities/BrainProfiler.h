@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// @brief Accumulate time spent on bots of each population in every phase of bot update:
+/// perception (packing vision), brain (decision) and action (performing responce).
+/// Disabled by default, because measuring every bot cost a few percent of tick.
+class BrainProfiler
+{
+public:
+    enum Phase
+    {
+        Perception,
+        Brain,
+        Action,
+        PhasesCount
+    };
+    static constexpr std::array<const char *, PhasesCount> phaseNames = {"Perception", "Brain", "Action"};
+
+    using Clock = std::chrono::steady_clock;
+
+    static float microsecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<float, std::micro>(Clock::now() - start).count();
+    }
+
+    /// @brief Timings of one phase. Last samples are kept for percentiles
+    struct PhaseStats
+    {
+        static constexpr size_t samplesCapacity = 4096;
+
+        double totalUs = 0.0;
+        /// @brief Number of bot updates covered by totalUs
+        unsigned long bots = 0;
+        std::vector<float> samples;
+        size_t nextSample = 0;
+
+        /// @brief Add time spent on given number of bots
+        /// @param microseconds Time spent on all of them
+        void add(float microseconds, unsigned long count = 1)
+        {
+            totalUs += microseconds;
+            bots += count;
+            const float perBot = count ? microseconds / count : microseconds;
+            if (samples.size() < samplesCapacity)
+            {
+                samples.push_back(perBot);
+            }
+            else
+            {
+                samples[nextSample] = perBot;
+                nextSample = (nextSample + 1) % samplesCapacity;
+            }
+        }
+
+        double meanUs() const { return bots ? totalUs / bots : 0.0; }
+
+        /// @brief Percentile of time per bot over last samples
+        /// @param percentile Value in range [0, 1]
+        double percentileUs(double percentile) const
+        {
+            if (samples.empty())
+            {
+                return 0.0;
+            }
+            std::vector<float> sorted = samples;
+            const size_t index = std::min(sorted.size() - 1, size_t(percentile * sorted.size()));
+            std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+            return sorted[index];
+        }
+    };
+
+    struct PopulationProfile
+    {
+        std::array<PhaseStats, PhasesCount> phases;
+        /// @brief Number of bots whose decision was dropped because brain exceeded time budget
+        unsigned long overBudget = 0;
+
+        double totalUs() const
+        {
+            double total = 0.0;
+            for (const auto &phase : phases)
+            {
+                total += phase.totalUs;
+            }
+            return total;
+        }
+    };
+
+    /// @brief One row of report table
+    struct Row
+    {
+        std::string populationName;
+        /// @brief Number of bots decided by brain
+        unsigned long bots = 0;
+        std::array<double, PhasesCount> meanUs{};
+        std::array<double, PhasesCount> p99Us{};
+        /// @brief Part of measured ticks time spent on population
+        double tickShare = 0.0;
+        unsigned long overBudget = 0;
+    };
+
+private:
+    bool enabled = false;
+    /// @brief Time limit of one brain call per bot in microseconds. 0 - no limit
+    float timeBudgetUs = 0.0f;
+
+    std::map<std::string, PopulationProfile> populations;
+    double totalTickUs = 0.0;
+    unsigned long ticks = 0;
+
+public:
+    bool isEnabled() const { return enabled; }
+    void setEnabled(bool enabled_) { enabled = enabled_; }
+
+    float getTimeBudgetUs() const { return timeBudgetUs; }
+    void setTimeBudgetUs(float timeBudgetUs_) { timeBudgetUs = std::max(0.0f, timeBudgetUs_); }
+
+    /// @brief Get profile of population. Reference stays valid until reset()
+    PopulationProfile &population(const std::string &populationName) { return populations[populationName]; }
+
+    /// @brief Add duration of whole measured tick
+    void addTick(double microseconds)
+    {
+        totalTickUs += microseconds;
+        ticks++;
+    }
+
+    unsigned long getTicks() const { return ticks; }
+    double meanTickUs() const { return ticks ? totalTickUs / ticks : 0.0; }
+
+    /// @brief Memory used by kept samples
+    size_t memoryBytes() const
+    {
+        size_t bytes = 0;
+        for (const auto &[populationName, profile] : populations)
+        {
+            bytes += sizeof(PopulationProfile) + populationName.capacity();
+            for (const auto &phase : profile.phases)
+            {
+                bytes += phase.samples.capacity() * sizeof(float);
+            }
+        }
+        return bytes;
+    }
+
+    void reset()
+    {
+        populations.clear();
+        totalTickUs = 0.0;
+        ticks = 0;
+    }
+
+    std::vector<Row> report() const
+    {
+        std::vector<Row> rows;
+        for (const auto &[populationName, profile] : populations)
+        {
+            Row row;
+            row.populationName = populationName;
+            row.bots = profile.phases[Brain].bots;
+            for (int phase = 0; phase < PhasesCount; phase++)
+            {
+                row.meanUs[phase] = profile.phases[phase].meanUs();
+                row.p99Us[phase] = profile.phases[phase].percentileUs(0.99);
+            }
+            row.tickShare = totalTickUs > 0.0 ? profile.totalUs() / totalTickUs : 0.0;
+            row.overBudget = profile.overBudget;
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+    /// @brief Print report as text table (for headless runs)
+    void print(std::ostream &out) const
+    {
+        out << "Brain profile over " << ticks << " ticks, mean tick " << std::fixed << std::setprecision(1)
+            << meanTickUs() << " us (time per bot in us, mean / p99)\n";
+        out << std::left << std::setw(28) << "Population" << std::right << std::setw(10) << "Bots";
+        for (const char *name : phaseNames)
+        {
+            out << std::setw(20) << name;
+        }
+        out << std::setw(10) << "Share" << std::setw(12) << "OverBudget" << "\n";
+        for (const auto &row : report())
+        {
+            out << std::left << std::setw(28) << row.populationName << std::right << std::setw(10) << row.bots;
+            for (int phase = 0; phase < PhasesCount; phase++)
+            {
+                std::ostringstream cell;
+                cell << std::fixed << std::setprecision(2) << row.meanUs[phase] << " / " << row.p99Us[phase];
+                out << std::setw(20) << cell.str();
+            }
+            out << std::setw(9) << std::setprecision(1) << row.tickShare * 100.0 << "%" << std::setw(12) << row.overBudget << "\n";
+        }
+    }
+};
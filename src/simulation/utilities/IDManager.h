@@ -19,7 +19,10 @@ public:
     }
 
     /// @brief Return current value of idCounter. Dont use it in id assignments
-    unsigned long getCurrentIdCounter() { return idCounter; }
+    unsigned long getCurrentIdCounter() const { return idCounter; }
+
+    /// @brief Continue assigning ids from given value. Used when world is loaded from snapshot
+    void restore(unsigned long idCounter_) { idCounter = idCounter_; }
 };
 
 class ObjectID {
@@ -40,5 +43,5 @@ public:
         }
     }
     /// @return ID value
-    unsigned long get() { return id; }
+    unsigned long get() const { return id; }
 };
\ No newline at end of file
@@ -0,0 +1,336 @@
+#include "Logger.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    /// @brief How often file sink drains queue
+    constexpr auto sinkPeriod = std::chrono::milliseconds(100);
+}
+
+Logger::Logger(size_t historyCapacity_)
+    : slots(std::make_unique<Slot[]>(queueCapacity)), historyCapacity(std::max<size_t>(historyCapacity_, 1))
+{
+    static_assert((queueCapacity & (queueCapacity - 1)) == 0, "Capacity of log queue must be power of two");
+    for (size_t i = 0; i < queueCapacity; i++)
+    {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+Logger::~Logger()
+{
+    if (sinkThread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(sinkMutex);
+            sinkStopping = true;
+        }
+        sinkWake.notify_all();
+        sinkThread.join();
+        drain();
+    }
+}
+
+void Logger::add(LogType level, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    addV(level, fmt, args);
+    va_end(args);
+}
+
+void Logger::addV(LogType level, const char *fmt, va_list args)
+{
+    if (!isEnabled(level))
+    {
+        return;
+    }
+    uint64_t position = enqueuePosition.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true)
+    {
+        slot = &slots[position & (queueCapacity - 1)];
+        const uint64_t sequence = slot->sequence.load(std::memory_order_acquire);
+        const int64_t difference = int64_t(sequence) - int64_t(position);
+        if (difference == 0)
+        {
+            if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // Consumer has not freed this slot yet, so queue is full
+            droppedMessages.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else
+        {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    slot->level = level;
+    std::vsnprintf(slot->text, sizeof(slot->text), fmt, args);
+    slot->sequence.store(position + 1, std::memory_order_release);
+    // File sink drains queue periodically, but when half of queue is used it is woken at once
+    if ((position & (queueCapacity / 2 - 1)) == queueCapacity / 2 - 1 && hasSink.load(std::memory_order_relaxed))
+    {
+        sinkWake.notify_one();
+    }
+}
+
+void Logger::drain()
+{
+    std::lock_guard<std::mutex> lock(consumerMutex);
+    drainLocked();
+}
+
+void Logger::drainLocked()
+{
+    while (true)
+    {
+        Slot &slot = slots[dequeuePosition & (queueCapacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1)
+        {
+            break;
+        }
+        // Every line of message is a line of log, empty ones (e.g. after trailing newline) are skipped
+        const char *begin = slot.text;
+        const char *end = begin + std::strlen(begin);
+        while (begin < end)
+        {
+            const char *lineEnd = static_cast<const char *>(std::memchr(begin, '\n', size_t(end - begin)));
+            if (!lineEnd)
+            {
+                lineEnd = end;
+            }
+            if (lineEnd > begin)
+            {
+                addLine(slot.level, begin, lineEnd);
+            }
+            begin = lineEnd + 1;
+        }
+        slot.sequence.store(dequeuePosition + queueCapacity, std::memory_order_release);
+        dequeuePosition++;
+    }
+    if (file.is_open())
+    {
+        file.flush();
+    }
+}
+
+void Logger::addLine(LogType level, const char *begin, const char *end)
+{
+    const char *prefix = level < LogTypesCount ? prefixes[level] : ".UNKNOWN. ";
+    const size_t index = endLine % historyCapacity;
+    if (index == history.size())
+    {
+        history.push_back(Line{level, std::string()});
+    }
+    Line &line = history[index];
+    line.level = level;
+    line.text.assign(prefix);
+    line.text.append(begin, end);
+    endLine++;
+    if (endLine - firstLine > historyCapacity)
+    {
+        firstLine = endLine - historyCapacity;
+    }
+
+    if (file.is_open())
+    {
+        file << line.text << '\n';
+    }
+}
+
+void Logger::clear()
+{
+    std::lock_guard<std::mutex> lock(consumerMutex);
+    firstLine = endLine;
+    filteredLines.clear();
+    filteredUntil = endLine;
+}
+
+void Logger::setFileSink(const std::string &path)
+{
+    {
+        std::lock_guard<std::mutex> lock(consumerMutex);
+        if (file.is_open())
+        {
+            throw std::runtime_error("Log already has file sink!");
+        }
+        file.open(path, std::ios::trunc);
+        if (!file)
+        {
+            throw std::runtime_error("Can't open log file for writing: " + path);
+        }
+    }
+    sinkThread = std::thread(&Logger::sinkLoop, this);
+    hasSink.store(true, std::memory_order_relaxed);
+}
+
+void Logger::sinkLoop()
+{
+    std::unique_lock<std::mutex> lock(sinkMutex);
+    while (!sinkStopping)
+    {
+        sinkWake.wait_for(lock, sinkPeriod);
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+size_t Logger::getLineCount() const
+{
+    std::lock_guard<std::mutex> lock(consumerMutex);
+    return size_t(endLine - firstLine);
+}
+
+size_t Logger::memoryBytes() const
+{
+    std::lock_guard<std::mutex> lock(consumerMutex);
+    size_t bytes = sizeof(Slot) * queueCapacity + history.capacity() * sizeof(Line) + filteredLines.size() * sizeof(uint64_t);
+    for (const auto &line : history)
+    {
+        // Short strings are stored inside std::string itself
+        if (line.text.capacity() > 15)
+        {
+            bytes += line.text.capacity() + 1;
+        }
+    }
+    return bytes;
+}
+
+bool Logger::isFiltered() const
+{
+    if (filter.IsActive())
+    {
+        return true;
+    }
+    for (bool shown : shownLevels)
+    {
+        if (!shown)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Logger::passesFilter(const Line &line) const
+{
+    return shownLevels[line.level] && filter.PassFilter(line.text.data(), line.text.data() + line.text.size());
+}
+
+void Logger::draw(const char *title, bool *p_open)
+{
+    if (!ImGui::Begin(title, p_open))
+    {
+        ImGui::End();
+        return;
+    }
+    std::lock_guard<std::mutex> lock(consumerMutex);
+    drainLocked();
+
+    bool filterChanged = false;
+    if (ImGui::BeginPopup("Options"))
+    {
+        ImGui::Checkbox("Auto-scroll", &autoScroll);
+        int level = getMinLevel();
+        if (ImGui::Combo("Minimal level", &level, "Log\0Warning\0Error\0"))
+        {
+            setMinLevel(LogType(level));
+        }
+        filterChanged |= ImGui::Checkbox("Show logs", &shownLevels[LOG]);
+        filterChanged |= ImGui::Checkbox("Show warnings", &shownLevels[WARNING]);
+        filterChanged |= ImGui::Checkbox("Show errors", &shownLevels[ERROR]);
+        ImGui::EndPopup();
+    }
+
+    if (ImGui::Button("Options"))
+        ImGui::OpenPopup("Options");
+    ImGui::SameLine();
+    const bool clearPressed = ImGui::Button("Clear");
+    ImGui::SameLine();
+    const bool copy = ImGui::Button("Copy");
+    ImGui::SameLine();
+    filterChanged |= filter.Draw("Filter", -100.0f);
+    ImGui::Text("%llu lines", static_cast<unsigned long long>(endLine - firstLine));
+    if (const uint64_t dropped = getDroppedMessages())
+    {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%llu messages dropped (queue was full)",
+                           static_cast<unsigned long long>(dropped));
+    }
+    ImGui::Separator();
+
+    if (clearPressed)
+    {
+        firstLine = endLine;
+        filteredLines.clear();
+        filteredUntil = endLine;
+    }
+
+    // Lines that left history are forgotten, only new lines are checked by filter
+    const bool filtered = isFiltered();
+    if (filtered)
+    {
+        if (filterChanged)
+        {
+            filteredLines.clear();
+            filteredUntil = firstLine;
+        }
+        while (!filteredLines.empty() && filteredLines.front() < firstLine)
+        {
+            filteredLines.pop_front();
+        }
+        for (uint64_t number = std::max(filteredUntil, firstLine); number < endLine; number++)
+        {
+            if (passesFilter(history[number % historyCapacity]))
+            {
+                filteredLines.push_back(number);
+            }
+        }
+        filteredUntil = endLine;
+    }
+    else
+    {
+        filteredLines.clear();
+        filteredUntil = firstLine;
+    }
+
+    if (ImGui::BeginChild("scrolling", ImVec2(0, 0), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar))
+    {
+        if (copy)
+            ImGui::LogToClipboard();
+
+        ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, 0));
+        const size_t count = filtered ? filteredLines.size() : size_t(endLine - firstLine);
+        ImGuiListClipper clipper;
+        clipper.Begin(int(count));
+        while (clipper.Step())
+        {
+            for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++)
+            {
+                const uint64_t number = filtered ? filteredLines[row] : firstLine + row;
+                const Line &line = history[number % historyCapacity];
+                ImGui::TextUnformatted(line.text.data(), line.text.data() + line.text.size());
+            }
+        }
+        clipper.End();
+        ImGui::PopStyleVar();
+
+        // Keep up at the bottom of the scroll region if we were already at the bottom at the beginning of the frame
+        if (autoScroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
+            ImGui::SetScrollHereY(1.0f);
+    }
+    ImGui::EndChild();
+    ImGui::End();
+}
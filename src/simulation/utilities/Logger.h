@@ -1,129 +1,133 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "imgui.h"
 
-// This class was copy-pasted from ImGui demo
-struct Logger
+/*
+ * Log of simulation that can be written from any thread.
+ *
+ * Message is formatted right into a slot of bounded lock-free queue (Vyukov's bounded queue, used
+ * with one consumer): writer claims slot by moving enqueue position with CAS and publishes it with
+ * sequence number of slot, so writers never wait for each other or for reader. Message of full queue
+ * is dropped and counted. Queue is drained by viewer (draw()) or by thread of file sink into history,
+ * ring of the last lines, so memory stays bounded on long runs.
+ *
+ * Viewer draws only visible lines (ImGuiListClipper), also when filtered: numbers of lines that pass
+ * filter are kept and only new lines are checked on next frames.
+ */
+class Logger
 {
-    enum LogType { LOG, WARNING, ERROR };
+public:
+    enum LogType : uint8_t
+    {
+        LOG,
+        WARNING,
+        ERROR,
+        LogTypesCount
+    };
+    static constexpr std::array<const char *, LogTypesCount> prefixes = {"(LOG) ", "[WARNING] ", "<ERROR> "};
 
-    ImGuiTextBuffer     Buf;
-    ImGuiTextFilter     Filter;
-    ImVector<int>       LineOffsets; // Index to lines offset. We maintain this with AddLog() calls.
-    bool                AutoScroll;  // Keep scrolling if already at the bottom.
+    /// @brief Messages waiting for consumer, power of two
+    static constexpr size_t queueCapacity = 1024;
+    /// @brief Longer messages are cut
+    static constexpr size_t maxMessageLength = 247;
+    static constexpr size_t defaultHistoryCapacity = 200000;
 
-    Logger()
+private:
+    struct Slot
     {
-        AutoScroll = true;
-        Clear();
-    }
+        std::atomic<uint64_t> sequence;
+        LogType level;
+        char text[maxMessageLength + 1];
+    };
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<uint64_t> enqueuePosition = 0;
+    std::atomic<uint64_t> droppedMessages = 0;
+    std::atomic<LogType> minLevel = LOG;
 
-    void    Clear()
+    struct Line
     {
-        Buf.clear();
-        LineOffsets.clear();
-        LineOffsets.push_back(0);
-    }
+        LogType level;
+        std::string text;
+    };
 
-    void    AddLog(const char* fmt, ...) IM_FMTARGS(2)
-    {
-        int old_size = Buf.size();
-        va_list args;
-        va_start(args, fmt);
-        Buf.appendfv(fmt, args);
-        va_end(args);
-        for (int new_size = Buf.size(); old_size < new_size; old_size++)
-            if (Buf[old_size] == '\n')
-                LineOffsets.push_back(old_size + 1);
-    }
-
-    void    Draw(const char* title, bool* p_open = NULL)
-    {
-        if (!ImGui::Begin(title, p_open))
-        {
-            ImGui::End();
-            return;
-        }
-
-        // Options menu
-        if (ImGui::BeginPopup("Options"))
-        {
-            ImGui::Checkbox("Auto-scroll", &AutoScroll);
-            ImGui::EndPopup();
-        }
-
-        // Main window
-        if (ImGui::Button("Options"))
-            ImGui::OpenPopup("Options");
-        ImGui::SameLine();
-        bool clear = ImGui::Button("Clear");
-        ImGui::SameLine();
-        bool copy = ImGui::Button("Copy");
-        ImGui::SameLine();
-        Filter.Draw("Filter", -100.0f);
-
-        ImGui::Separator();
-
-        if (ImGui::BeginChild("scrolling", ImVec2(0, 0), ImGuiChildFlags_None, ImGuiWindowFlags_HorizontalScrollbar))
-        {
-            if (clear)
-                Clear();
-            if (copy)
-                ImGui::LogToClipboard();
-
-            ImGui::PushStyleVar(ImGuiStyleVar_ItemSpacing, ImVec2(0, 0));
-            const char* buf = Buf.begin();
-            const char* buf_end = Buf.end();
-            if (Filter.IsActive())
-            {
-                // In this example we don't use the clipper when Filter is enabled.
-                // This is because we don't have random access to the result of our filter.
-                // A real application processing logs with ten of thousands of entries may want to store the result of
-                // search/filter.. especially if the filtering function is not trivial (e.g. reg-exp).
-                for (int line_no = 0; line_no < LineOffsets.Size; line_no++)
-                {
-                    const char* line_start = buf + LineOffsets[line_no];
-                    const char* line_end = (line_no + 1 < LineOffsets.Size) ? (buf + LineOffsets[line_no + 1] - 1) : buf_end;
-                    if (Filter.PassFilter(line_start, line_end))
-                        ImGui::TextUnformatted(line_start, line_end);
-                }
-            }
-            else
-            {
-                // The simplest and easy way to display the entire buffer:
-                //   ImGui::TextUnformatted(buf_begin, buf_end);
-                // And it'll just work. TextUnformatted() has specialization for large blob of text and will fast-forward
-                // to skip non-visible lines. Here we instead demonstrate using the clipper to only process lines that are
-                // within the visible area.
-                // If you have tens of thousands of items and their processing cost is non-negligible, coarse clipping them
-                // on your side is recommended. Using ImGuiListClipper requires
-                // - A) random access into your data
-                // - B) items all being the  same height,
-                // both of which we can handle since we have an array pointing to the beginning of each line of text.
-                // When using the filter (in the block of code above) we don't have random access into the data to display
-                // anymore, which is why we don't use the clipper. Storing or skimming through the search result would make
-                // it possible (and would be recommended if you want to search through tens of thousands of entries).
-                ImGuiListClipper clipper;
-                clipper.Begin(LineOffsets.Size);
-                while (clipper.Step())
-                {
-                    for (int line_no = clipper.DisplayStart; line_no < clipper.DisplayEnd; line_no++)
-                    {
-                        const char* line_start = buf + LineOffsets[line_no];
-                        const char* line_end = (line_no + 1 < LineOffsets.Size) ? (buf + LineOffsets[line_no + 1] - 1) : buf_end;
-                        ImGui::TextUnformatted(line_start, line_end);
-                    }
-                }
-                clipper.End();
-            }
-            ImGui::PopStyleVar();
-
-            // Keep up at the bottom of the scroll region if we were already at the bottom at the beginning of the frame.
-            // Using a scrollbar or mouse-wheel will take away from the bottom edge.
-            if (AutoScroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY())
-                ImGui::SetScrollHereY(1.0f);
-        }
-        ImGui::EndChild();
-        ImGui::End();
-    }
+    /// @brief Everything below is used only by consumer (drain(), draw(), file sink) under this mutex
+    mutable std::mutex consumerMutex;
+    uint64_t dequeuePosition = 0;
+    /// @brief Ring of lines, line number N is at N % historyCapacity
+    std::vector<Line> history;
+    size_t historyCapacity;
+    /// @brief Number of the first line in history and of the line after the last one
+    uint64_t firstLine = 0;
+    uint64_t endLine = 0;
+
+    ImGuiTextFilter filter;
+    std::array<bool, LogTypesCount> shownLevels = {true, true, true};
+    /// @brief Numbers of lines that pass filter, checked up to filteredUntil
+    std::deque<uint64_t> filteredLines;
+    uint64_t filteredUntil = 0;
+    bool autoScroll = true;
+
+    std::ofstream file;
+    std::thread sinkThread;
+    std::mutex sinkMutex;
+    std::condition_variable sinkWake;
+    bool sinkStopping = false;
+    std::atomic<bool> hasSink = false;
+
+    void drainLocked();
+    void addLine(LogType level, const char *begin, const char *end);
+    bool isFiltered() const;
+    bool passesFilter(const Line &line) const;
+    void sinkLoop();
+
+public:
+    explicit Logger(size_t historyCapacity_ = defaultHistoryCapacity);
+    /// @brief Stop file sink, writing the rest of queue to it
+    ~Logger();
+
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
+    /// @brief Check level before building expensive message. add() checks it too
+    bool isEnabled(LogType level) const { return level >= minLevel.load(std::memory_order_relaxed); }
+    void setMinLevel(LogType level) { minLevel.store(level, std::memory_order_relaxed); }
+    LogType getMinLevel() const { return minLevel.load(std::memory_order_relaxed); }
+
+    /// @brief Add message. Thread safe and lock-free. Every line of message becomes a line of log
+    void add(LogType level, const char *fmt, ...) IM_FMTARGS(3);
+    void addV(LogType level, const char *fmt, va_list args) IM_FMTLIST(3);
+
+    /// @brief Move queued messages to history (and file sink)
+    void drain();
+    /// @brief Forget history. Queued messages are kept
+    void clear();
+
+    /// @brief Also write every line to given file. Background thread drains queue then,
+    /// so log is written without viewer too
+    /// @throw std::runtime_error if file cant be opened or sink is already set
+    void setFileSink(const std::string &path);
+
+    /// @brief Messages lost because queue was full
+    uint64_t getDroppedMessages() const { return droppedMessages.load(std::memory_order_relaxed); }
+    /// @brief Number of lines in history
+    size_t getLineCount() const;
+
+    /// @brief Memory used by queue and history
+    size_t memoryBytes() const;
+
+    /// @brief Draw viewer, draining queue first
+    void draw(const char *title, bool *p_open = nullptr);
 };
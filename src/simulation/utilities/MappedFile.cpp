@@ -0,0 +1,90 @@
+#include "MappedFile.h"
+
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_SUPPORTED 1
+#endif
+
+#ifdef MAPPED_FILE_SUPPORTED
+
+MappedFile::MappedFile(const std::string &path)
+{
+    const int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptor < 0)
+    {
+        throw std::runtime_error("Can't open file " + path + ": " + std::strerror(errno));
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0)
+    {
+        const int error = errno;
+        ::close(descriptor);
+        throw std::runtime_error("Can't read size of file " + path + ": " + std::strerror(error));
+    }
+    mappedSize = size_t(info.st_size);
+    if (mappedSize == 0)
+    {
+        // Empty file can't be mapped, empty buffer is used instead
+        ::close(descriptor);
+        return;
+    }
+
+    void *address = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    const int error = errno;
+    // Mapping stays valid after descriptor is closed
+    ::close(descriptor);
+    if (address == MAP_FAILED)
+    {
+        mappedSize = 0;
+        throw std::runtime_error("Can't map file " + path + ": " + std::strerror(error));
+    }
+    mapped = static_cast<const char *>(address);
+}
+
+MappedFile::~MappedFile()
+{
+    if (mapped)
+    {
+        munmap(const_cast<char *>(mapped), mappedSize);
+    }
+}
+
+void MappedFile::prefetch() const
+{
+    if (mapped)
+    {
+        madvise(const_cast<char *>(mapped), mappedSize, MADV_WILLNEED);
+    }
+}
+
+#else
+
+#include <fstream>
+
+MappedFile::MappedFile(const std::string &path)
+{
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in)
+    {
+        throw std::runtime_error("Can't open file " + path);
+    }
+    buffer.resize(size_t(in.tellg()));
+    in.seekg(0);
+    if (!in.read(buffer.data(), std::streamsize(buffer.size())))
+    {
+        throw std::runtime_error("Can't read file " + path);
+    }
+}
+
+MappedFile::~MappedFile() {}
+
+void MappedFile::prefetch() const {}
+
+#endif
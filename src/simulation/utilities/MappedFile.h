@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// @brief Read-only view of whole file. On POSIX systems file is mapped to memory privately,
+/// so pages are loaded on first access, shared with page cache and never written back.
+/// On other systems file is read to memory.
+class MappedFile
+{
+private:
+    const char *mapped = nullptr;
+    size_t mappedSize = 0;
+    /// @brief Content of file when it can't be mapped
+    std::vector<char> buffer;
+
+public:
+    MappedFile() = default;
+    /// @throw std::runtime_error if file can't be opened or mapped
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *data() const { return mapped ? mapped : buffer.data(); }
+    size_t size() const { return mapped ? mappedSize : buffer.size(); }
+    bool isMapped() const { return mapped != nullptr; }
+
+    /// @brief Tell system that whole file will be read soon, so it can start reading it ahead
+    void prefetch() const;
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <cstdio>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// @brief Estimated memory used by simulation, grouped by object type and subsystem.
+/// Sizes are computed from sizeof() and capacities of containers, so allocator overhead is not included.
+/// Collected on demand by Simulation::collectMemoryStats(), it walks all objects.
+class MemoryStats
+{
+public:
+    enum Category
+    {
+        BotObjects,
+        FoodObjects,
+        TreeObjects,
+        OtherObjects,
+        /// @brief ShadowSimulationObject every object has in SimulationObject
+        BaseShadows,
+        BotShadows,
+        FoodShadows,
+        TreeShadows,
+        /// @brief ProtocolsHolder of bots with visible* sets
+        ProtocolBuffers,
+        /// @brief Chunks with their object sets
+        ChunkContainers,
+        /// @brief Object list of simulation, death note and other per tick lists
+        ObjectLists,
+        /// @brief Reused buffers of batched bot updates
+        BatchBuffers,
+        ProfilerBuffers,
+        LoggerBuffer,
+        /// @brief Cached noise of map (Simulation::getNoiseField())
+        NoiseFieldCache,
+        /// @brief Calories of chunks (Simulation::foodField)
+        FoodFieldCells,
+        CategoriesCount
+    };
+    static constexpr std::array<const char *, CategoriesCount> categoryNames = {
+        "Bot objects", "Food objects", "Tree objects", "Other objects", "Base shadows", "Bot shadows",
+        "Food shadows", "Tree shadows", "Protocol buffers", "Chunk containers", "Object lists",
+        "Batch buffers", "Profiler buffers", "Logger buffer", "Noise field", "Food field"};
+
+    struct Entry
+    {
+        size_t count = 0;
+        size_t bytes = 0;
+    };
+
+    /// @brief Size of one type for layout report
+    struct TypeSize
+    {
+        const char *name;
+        size_t bytes;
+    };
+
+    /// @brief Control block of std::make_shared (virtual table pointer, use and weak counters)
+    static constexpr size_t sharedControlBlockBytes = 2 * sizeof(void *);
+
+    std::array<Entry, CategoriesCount> entries{};
+
+    void add(Category category, size_t bytes, size_t count = 1)
+    {
+        entries[category].count += count;
+        entries[category].bytes += bytes;
+    }
+
+    size_t totalBytes() const
+    {
+        size_t total = 0;
+        for (const auto &entry : entries)
+        {
+            total += entry.bytes;
+        }
+        return total;
+    }
+
+    /// @brief Size of object created with std::make_shared
+    template <typename T>
+    static constexpr size_t sharedObjectBytes() { return sizeof(T) + sharedControlBlockBytes; }
+
+    /// @brief Heap memory of string. Short strings are stored inside std::string itself
+    static size_t stringBytes(const std::string &text)
+    {
+        return text.capacity() > std::string().capacity() ? text.capacity() + 1 : 0;
+    }
+
+    template <typename T>
+    static size_t vectorBytes(const std::vector<T> &vector) { return vector.capacity() * sizeof(T); }
+
+    /// @brief Heap memory of unordered set: bucket array and one node (next pointer, value, cached hash) per element
+    template <typename Set>
+    static size_t hashSetBytes(const Set &set)
+    {
+        return set.bucket_count() * sizeof(void *) +
+               set.size() * (sizeof(void *) + sizeof(typename Set::value_type) + sizeof(size_t));
+    }
+
+    static std::string formatBytes(double bytes)
+    {
+        const char *units[] = {"B", "KB", "MB", "GB"};
+        int unit = 0;
+        while (bytes >= 1024.0 && unit < 3)
+        {
+            bytes /= 1024.0;
+            unit++;
+        }
+        char text[32];
+        std::snprintf(text, sizeof(text), unit == 0 ? "%.0f %s" : "%.2f %s", bytes, units[unit]);
+        return text;
+    }
+
+    /// @brief Print table of categories (for headless runs)
+    void print(std::ostream &out) const
+    {
+        out << "Memory (estimated), total " << formatBytes(double(totalBytes())) << "\n";
+        out << std::left << std::setw(20) << "Category" << std::right << std::setw(12) << "Count"
+            << std::setw(14) << "Bytes" << std::setw(12) << "Per item" << "\n";
+        for (int category = 0; category < CategoriesCount; category++)
+        {
+            const Entry &entry = entries[category];
+            out << std::left << std::setw(20) << categoryNames[category] << std::right << std::setw(12) << entry.count
+                << std::setw(14) << formatBytes(double(entry.bytes))
+                << std::setw(12) << (entry.count ? formatBytes(double(entry.bytes) / entry.count) : std::string("-")) << "\n";
+        }
+    }
+
+    /// @brief Print sizes of types (see Simulation::getObjectLayout())
+    static void printLayout(std::ostream &out, const std::vector<TypeSize> &layout)
+    {
+        out << "Object layout (sizeof, bytes)\n";
+        for (const auto &type : layout)
+        {
+            out << "  " << std::left << std::setw(28) << type.name << std::right << std::setw(8) << type.bytes << "\n";
+        }
+    }
+};
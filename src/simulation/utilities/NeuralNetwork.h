@@ -0,0 +1,182 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define NEURAL_NETWORK_SIMD_AVX
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define NEURAL_NETWORK_SIMD_SSE
+#endif
+
+/// @brief Weights of fully connected network stored in one contiguous arena.
+/// Layout of each layer in arena: weights [outputs][inputs] followed by biases [outputs].
+/// Network is evaluated for whole batch at once with matrices in feature-major layout:
+/// value of feature f for sample b is stored at matrix[f * stride + b], so the innermost
+/// loop goes over samples and is vectorised across them.
+class NeuralWeights
+{
+public:
+    struct Layer
+    {
+        int inputs;
+        int outputs;
+        /// @brief Offset of layer weights in arena
+        size_t offset;
+        /// @brief Apply ReLU after layer. Last layer is always linear
+        bool relu;
+    };
+
+    /// @brief Batch stride must be multiple of this value
+    static constexpr int batchAlignment = 8;
+    /// @brief Number of samples processed at once. Keep working set of one tile in cache
+    static constexpr int batchTile = 256;
+
+private:
+    std::vector<Layer> layers;
+    std::vector<float> arena;
+    int maxLayerSize = 0;
+
+    /// @brief y[0..n) += weight * x[0..n). n must be multiple of batchAlignment
+    static void multiplyAdd(float weight, const float *__restrict x, float *__restrict y, int n)
+    {
+#if defined(NEURAL_NETWORK_SIMD_AVX)
+        const __m256 w = _mm256_set1_ps(weight);
+        for (int i = 0; i < n; i += 8)
+        {
+            _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_mul_ps(w, _mm256_loadu_ps(x + i))));
+        }
+#elif defined(NEURAL_NETWORK_SIMD_SSE)
+        const __m128 w = _mm_set1_ps(weight);
+        for (int i = 0; i < n; i += 4)
+        {
+            _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y + i), _mm_mul_ps(w, _mm_loadu_ps(x + i))));
+        }
+#else
+        for (int i = 0; i < n; i++)
+        {
+            y[i] += weight * x[i];
+        }
+#endif
+    }
+
+    static void relu(float *__restrict y, int n)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            y[i] = std::max(0.0f, y[i]);
+        }
+    }
+
+public:
+    /// @brief Create network with given layer sizes and random weights
+    /// @param layerSizes Sizes of layers including input and output layers, e.g. {13, 16, 6}
+    /// @param seed Seed of weights initialization
+    NeuralWeights(const std::vector<int> &layerSizes, unsigned int seed = 0)
+    {
+        if (layerSizes.size() < 2)
+        {
+            throw std::invalid_argument("Neural network must have at least input and output layers!");
+        }
+        size_t offset = 0;
+        for (size_t i = 0; i + 1 < layerSizes.size(); i++)
+        {
+            layers.push_back(Layer{layerSizes[i], layerSizes[i + 1], offset, i + 2 < layerSizes.size()});
+            offset += size_t(layerSizes[i] + 1) * layerSizes[i + 1];
+        }
+        for (int size : layerSizes)
+        {
+            maxLayerSize = std::max(maxLayerSize, size);
+        }
+        arena.resize(offset);
+
+        // Xavier initialization
+        std::mt19937 gen(seed);
+        for (const auto &layer : layers)
+        {
+            std::normal_distribution<float> dist(0.0f, std::sqrt(2.0f / float(layer.inputs + layer.outputs)));
+            float *weights = arena.data() + layer.offset;
+            for (int i = 0; i < layer.inputs * layer.outputs; i++)
+            {
+                weights[i] = dist(gen);
+            }
+            std::fill(weights + layer.inputs * layer.outputs, weights + (layer.inputs + 1) * layer.outputs, 0.0f);
+        }
+    }
+
+    int inputSize() const { return layers.front().inputs; }
+    int outputSize() const { return layers.back().outputs; }
+    const std::vector<Layer> &getLayers() const { return layers; }
+
+    /// @brief Number of floats in arena (all weights and biases)
+    size_t parameterCount() const { return arena.size(); }
+    float *parameters() { return arena.data(); }
+    const float *parameters() const { return arena.data(); }
+
+    /// @return Smallest stride that is >= batchSize and aligned to batchAlignment
+    static int paddedBatchSize(int batchSize)
+    {
+        return (batchSize + batchAlignment - 1) / batchAlignment * batchAlignment;
+    }
+
+    /// @brief Evaluate network for whole batch
+    /// @param input Matrix [inputSize()][stride]
+    /// @param stride Row length of input and output matrices. Must be padded with paddedBatchSize()
+    /// @param output Matrix [outputSize()][stride]
+    /// @param scratch Buffer for intermediate layers. Resized if needed, reuse it between calls
+    void forwardBatch(const float *input, int stride, float *output, std::vector<float> &scratch) const
+    {
+        if (stride % batchAlignment != 0)
+        {
+            throw std::invalid_argument("Batch stride must be multiple of NeuralWeights::batchAlignment!");
+        }
+        const size_t layerBufferSize = size_t(maxLayerSize) * batchTile;
+        if (scratch.size() < layerBufferSize * 2)
+        {
+            scratch.resize(layerBufferSize * 2);
+        }
+
+        for (int tileStart = 0; tileStart < stride; tileStart += batchTile)
+        {
+            const int tileSize = std::min(batchTile, stride - tileStart);
+
+            // Tile of input is read directly from input matrix, intermediate layers use ping-pong buffers
+            const float *layerInput = input + tileStart;
+            int layerInputStride = stride;
+            float *buffers[2] = {scratch.data(), scratch.data() + layerBufferSize};
+
+            for (size_t l = 0; l < layers.size(); l++)
+            {
+                const Layer &layer = layers[l];
+                const bool isLast = l + 1 == layers.size();
+                float *layerOutput = isLast ? output + tileStart : buffers[l % 2];
+                const int layerOutputStride = isLast ? stride : batchTile;
+
+                const float *weights = arena.data() + layer.offset;
+                const float *biases = weights + size_t(layer.inputs) * layer.outputs;
+                for (int o = 0; o < layer.outputs; o++)
+                {
+                    float *y = layerOutput + size_t(o) * layerOutputStride;
+                    std::fill(y, y + tileSize, biases[o]);
+                    for (int i = 0; i < layer.inputs; i++)
+                    {
+                        multiplyAdd(weights[size_t(o) * layer.inputs + i], layerInput + size_t(i) * layerInputStride, y, tileSize);
+                    }
+                    if (layer.relu)
+                    {
+                        relu(y, tileSize);
+                    }
+                }
+
+                layerInput = layerOutput;
+                layerInputStride = layerOutputStride;
+            }
+        }
+    }
+};
@@ -0,0 +1,93 @@
+#include "NoiseField.h"
+
+#include <algorithm>
+
+#include "utilities/PerlinNoise2D.h"
+#include "utilities/ThreadPool.h"
+
+void NoiseField::noiseRow(const PerlinNoise2D &noise, int y, float scale, int xBegin, int count, float *out)
+{
+    // Coordinates are not negative, so conversion to int is floor
+    const float fy = float(y) * scale;
+    const int y0 = int(fy);
+    const float dy0 = fy - float(y0);
+    const float dy1 = fy - float(y0 + 1);
+    const float v = PerlinNoise2D::fade(dy0);
+    const int rowHash0 = noise.permutation[y0 & 255];
+    const int rowHash1 = noise.permutation[(y0 + 1) & 255];
+    const float *gradientX = noise.gradientX.data();
+    const float *gradientY = noise.gradientY.data();
+
+    alignas(32) float dx0[tileWidth], dx1[tileWidth];
+    alignas(32) float g00x[tileWidth], g00y[tileWidth], g10x[tileWidth], g10y[tileWidth];
+    alignas(32) float g01x[tileWidth], g01y[tileWidth], g11x[tileWidth], g11y[tileWidth];
+    for (int start = 0; start < count; start += tileWidth)
+    {
+        const int cells = std::min(tileWidth, count - start);
+        // Gradient lookups are gathers, they stay scalar
+        for (int i = 0; i < cells; i++)
+        {
+            const float x = float(xBegin + start + i) * scale;
+            const int x0 = int(x);
+            dx0[i] = x - float(x0);
+            dx1[i] = x - float(x0 + 1);
+            const int column0 = x0 & 255;
+            const int column1 = (x0 + 1) & 255;
+            g00x[i] = gradientX[column0 + rowHash0];
+            g00y[i] = gradientY[column0 + rowHash0];
+            g10x[i] = gradientX[column1 + rowHash0];
+            g10y[i] = gradientY[column1 + rowHash0];
+            g01x[i] = gradientX[column0 + rowHash1];
+            g01y[i] = gradientY[column0 + rowHash1];
+            g11x[i] = gradientX[column1 + rowHash1];
+            g11y[i] = gradientY[column1 + rowHash1];
+        }
+        // The rest is the same arithmetic for every cell, in the order of PerlinNoise2D::getValue()
+        float *tile = out + start;
+        for (int i = 0; i < cells; i++)
+        {
+            const float n00 = g00x[i] * dx0[i] + g00y[i] * dy0;
+            const float n10 = g10x[i] * dx1[i] + g10y[i] * dy0;
+            const float n01 = g01x[i] * dx0[i] + g01y[i] * dy1;
+            const float n11 = g11x[i] * dx1[i] + g11y[i] * dy1;
+            const float u = PerlinNoise2D::fade(dx0[i]);
+            const float nx0 = PerlinNoise2D::lerp(n00, n10, u);
+            const float nx1 = PerlinNoise2D::lerp(n01, n11, u);
+            tile[i] = PerlinNoise2D::lerp(nx0, nx1, v);
+        }
+    }
+}
+
+NoiseField NoiseField::generate(const PerlinNoise2D &noise, int width, int height,
+                                float positiveScale, float negativeScale, ThreadPool &pool)
+{
+    NoiseField field;
+    field.width = std::max(width, 0);
+    field.height = std::max(height, 0);
+    field.values.resize(size_t(field.width) * field.height);
+
+    const size_t tasks = size_t(field.height + rowsPerTask - 1) / rowsPerTask;
+    pool.parallelFor(tasks, [&](size_t task)
+    {
+        std::vector<float> negative(field.width);
+        const int end = std::min(field.height, int(task + 1) * rowsPerTask);
+        for (int y = int(task) * rowsPerTask; y < end; y++)
+        {
+            float *row = field.values.data() + size_t(y) * field.width;
+            noiseRow(noise, y, positiveScale, 0, field.width, row);
+            noiseRow(noise, y, negativeScale, 0, field.width, negative.data());
+            for (int x = 0; x < field.width; x++)
+            {
+                row[x] = std::clamp(row[x] - negative[x], 0.0f, 1.0f);
+            }
+        }
+    });
+    return field;
+}
+
+NoiseField NoiseField::generate(const PerlinNoise2D &noise, int width, int height,
+                                float positiveScale, float negativeScale, size_t threads)
+{
+    ThreadPool pool(threads);
+    return generate(noise, width, height, positiveScale, negativeScale, pool);
+}
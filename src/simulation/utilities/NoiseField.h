@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+class PerlinNoise2D;
+class ThreadPool;
+
+/// @brief Noise value of every unit cell of map: clamp(noise(x * positiveScale, y * positiveScale) -
+/// noise(x * negativeScale, y * negativeScale), 0, 1), as Simulation::generateTree() uses it.
+/// Rows are filled by several threads, inside a row gradients are looked up for a tile of cells first
+/// and then all arithmetic runs over arrays, so compiler vectorises it across x.
+/// Values are identical to PerlinNoise2D::getValue() for the same coordinates.
+class NoiseField
+{
+private:
+    int width = 0;
+    int height = 0;
+    /// @brief Row-major, y * width + x
+    std::vector<float> values;
+
+public:
+    /// @brief Cells of one tile of row
+    static constexpr int tileWidth = 64;
+    /// @brief Rows given to one task of thread pool
+    static constexpr int rowsPerTask = 16;
+
+    NoiseField() = default;
+
+    static NoiseField generate(const PerlinNoise2D &noise, int width, int height,
+                               float positiveScale, float negativeScale, ThreadPool &pool);
+    /// @param threads Number of threads. If 0, use number of hardware threads
+    static NoiseField generate(const PerlinNoise2D &noise, int width, int height,
+                               float positiveScale, float negativeScale, size_t threads = 0);
+
+    /// @brief Write noise.getValue(x * scale, y * scale) for x in [xBegin, xBegin + count) to out.
+    /// Coordinates must not be negative
+    static void noiseRow(const PerlinNoise2D &noise, int y, float scale, int xBegin, int count, float *out);
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    bool empty() const { return values.empty(); }
+    float at(int x, int y) const { return values[size_t(y) * width + x]; }
+    const float *row(int y) const { return values.data() + size_t(y) * width; }
+    size_t memoryBytes() const { return values.capacity() * sizeof(float); }
+};
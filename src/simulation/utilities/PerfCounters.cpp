@@ -0,0 +1,156 @@
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+PerfCounters::PerfCounters()
+{
+    descriptors.fill(-1);
+    readIndex.fill(-1);
+}
+
+PerfCounters::~PerfCounters()
+{
+    close();
+}
+
+#ifdef __linux__
+
+namespace
+{
+    struct CounterConfig
+    {
+        uint32_t type;
+        uint64_t config;
+    };
+
+    constexpr std::array<CounterConfig, PerfCounters::CountersCount> counterConfigs = {{
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    }};
+
+    int openCounter(const CounterConfig &counter, int groupLeader)
+    {
+        perf_event_attr attributes;
+        std::memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = counter.type;
+        attributes.config = counter.config;
+        attributes.disabled = groupLeader == -1 ? 1 : 0;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+        attributes.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        // Calling thread on any CPU
+        return int(syscall(SYS_perf_event_open, &attributes, 0, -1, groupLeader, 0));
+    }
+}
+
+bool PerfCounters::open()
+{
+    close();
+    int firstErrno = 0;
+    for (int counter = 0; counter < CountersCount; counter++)
+    {
+        const int descriptor = openCounter(counterConfigs[counter], leader);
+        if (descriptor < 0)
+        {
+            if (error.empty())
+            {
+                firstErrno = errno;
+                error = std::string(counterNames[counter]) + ": " + std::strerror(errno);
+            }
+            continue;
+        }
+        if (leader == -1)
+        {
+            leader = descriptor;
+        }
+        descriptors[counter] = descriptor;
+        readIndex[counter] = opened++;
+    }
+
+    if (leader == -1)
+    {
+        error = "perf_event_open failed (" + error + ")";
+        if (firstErrno == EACCES || firstErrno == EPERM)
+        {
+            error += ", check kernel.perf_event_paranoid";
+        }
+        else if (firstErrno == ENOENT || firstErrno == EOPNOTSUPP)
+        {
+            error += ", CPU or virtual machine has no hardware counters";
+        }
+        return false;
+    }
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    return true;
+}
+
+void PerfCounters::close()
+{
+    for (int &descriptor : descriptors)
+    {
+        if (descriptor >= 0)
+        {
+            ::close(descriptor);
+            descriptor = -1;
+        }
+    }
+    readIndex.fill(-1);
+    leader = -1;
+    opened = 0;
+    error.clear();
+}
+
+PerfCounters::Values PerfCounters::read() const
+{
+    Values values{};
+    if (leader < 0)
+    {
+        return values;
+    }
+    // Layout of PERF_FORMAT_GROUP read: number of values, time enabled, time running, values
+    std::array<uint64_t, 3 + CountersCount> buffer{};
+    if (::read(leader, buffer.data(), sizeof(buffer)) < ssize_t(3 * sizeof(uint64_t)))
+    {
+        return values;
+    }
+    const uint64_t timeEnabled = buffer[1];
+    const uint64_t timeRunning = buffer[2];
+    const double scale = timeRunning > 0 && timeRunning < timeEnabled ? double(timeEnabled) / timeRunning : 1.0;
+    for (int counter = 0; counter < CountersCount; counter++)
+    {
+        if (readIndex[counter] >= 0 && uint64_t(readIndex[counter]) < buffer[0])
+        {
+            values[counter] = uint64_t(buffer[3 + readIndex[counter]] * scale);
+        }
+    }
+    return values;
+}
+
+#else
+
+bool PerfCounters::open()
+{
+    error = "Hardware counters are supported only on Linux";
+    return false;
+}
+
+void PerfCounters::close() {}
+
+PerfCounters::Values PerfCounters::read() const
+{
+    return Values{};
+}
+
+#endif
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/// @brief Hardware performance counters of calling thread (Linux perf_event_open).
+/// Counters are opened as one group, so all of them are read with one system call.
+/// If kernel, CPU or permissions (kernel.perf_event_paranoid) dont allow some counter, it is skipped,
+/// if none can be opened, isAvailable() is false and getError() tells why.
+class PerfCounters
+{
+public:
+    enum Counter
+    {
+        Cycles,
+        Instructions,
+        L1DMisses,
+        LLCMisses,
+        BranchMisses,
+        CountersCount
+    };
+    static constexpr std::array<const char *, CountersCount> counterNames = {
+        "Cycles", "Instructions", "L1D misses", "LLC misses", "Branch misses"};
+
+    using Values = std::array<uint64_t, CountersCount>;
+
+private:
+    /// @brief File descriptor of each counter, -1 if counter is not opened. First opened one is group leader
+    std::array<int, CountersCount> descriptors;
+    /// @brief Position of value of each counter in group read
+    std::array<int, CountersCount> readIndex;
+    int leader = -1;
+    int opened = 0;
+    std::string error;
+
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters &) = delete;
+    PerfCounters &operator=(const PerfCounters &) = delete;
+
+    /// @brief Open counters for calling thread. Only this thread is measured
+    /// @return True if at least one counter was opened
+    bool open();
+    void close();
+
+    bool isAvailable() const { return opened > 0; }
+    bool has(Counter counter) const { return descriptors[counter] >= 0; }
+    const std::string &getError() const { return error; }
+
+    /// @brief Read current values of counters since open(). Values of not opened counters are 0.
+    /// Values are scaled if kernel had to multiplex counters
+    Values read() const;
+};
@@ -1,19 +1,31 @@
-#include <cmath>    // For std::lerp
+#pragma once
+
+#include <array>
+#include <cmath>
 #include <vector>
 #include <random>
 #include <algorithm>
 #include <numeric>   // For std::iota
 
+#include "utilities/RandomService.h"
+
 /// @class PerlinNoise2D
 /// @brief A class to compute 2D Perlin noise values.
 class PerlinNoise2D {
 private:
+    friend class NoiseField;
+
     /// @brief Gradient vectors used for Perlin noise computation.
     static const int grad2[8][2];
 
     /// @brief Permutation table for gradient selection.
     std::vector<int> permutation;
 
+    /// @brief Gradient of grid point by its hash (ix & 255) + permutation[iy & 255], precomputed from
+    /// grad2 so lookup has no modulo. NoiseField reads them too, so both give identical values
+    std::array<float, 512> gradientX;
+    std::array<float, 512> gradientY;
+
     /// @brief Smoothstep interpolation function.
     /// @param t The input value (should be in [0, 1]).
     /// @return The smoothed value.
@@ -28,32 +40,35 @@ private:
     /// @param y The y-coordinate of the input point.
     /// @return The dot product value.
     float dotGridGradient(int ix, int iy, float x, float y) const {
-        // Determine gradient index using the permutation table.
-        int gradientIndex = permutation[(ix + permutation[iy % 256]) % 256] % 8;
-
-        // Retrieve the gradient vector.
-        const int* gradient = grad2[gradientIndex];
+        // Determine gradient using the permutation table. Table is duplicated, so sum of two indices is valid
+        const int hash = (ix & 255) + permutation[iy & 255];
 
         // Compute distance vector.
         float dx = x - ix;
         float dy = y - iy;
 
         // Compute and return the dot product.
-        return (gradient[0] * dx + gradient[1] * dy);
+        return gradientX[hash] * dx + gradientY[hash] * dy;
+    }
+
+    /// @brief Linear interpolation in the form NoiseField uses (std::lerp gives other rounding)
+    static float lerp(float a, float b, float t) {
+        return a + t * (b - a);
     }
 
     /// @brief Generates the permutation table.
+    /// @param random Stream the table is shuffled with
     /// @return A vector containing the permutation table (duplicated to handle wraparound).
-    static std::vector<int> generatePermutation() {
+    static std::vector<int> generatePermutation(RandomStream random) {
         std::vector<int> p(256);
 
         // Fill with values 0 to 255.
         std::iota(p.begin(), p.end(), 0);
 
-        // Shuffle the values to create randomness.
-        std::random_device rd;
-        std::mt19937 g(rd());
-        std::shuffle(p.begin(), p.end(), g);
+        // Fisher-Yates shuffle, unlike std::shuffle it gives the same table with every standard library
+        for (int i = int(p.size()) - 1; i > 0; i--) {
+            std::swap(p[i], p[random.range(0, i)]);
+        }
 
         // Duplicate the table to avoid overflow during indexing.
         p.insert(p.end(), p.begin(), p.end());
@@ -63,7 +78,14 @@ private:
 
 public:
     /// @brief Constructor that initializes the permutation table.
-    PerlinNoise2D() : permutation(generatePermutation()) {}
+    /// @param random Stream of simulation random service, the same stream gives the same noise
+    explicit PerlinNoise2D(RandomStream random) : permutation(generatePermutation(random)) {
+        for (size_t hash = 0; hash < gradientX.size(); hash++) {
+            const int* gradient = grad2[permutation[hash] % 8];
+            gradientX[hash] = float(gradient[0]);
+            gradientY[hash] = float(gradient[1]);
+        }
+    }
 
     /// @brief Computes 2D Perlin noise value at a given point.
     /// @param x The x-coordinate of the input point.
@@ -91,16 +113,16 @@ public:
         float n11 = dotGridGradient(x1, y1, x, y);
 
         // Interpolate along x for the bottom and top edges of the cell.
-        float nx0 = std::lerp(n00, n10, u); // Bottom edge interpolation.
-        float nx1 = std::lerp(n01, n11, u); // Top edge interpolation.
+        float nx0 = lerp(n00, n10, u); // Bottom edge interpolation.
+        float nx1 = lerp(n01, n11, u); // Top edge interpolation.
 
         // Interpolate along y for the final result.
-        return std::lerp(nx0, nx1, v);
+        return lerp(nx0, nx1, v);
     }
 };
 
-// Define the gradient vectors.
-const int PerlinNoise2D::grad2[8][2] = {
+// Define the gradient vectors. Inline, so header can be included by several translation units
+inline const int PerlinNoise2D::grad2[8][2] = {
     {1, 1}, {-1, 1}, {1, -1}, {-1, -1},
     {1, 0}, {-1, 0}, {0, 1}, {0, -1}
 };
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+/*
+ * Counter-based random numbers (Philox4x32-10, Salmon et al. "Parallel random numbers: as easy as 1, 2, 3").
+ * Block of four numbers is a pure function of 128-bit counter and 64-bit key, so there is no shared
+ * state to lock or to save: the same seed, purpose, key and tick always give the same stream,
+ * whichever thread and in whichever order asks for it.
+ */
+
+/// @brief Philox4x32 with 10 rounds
+class Philox4x32
+{
+public:
+    using Counter = std::array<uint32_t, 4>;
+    using Key = std::array<uint32_t, 2>;
+
+    static Counter generate(Counter counter, Key key)
+    {
+        for (int round = 0; round < 10; round++)
+        {
+            const uint64_t product0 = uint64_t(multiplier0) * counter[0];
+            const uint64_t product1 = uint64_t(multiplier1) * counter[2];
+            counter = {uint32_t(product1 >> 32) ^ counter[1] ^ key[0], uint32_t(product1),
+                       uint32_t(product0 >> 32) ^ counter[3] ^ key[1], uint32_t(product0)};
+            key[0] += weyl0;
+            key[1] += weyl1;
+        }
+        return counter;
+    }
+
+private:
+    static constexpr uint32_t multiplier0 = 0xD2511F53;
+    static constexpr uint32_t multiplier1 = 0xCD9E8D57;
+    static constexpr uint32_t weyl0 = 0x9E3779B9;
+    static constexpr uint32_t weyl1 = 0xBB67AE85;
+};
+
+/// @brief Stream of random numbers given by RandomService. Cheap to create and copy, satisfies
+/// UniformRandomBitGenerator, so it works with standard distributions too (but their results differ
+/// between standard libraries, uniform() and range() dont)
+class RandomStream
+{
+private:
+    Philox4x32::Key key;
+    Philox4x32::Counter counter;
+    Philox4x32::Counter block{};
+    int used = 4;
+
+public:
+    using result_type = uint32_t;
+
+    RandomStream(Philox4x32::Key key_, Philox4x32::Counter counter_) : key(key_), counter(counter_) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()()
+    {
+        if (used == 4)
+        {
+            block = Philox4x32::generate(counter, key);
+            counter[0]++;
+            used = 0;
+        }
+        return block[used++];
+    }
+
+    /// @brief Uniform value in [0, 1)
+    float uniform() { return float((*this)() >> 8) * 0x1.0p-24f; }
+
+    /// @brief Uniform value in [0, 1) with 53 random bits, takes two numbers of stream
+    double uniformDouble()
+    {
+        const uint64_t high = (*this)() >> 5;
+        const uint64_t low = (*this)() >> 6;
+        return double(high << 26 | low) * 0x1.0p-53;
+    }
+
+    /// @brief Uniform integer in [min, max]. Multiply-shift, bias is below (max - min) / 2^32
+    int range(int min, int max)
+    {
+        const uint64_t span = uint64_t(int64_t(max) - int64_t(min)) + 1;
+        return int(int64_t(min) + int64_t((uint64_t((*this)()) * span) >> 32));
+    }
+};
+
+/// @brief Random numbers of simulation. Every random decision takes its own stream by purpose,
+/// key (chunk index, object id, ...) and tick, so objects and chunks can be updated in parallel
+/// and result stays the same for the same master seed (SimulationSettings::seed)
+class RandomService
+{
+public:
+    /// @brief What stream is used for. Streams of different purposes never overlap
+    enum Purpose : uint8_t
+    {
+        FoodSpawn,
+        TreeGeneration,
+        BotSpawn,
+        BrainContextSeed,
+        /// @brief Free for objects: key is object id
+        Objects,
+        /// @brief Positions of food taken from FoodField, key is chunk index
+        FoodFieldSpawn,
+        /// @brief Which chunks spawn food on tick, key is 0
+        FoodSpawnChunks,
+        /// @brief Random events of chunk effects, key is bot id
+        ChunkEvents,
+    };
+
+private:
+    uint64_t seed;
+
+public:
+    explicit RandomService(uint64_t seed_) : seed(seed_) {}
+
+    uint64_t getSeed() const { return seed; }
+
+    /// @param key Part of world the stream belongs to, lower 56 bits are used
+    /// @param tick Tick of simulation, lower 32 bits are used
+    RandomStream stream(Purpose purpose, uint64_t key, uint64_t tick = 0) const
+    {
+        return RandomStream({uint32_t(seed), uint32_t(seed >> 32)},
+                            {0, uint32_t(tick), uint32_t(key), uint32_t(key >> 32 & 0x00FFFFFF) | uint32_t(purpose) << 24});
+    }
+};
@@ -31,7 +31,7 @@ public:
     /// @param newValue New value of RangeValue
     void set(T newValue) { value = std::max(std::min(newValue, maxValue), minValue); }
     /// @return value of current RangeValue
-    T get() { return value; }
+    T get() const { return value; }
 
     /// @brief Increase current RangeValue.value by amount
     /// @param amount Amount to add to RangeValue.value
@@ -42,10 +42,10 @@ public:
     void decrease(T amount) { set(value - amount); }
 
     /// @return Return RangeValue.maxValue
-    T getMax() { return maxValue; }
+    T getMax() const { return maxValue; }
 
     /// @return Return RangeValue.minValue
-    T getMin() { return minValue; }
+    T getMin() const { return minValue; }
 
     /// @brief Set new value for RangeValue.maxValue
     /// @param newMaxValue Value to set
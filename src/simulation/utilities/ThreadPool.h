@@ -0,0 +1,131 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <algorithm>
+
+/// @brief Fixed set of worker threads executing submitted tasks
+class ThreadPool
+{
+private:
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()>> tasks;
+
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable allDone;
+
+    size_t unfinishedTasks = 0;
+    bool stopping = false;
+    std::exception_ptr firstException;
+
+    void workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (stopping && tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop();
+            }
+
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!firstException)
+                {
+                    firstException = std::current_exception();
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--unfinishedTasks == 0)
+            {
+                allDone.notify_all();
+            }
+        }
+    }
+
+public:
+    /// @brief Create pool with given number of threads
+    /// @param numberOfThreads If 0, use number of hardware threads
+    explicit ThreadPool(size_t numberOfThreads = 0)
+    {
+        if (numberOfThreads == 0)
+        {
+            numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (size_t i = 0; i < numberOfThreads; i++)
+        {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        taskAvailable.notify_all();
+        for (auto &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    size_t size() const { return workers.size(); }
+
+    /// @brief Add task to the queue. It will be executed by first free worker
+    void submit(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push(std::move(task));
+            unfinishedTasks++;
+        }
+        taskAvailable.notify_one();
+    }
+
+    /// @brief Block until all submitted tasks are finished.
+    /// If any task threw exception, rethrow the first one
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        allDone.wait(lock, [this]() { return unfinishedTasks == 0; });
+        if (firstException)
+        {
+            std::exception_ptr exception = firstException;
+            firstException = nullptr;
+            std::rethrow_exception(exception);
+        }
+    }
+
+    /// @brief Call function(i) for each i in [0, count) on workers and wait for all of them
+    void parallelFor(size_t count, const std::function<void(size_t)> &function)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            submit([&function, i]() { function(i); });
+        }
+        wait();
+    }
+};
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "PerfCounters.h"
+
+/// @brief Record duration of every phase of the last ticks (frames) in ring buffer.
+/// Phases are measured with TickProfiler::Scope placed in hot paths, which cost nothing when profiler is disabled.
+/// Recorded ticks can be exported to Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+/// Optionally hardware counters (see PerfCounters) are read around every phase and summed per phase.
+class TickProfiler
+{
+public:
+    enum Phase
+    {
+        FoodGeneration,
+        FoodUpdate,
+        TreeUpdate,
+        OtherUpdate,
+        Environment,
+        Perception,
+        Brain,
+        Action,
+        Deaths,
+        Births,
+        RenderCulling,
+        DrawList,
+        PhasesCount
+    };
+    static constexpr std::array<const char *, PhasesCount> phaseNames = {
+        "Food generation", "Food update", "Tree update", "Other update", "Environment", "Perception", "Brain",
+        "Action", "Deaths", "Births", "Render culling", "Draw list"};
+
+    using Clock = std::chrono::steady_clock;
+
+    /// @brief One measured phase. Times are in microseconds from creation of profiler
+    struct Event
+    {
+        Phase phase;
+        double startUs;
+        float durationUs;
+    };
+
+    struct TickRecord
+    {
+        /// @brief Number of tick since creation of profiler
+        unsigned long index = 0;
+        double startUs = 0.0;
+        double endUs = 0.0;
+        std::vector<Event> events;
+        /// @brief Sum of durations of events of each phase
+        std::array<float, PhasesCount> phaseTotalsUs{};
+
+        float totalUs() const
+        {
+            float total = 0.0f;
+            for (float phaseTotal : phaseTotalsUs)
+            {
+                total += phaseTotal;
+            }
+            return total;
+        }
+    };
+
+    /// @brief Hardware counters summed over all recorded events of one phase
+    struct PhaseCounters
+    {
+        PerfCounters::Values totals{};
+        /// @brief Sum of objects processed by phase (see Scope::setItems())
+        uint64_t items = 0;
+        unsigned long samples = 0;
+
+        double ipc() const
+        {
+            return totals[PerfCounters::Cycles] ? double(totals[PerfCounters::Instructions]) / totals[PerfCounters::Cycles] : 0.0;
+        }
+        double perItem(PerfCounters::Counter counter) const
+        {
+            return items ? double(totals[counter]) / items : 0.0;
+        }
+    };
+
+    /// @brief Measure time (and counters, if enabled) from construction to destruction as given phase of current tick
+    class Scope
+    {
+    private:
+        TickProfiler *profiler;
+        Phase phase;
+        size_t items = 0;
+        PerfCounters::Values startCounters;
+        Clock::time_point start;
+
+    public:
+        Scope(TickProfiler &profiler_, Phase phase_, size_t items_ = 0)
+            : profiler(profiler_.isRecording() ? &profiler_ : nullptr), phase(phase_), items(items_),
+              startCounters(profiler && profiler->countersActive() ? profiler->counters.read() : PerfCounters::Values{}),
+              start(profiler ? Clock::now() : Clock::time_point()) {}
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+        /// @brief Set number of objects processed by phase, used for misses per object
+        void setItems(size_t items_) { items = items_; }
+
+        ~Scope()
+        {
+            if (profiler)
+            {
+                const Clock::time_point end = Clock::now();
+                if (profiler->countersActive())
+                {
+                    profiler->recordCounters(phase, startCounters, profiler->counters.read(), items);
+                }
+                profiler->record(phase, start, end);
+            }
+        }
+    };
+
+private:
+    bool enabled = false;
+    std::vector<TickRecord> ticks;
+    size_t capacity;
+    /// @brief Index of slot of current tick in ring
+    size_t current = 0;
+    size_t recorded = 0;
+    unsigned long tickCounter = 0;
+    const Clock::time_point origin = Clock::now();
+
+    bool countersEnabled = false;
+    /// @brief Counters are opened by first tick after enabling, so they measure thread running simulation
+    bool countersOpenAttempted = false;
+    PerfCounters counters;
+    std::array<PhaseCounters, PhasesCount> phaseCounters{};
+
+    double toUs(Clock::time_point time) const
+    {
+        return std::chrono::duration<double, std::micro>(time - origin).count();
+    }
+
+public:
+    /// @param capacity_ Number of last ticks kept
+    explicit TickProfiler(size_t capacity_ = 240) : capacity(std::max<size_t>(1, capacity_)) {}
+
+    bool isEnabled() const { return enabled; }
+    void setEnabled(bool enabled_) { enabled = enabled_; }
+    /// @brief True if profiler is enabled and tick was started
+    bool isRecording() const { return enabled && recorded > 0; }
+
+    size_t getCapacity() const { return capacity; }
+    /// @brief Change number of kept ticks. Recorded ticks are dropped
+    void setCapacity(size_t capacity_)
+    {
+        capacity = std::max<size_t>(1, capacity_);
+        clear();
+    }
+
+    void clear()
+    {
+        ticks.clear();
+        current = 0;
+        recorded = 0;
+    }
+
+    /// @brief Start new tick. Phases recorded after it belong to this tick
+    void beginTick()
+    {
+        if (!enabled)
+        {
+            return;
+        }
+        if (ticks.size() < capacity)
+        {
+            ticks.emplace_back();
+            current = ticks.size() - 1;
+        }
+        else
+        {
+            current = (current + 1) % capacity;
+        }
+        recorded = std::min(recorded + 1, capacity);
+        if (countersEnabled && !countersOpenAttempted)
+        {
+            countersOpenAttempted = true;
+            counters.open();
+        }
+
+        TickRecord &tick = ticks[current];
+        tick.index = tickCounter++;
+        tick.startUs = toUs(Clock::now());
+        tick.endUs = tick.startUs;
+        tick.events.clear();
+        tick.phaseTotalsUs.fill(0.0f);
+    }
+
+    void record(Phase phase, Clock::time_point start, Clock::time_point end)
+    {
+        if (!isRecording())
+        {
+            return;
+        }
+        TickRecord &tick = ticks[current];
+        const double startUs = toUs(start);
+        const double endUs = toUs(end);
+        tick.events.push_back(Event{phase, startUs, float(endUs - startUs)});
+        tick.phaseTotalsUs[phase] += float(endUs - startUs);
+        tick.endUs = std::max(tick.endUs, endUs);
+    }
+
+    void recordCounters(Phase phase, const PerfCounters::Values &start, const PerfCounters::Values &end, size_t items)
+    {
+        PhaseCounters &aggregate = phaseCounters[phase];
+        for (int counter = 0; counter < PerfCounters::CountersCount; counter++)
+        {
+            aggregate.totals[counter] += end[counter] - start[counter];
+        }
+        aggregate.items += items;
+        aggregate.samples++;
+    }
+
+    bool areCountersEnabled() const { return countersEnabled; }
+    /// @brief Enable reading of hardware counters around phases. Counters are collected only while profiler is enabled
+    void setCountersEnabled(bool enabled_)
+    {
+        countersEnabled = enabled_;
+        if (!countersEnabled)
+        {
+            counters.close();
+            countersOpenAttempted = false;
+        }
+    }
+    /// @brief True if counters are read in current tick
+    bool countersActive() const { return isRecording() && counters.isAvailable(); }
+    /// @brief Counters are enabled but could not be opened
+    bool countersFailed() const { return countersOpenAttempted && !counters.isAvailable(); }
+    const PerfCounters &getCounters() const { return counters; }
+    const PhaseCounters &getPhaseCounters(Phase phase) const { return phaseCounters[phase]; }
+    void resetCounters() { phaseCounters.fill(PhaseCounters{}); }
+
+    /// @brief Print counters aggregated per phase (for headless runs)
+    void printCounters(std::ostream &out) const
+    {
+        if (!counters.isAvailable())
+        {
+            out << "Hardware counters unavailable: "
+                << (counters.getError().empty() ? std::string("not enabled") : counters.getError()) << "\n";
+            return;
+        }
+        out << "Hardware counters per phase (user space)\n";
+        out << std::left << std::setw(16) << "Phase" << std::right << std::setw(10) << "Objects" << std::setw(14) << "Mcycles"
+            << std::setw(8) << "IPC" << std::setw(12) << "L1D/obj" << std::setw(12) << "LLC/obj" << std::setw(12) << "BrMiss/obj" << "\n";
+        std::ios_base::fmtflags flags = out.flags();
+        out << std::fixed;
+        for (int phase = 0; phase < PhasesCount; phase++)
+        {
+            const PhaseCounters &aggregate = phaseCounters[phase];
+            if (aggregate.samples == 0)
+            {
+                continue;
+            }
+            out << std::left << std::setw(16) << phaseNames[phase] << std::right << std::setw(10) << aggregate.items
+                << std::setprecision(2) << std::setw(14) << aggregate.totals[PerfCounters::Cycles] / 1e6
+                << std::setw(8) << aggregate.ipc();
+            for (PerfCounters::Counter counter : {PerfCounters::L1DMisses, PerfCounters::LLCMisses, PerfCounters::BranchMisses})
+            {
+                if (counters.has(counter) && aggregate.items)
+                {
+                    out << std::setw(12) << aggregate.perItem(counter);
+                }
+                else
+                {
+                    out << std::setw(12) << "-";
+                }
+            }
+            out << "\n";
+        }
+        out.flags(flags);
+        if (!counters.getError().empty())
+        {
+            out << "Some counters unavailable: " << counters.getError() << "\n";
+        }
+    }
+
+    /// @brief Number of recorded ticks
+    size_t size() const { return recorded; }
+
+    /// @brief Memory used by ring of ticks and their events
+    size_t memoryBytes() const
+    {
+        size_t bytes = ticks.capacity() * sizeof(TickRecord);
+        for (const TickRecord &record : ticks)
+        {
+            bytes += record.events.capacity() * sizeof(Event);
+        }
+        return bytes;
+    }
+
+    /// @brief Get recorded tick
+    /// @param age 0 is the current (last) tick, size() - 1 is the oldest one
+    const TickRecord &tick(size_t age) const
+    {
+        return ticks[(current + capacity - age) % capacity % ticks.size()];
+    }
+
+    /// @brief Save recorded ticks as Chrome trace event JSON
+    /// @return False if file cant be written
+    bool exportChromeTrace(const std::string &path) const
+    {
+        std::ofstream out(path);
+        if (!out)
+        {
+            return false;
+        }
+        out << std::fixed << std::setprecision(3) << "{\"traceEvents\":[\n";
+        bool first = true;
+        auto writeEvent = [&](const std::string &name, const char *category, double startUs, double durationUs)
+        {
+            out << (first ? "" : ",\n") << "{\"name\":\"" << name << "\",\"cat\":\"" << category
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << startUs << ",\"dur\":" << durationUs << "}";
+            first = false;
+        };
+        for (size_t age = size(); age-- > 0;)
+        {
+            const TickRecord &record = tick(age);
+            writeEvent("Tick " + std::to_string(record.index), "tick", record.startUs, record.endUs - record.startUs);
+            for (const Event &event : record.events)
+            {
+                writeEvent(phaseNames[event.phase], "phase", event.startUs, event.durationUs);
+            }
+        }
+        out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return bool(out);
+    }
+};
@@ -0,0 +1,665 @@
+/*
+ * Microbenchmarks of simulation hot paths.
+ *
+ * Every benchmark is run for each object density (objects per chunk) of
+ * a generated world and reports time and number of heap allocations per
+ * operation. Allocations are counted by replacing global operator new in
+ * this executable. Worlds are generated with fixed seed, so numbers of
+ * different builds can be compared (e.g. with --csv output).
+ *
+ * Numbers are only meaningful for optimised build: cmake -DDEBUG=OFF
+ *
+ * Usage: bench [--filter TEXT] [--densities N,N,...] [--min-time-ms N]
+ *              [--chunks N] [--csv PATH]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <functional>
+#include <stdexcept>
+
+#include "simulation.h"
+#include "settings/SimulationSettings.h"
+#include "objects/Bot.h"
+#include "objects/Food.h"
+#include "utilities/PerlinNoise2D.h"
+
+// Allocation counting
+
+static std::atomic<unsigned long> allocationsCount{0};
+
+void *operator new(std::size_t size)
+{
+    allocationsCount.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size ? size : 1))
+    {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept { std::free(pointer); }
+
+struct BenchOptions
+{
+    std::string filter;
+    std::vector<int> densities = {2, 8, 32};
+    int minTimeMs = 200;
+    int chunks = 16;
+    std::string csvPath;
+};
+
+/// @brief Accumulate measured time and allocations of benchmark rounds
+class BenchState
+{
+private:
+    double totalNs = 0.0;
+    unsigned long totalAllocations = 0;
+    unsigned long totalOps = 0;
+
+public:
+    /// @brief Measure given function as given number of operations. Code outside of it is not measured (setup)
+    template <typename F>
+    void measure(unsigned long ops, F &&function)
+    {
+        const unsigned long allocationsBefore = allocationsCount.load(std::memory_order_relaxed);
+        const auto start = std::chrono::steady_clock::now();
+        function();
+        totalNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        totalAllocations += allocationsCount.load(std::memory_order_relaxed) - allocationsBefore;
+        totalOps += ops;
+    }
+
+    double getTotalNs() const { return totalNs; }
+    unsigned long getOps() const { return totalOps; }
+    double nsPerOp() const { return totalOps ? totalNs / totalOps : 0.0; }
+    double allocationsPerOp() const { return totalOps ? double(totalAllocations) / totalOps : 0.0; }
+};
+
+/// @brief Benchmark create its world for given density once and return function measuring one round
+using BenchRound = std::function<void(BenchState &)>;
+struct Benchmark
+{
+    std::string name;
+    std::function<BenchRound(int density, int chunks)> setup;
+};
+
+// Benchmark world
+
+/// @brief Brain that does nothing. Bots of benchmarks are moved by benchmarks themselves
+class IdleBrain : public BotBrain
+{
+public:
+    IdleBrain(std::string populationName_) : BotBrain(populationName_) {}
+
+    void init(InitProtocol &data, InitProtocolResponce &responce) override
+    {
+        responce.healthPoints = int(0.2 * data.evolutionPoints);
+        responce.foodPoints = int(0.2 * data.evolutionPoints);
+        responce.visionPoints = int(0.2 * data.evolutionPoints);
+        responce.speedPoints = int(0.2 * data.evolutionPoints);
+        responce.attackPoints = int(0.2 * data.evolutionPoints);
+    }
+};
+
+/// @brief Brain that attacks given bot on every tick
+class AttackBrain : public IdleBrain
+{
+private:
+    unsigned long targetID;
+
+public:
+    AttackBrain(std::string populationName_, unsigned long targetID_) : IdleBrain(populationName_), targetID(targetID_) {}
+
+    void update(UpdateProtocol &data, UpdateProtocolResponce &responce) override
+    {
+        responce.actionAttackByID(false, targetID);
+    }
+};
+
+struct BenchWorld
+{
+    std::shared_ptr<Simulation> simulation;
+    std::vector<std::shared_ptr<BotObject>> bots;
+    std::vector<std::shared_ptr<FoodObject>> food;
+    std::mt19937 random{12345};
+
+    Vec2<float> randomPosition()
+    {
+        std::uniform_real_distribution<float> x(1.0f, simulation->chunkManager->mapWidth - 1.0f);
+        std::uniform_real_distribution<float> y(1.0f, simulation->chunkManager->mapHeight - 1.0f);
+        return Vec2<float>(x(random), y(random));
+    }
+
+    /// @brief Add food at given positions. addObjects() inserts given objects (addObject() would insert copies),
+    /// so food holds the objects simulation updates and deletes
+    void addFood(const std::vector<Vec2<float>> &positions)
+    {
+        std::vector<std::shared_ptr<SimulationObject>> newFood;
+        newFood.reserve(positions.size());
+        for (const auto &position : positions)
+        {
+            // Food that never decays, so benchmarks dont kill it
+            auto foodObject = std::make_shared<FoodObject>(simulation, position, colorInt(100, 0, 0), 1e9f, 1e9f, 1.0f, 0.0f, false);
+            food.push_back(foodObject);
+            newFood.push_back(foodObject);
+        }
+        simulation->addObjects(newFood);
+    }
+
+    std::shared_ptr<BotObject> addBot(Vec2<float> position)
+    {
+        // Two populations, so there are enemies to attack
+        auto brain = std::make_shared<IdleBrain>(bots.size() % 2 ? "BenchA" : "BenchB");
+        bots.push_back(simulation->addSmartBot(brain, position, 1.0f, 1.0f));
+        return bots.back();
+    }
+};
+
+/// @brief Create empty world with density objects per chunk, half of them bots and half food
+static std::shared_ptr<BenchWorld> makeWorld(int density, int chunks)
+{
+    auto settings = std::make_shared<SimulationSettings>();
+    settings->simulationSizeSettings.numberOfChunksX = chunks;
+    settings->simulationSizeSettings.numberOfChunksY = chunks;
+    settings->seed = 1;
+
+    auto world = std::make_shared<BenchWorld>();
+    world->simulation = std::make_shared<Simulation>(settings);
+    const int objectsCount = density * chunks * chunks;
+    std::vector<Vec2<float>> foodPositions;
+    for (int i = 0; i < objectsCount; i++)
+    {
+        if (i % 2 == 0)
+        {
+            world->addBot(world->randomPosition());
+        }
+        else
+        {
+            foodPositions.push_back(world->randomPosition());
+        }
+    }
+    world->addFood(foodPositions);
+    return world;
+}
+
+/// @brief Return ID of random object of given type in chunk of bot, or ULONG_MAX if there is none
+static unsigned long targetInChunk(const std::shared_ptr<BotObject> &bot, SimulationObjectType type)
+{
+    for (const auto &obj : bot->getChunk()->objects)
+    {
+        if (auto validObj = obj.lock(); validObj && validObj != bot && validObj->type() == type)
+        {
+            return validObj->id.get();
+        }
+    }
+    return ULONG_MAX;
+}
+
+// Benchmarks
+
+static std::vector<Benchmark> makeBenchmarks()
+{
+    std::vector<Benchmark> benchmarks;
+
+    benchmarks.push_back({"BotObject::packProtocol", [](int density, int chunks) -> BenchRound
+    {
+        auto world = makeWorld(density, chunks);
+        return [world](BenchState &state)
+        {
+            state.measure(world->bots.size(), [&]
+            {
+                for (auto &bot : world->bots)
+                {
+                    bot->packProtocol();
+                }
+            });
+        };
+    }});
+
+    benchmarks.push_back({"BotObject::getChunksInRadius", [](int density, int chunks) -> BenchRound
+    {
+        auto world = makeWorld(density, chunks);
+        return [world](BenchState &state)
+        {
+            size_t found = 0;
+            state.measure(world->bots.size(), [&]
+            {
+                for (auto &bot : world->bots)
+                {
+                    found += bot->getChunksInRadius(bot->pos, bot->getSeeDistance()).size();
+                }
+            });
+            if (found == 0)
+            {
+                throw std::runtime_error("No chunks found");
+            }
+        };
+    }});
+
+    benchmarks.push_back({"BotObject::actionEat nearest", [](int density, int chunks) -> BenchRound
+    {
+        auto world = makeWorld(density, chunks);
+        return [world](BenchState &state)
+        {
+            state.measure(world->bots.size(), [&]
+            {
+                for (auto &bot : world->bots)
+                {
+                    bot->actionEat();
+                }
+            });
+        };
+    }});
+
+    benchmarks.push_back({"BotObject::actionEat by ID", [](int density, int chunks) -> BenchRound
+    {
+        auto world = makeWorld(density, chunks);
+        std::vector<unsigned long> targets;
+        for (auto &bot : world->bots)
+        {
+            targets.push_back(targetInChunk(bot, SimulationObjectType::FoodObject));
+        }
+        return [world, targets](BenchState &state)
+        {
+            state.measure(world->bots.size(), [&]
+            {
+                for (size_t i = 0; i < world->bots.size(); i++)
+                {
+                    world->bots[i]->actionEat(targets[i]);
+                }
+            });
+        };
+    }});
+
+    benchmarks.push_back({"BotObject::actionAttack nearest", [](int density, int chunks) -> BenchRound
+    {
+        auto world = makeWorld(density, chunks);
+        return [world](BenchState &state)
+        {
+            state.measure(world->bots.size(), [&]
+            {
+                for (auto &bot : world->bots)
+                {
+                    bot->actionAttack();
+                }
+            });
+        };
+    }});
+
+    benchmarks.push_back({"BotObject::actionAttack by ID", [](int density, int chunks) -> BenchRound
+    {
+        auto world = makeWorld(density, chunks);
+        std::vector<unsigned long> targets;
+        for (auto &bot : world->bots)
+        {
+            targets.push_back(targetInChunk(bot, SimulationObjectType::BotObject));
+        }
+        return [world, targets](BenchState &state)
+        {
+            state.measure(world->bots.size(), [&]
+            {
+                for (size_t i = 0; i < world->bots.size(); i++)
+                {
+                    world->bots[i]->actionAttack(true, targets[i]);
+                }
+            });
+        };
+    }});
+
+    benchmarks.push_back({"Simulation::update attacked intents", [](int density, int chunks) -> BenchRound
+    {
+        return [density, chunks](BenchState &state)
+        {
+            // Pairs of bots at the same place: victim continues intent and attacker attacks it. Attack of the
+            // first tick must interrupt intent on the second one, so no bot continues intent then
+            auto world = makeWorld(0, chunks);
+            auto &simulation = world->simulation;
+            std::vector<std::shared_ptr<BotObject>> victims;
+            for (int i = 0; i < std::max(1, density * chunks * chunks / 2); i++)
+            {
+                const Vec2<float> position = world->randomPosition();
+                auto victim = simulation->addSmartBot(std::make_shared<IdleBrain>("BenchA"), position, 1.0f, 1.0f);
+                UpdateProtocolResponce responce;
+                responce.persistFor(1000);
+                victim->parseProtocolResponce(responce);
+                simulation->addSmartBot(std::make_shared<AttackBrain>("BenchB", victim->id.get()), position, 1.0f, 1.0f);
+                victims.push_back(victim);
+            }
+            simulation->update(true);
+            for (const auto &victim : victims)
+            {
+                if (!victim->isUnderAttack() || victim->getHealth() <= 0.0f)
+                {
+                    throw std::runtime_error("Victim was not attacked or died");
+                }
+            }
+            state.measure(simulation->getLastBotUpdateStats().bots, [&]
+            {
+                simulation->update(true);
+            });
+            if (simulation->getLastBotUpdateStats().intentActions != 0)
+            {
+                throw std::runtime_error("Attack didn't interrupt intent");
+            }
+        };
+    }});
+
+    benchmarks.push_back({"Simulation::afterUpdate deaths", [](int density, int chunks) -> BenchRound
+    {
+        auto world = makeWorld(density, chunks);
+        return [world](BenchState &state)
+        {
+            // Kill half of food and replace it after measurement, so density stays the same
+            std::vector<Vec2<float>> positions;
+            for (size_t i = 0; i < world->food.size(); i += 2)
+            {
+                world->food[i]->markForDeletion();
+                positions.push_back(world->food[i]->pos);
+            }
+            state.measure(positions.size(), [&]
+            {
+                world->simulation->afterUpdate();
+            });
+            std::vector<std::shared_ptr<FoodObject>> oldFood;
+            oldFood.swap(world->food);
+            for (size_t i = 1; i < oldFood.size(); i += 2)
+            {
+                world->food.push_back(oldFood[i]);
+            }
+            world->addFood(positions);
+            if (size_t(world->simulation->getNumberOfObjects()) != world->bots.size() + world->food.size())
+            {
+                throw std::runtime_error("Dead food was not deleted");
+            }
+        };
+    }});
+
+    benchmarks.push_back({"ChunkManager::whatChunkHere", [](int density, int chunks) -> BenchRound
+    {
+        auto world = makeWorld(density, chunks);
+        std::vector<Vec2<float>> positions;
+        for (int i = 0; i < 4096; i++)
+        {
+            positions.push_back(world->randomPosition());
+        }
+        return [world, positions](BenchState &state)
+        {
+            int found = 0;
+            state.measure(positions.size(), [&]
+            {
+                for (const auto &position : positions)
+                {
+                    found += world->simulation->chunkManager->whatChunkHere(position) != nullptr;
+                }
+            });
+            if (found != int(positions.size()))
+            {
+                throw std::runtime_error("Position without chunk");
+            }
+        };
+    }});
+
+    benchmarks.push_back({"Chunk::moveToChunk", [](int density, int chunks) -> BenchRound
+    {
+        auto world = makeWorld(density, chunks);
+        return [world](BenchState &state)
+        {
+            // Move every bot to the neighbour chunk and back
+            auto &chunkManager = world->simulation->chunkManager;
+            state.measure(world->bots.size() * 2, [&]
+            {
+                for (auto &bot : world->bots)
+                {
+                    auto from = bot->getChunk();
+                    auto to = chunkManager->getChunk((from->xIndex + 1) % chunkManager->numberOfChunksX, from->yIndex);
+                    from->moveToChunk(bot, to);
+                    to->moveToChunk(bot, from);
+                }
+            });
+        };
+    }});
+
+    benchmarks.push_back({"PerlinNoise2D::getValue", [](int density, int chunks) -> BenchRound
+    {
+        // Density is number of samples per chunk
+        auto noise = std::make_shared<PerlinNoise2D>(RandomService(1).stream(RandomService::TreeGeneration, 0));
+        const int samplesPerSide = std::max(1, int(std::sqrt(double(density))));
+        const int side = samplesPerSide * chunks;
+        return [noise, side](BenchState &state)
+        {
+            float sum = 0.0f;
+            state.measure(side * side, [&]
+            {
+                for (int y = 0; y < side; y++)
+                {
+                    for (int x = 0; x < side; x++)
+                    {
+                        sum += noise->getValue(x * 0.1f, y * 0.1f);
+                    }
+                }
+            });
+            if (std::isnan(sum))
+            {
+                throw std::runtime_error("Invalid noise value");
+            }
+        };
+    }});
+
+    benchmarks.push_back({"Simulation::applyChunkEffects", [](int density, int chunks) -> BenchRound
+    {
+        auto world = makeWorld(density, chunks);
+        // Every other chunk has events, chances are zero so bots stay as they are
+        for (const auto &chunk : *world->simulation->chunkManager)
+        {
+            Chunk::Effects effects = chunk->getEffects();
+            effects.seeDistanceMultiplier = (chunk->xIndex + chunk->yIndex) % 2 ? 1.5f : 1.0f;
+            effects.lostLifeChance = (chunk->xIndex + chunk->yIndex) % 2 ? 1e-9f : 0.0f;
+            chunk->setEffects(effects);
+        }
+        return [world](BenchState &state)
+        {
+            int seeDistance = 0;
+            state.measure(world->bots.size(), [&]
+            {
+                world->simulation->applyChunkEffects(world->bots);
+                for (const auto &bot : world->bots)
+                {
+                    seeDistance += bot->getSeeDistance();
+                }
+            });
+            if (seeDistance <= 0)
+            {
+                throw std::runtime_error("Invalid see distance");
+            }
+        };
+    }});
+
+    benchmarks.push_back({"Simulation::randomGenerationFood", [](int density, int chunks) -> BenchRound
+    {
+        // Density times chunks / 2 is side of map, spawn chance is the one of main.cpp
+        auto settings = std::make_shared<SimulationSettings>();
+        const int side = std::max(1, density * chunks / 2);
+        settings->simulationSizeSettings.numberOfChunksX = side;
+        settings->simulationSizeSettings.numberOfChunksY = side;
+        settings->mapGenerationSettings.randomSpawnFood = true;
+        settings->mapGenerationSettings.foodSpawnChance = 0.005f;
+        settings->seed = 1;
+        auto simulation = std::make_shared<Simulation>(settings);
+        return [simulation, side](BenchState &state)
+        {
+            state.measure(size_t(side) * side, [&]
+            {
+                simulation->randomGenerationFood();
+            });
+            // Remove spawned food, so every round starts from empty map
+            const auto objects = simulation->getObjects();
+            for (const auto &object : *objects)
+            {
+                object->markForDeletion();
+            }
+            simulation->afterUpdate();
+        };
+    }});
+
+    benchmarks.push_back({"FoodObject::update", [](int density, int chunks) -> BenchRound
+    {
+        auto world = makeWorld(density, chunks);
+        return [world](BenchState &state)
+        {
+            state.measure(world->food.size(), [&]
+            {
+                for (auto &food : world->food)
+                {
+                    food->update();
+                }
+            });
+        };
+    }});
+
+    return benchmarks;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: bench [--filter TEXT] [--densities N,N,...] [--min-time-ms N]\n"
+                 "             [--chunks N] [--csv PATH]\n";
+}
+
+static BenchOptions parseOptions(int argc, char **argv)
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc)
+        {
+            throw std::invalid_argument("Missing value of option " + arg);
+        }
+        const std::string value = argv[++i];
+
+        if (arg == "--filter") options.filter = value;
+        else if (arg == "--min-time-ms") options.minTimeMs = std::stoi(value);
+        else if (arg == "--chunks") options.chunks = std::stoi(value);
+        else if (arg == "--csv") options.csvPath = value;
+        else if (arg == "--densities")
+        {
+            options.densities.clear();
+            std::stringstream densities(value);
+            std::string density;
+            while (std::getline(densities, density, ','))
+            {
+                if (!density.empty())
+                {
+                    options.densities.push_back(std::stoi(density));
+                }
+            }
+        }
+        else throw std::invalid_argument("Unknown option " + arg);
+    }
+
+    if (options.minTimeMs < 1 || options.chunks < 3 || options.densities.empty())
+    {
+        throw std::invalid_argument("Bench options are invalid!");
+    }
+    for (int density : options.densities)
+    {
+        if (density < 2)
+        {
+            throw std::invalid_argument("Density must be at least 2 (one bot and one food per chunk)!");
+        }
+    }
+    return options;
+}
+
+int main(int argc, char **argv)
+{
+    BenchOptions options;
+    try
+    {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+
+    std::ofstream csv;
+    if (!options.csvPath.empty())
+    {
+        csv.open(options.csvPath);
+        if (!csv)
+        {
+            std::cerr << "Can't write " << options.csvPath << "\n";
+            return 1;
+        }
+        csv << "benchmark,density,ns_per_op,allocs_per_op,ops\n";
+    }
+
+#ifdef NDEBUG
+    std::cout << "Optimised build, " << options.chunks << "x" << options.chunks << " chunks\n";
+#else
+    std::cout << "WARNING: debug build, configure with -DDEBUG=OFF for meaningful numbers\n";
+#endif
+    std::cout << std::left << std::setw(36) << "Benchmark" << std::right << std::setw(9) << "Density"
+              << std::setw(14) << "ns/op" << std::setw(12) << "allocs/op" << std::setw(12) << "ops" << "\n";
+
+    const double minTimeNs = options.minTimeMs * 1e6;
+    for (const auto &benchmark : makeBenchmarks())
+    {
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == std::string::npos)
+        {
+            continue;
+        }
+        for (int density : options.densities)
+        {
+            BenchState state;
+            try
+            {
+                BenchRound round = benchmark.setup(density, options.chunks);
+                // One round to warm up caches and lazy allocations
+                BenchState warmUp;
+                round(warmUp);
+                for (int rounds = 0; state.getTotalNs() < minTimeNs && rounds < 100000; rounds++)
+                {
+                    round(state);
+                }
+            }
+            catch (const std::exception &e)
+            {
+                std::cerr << benchmark.name << " failed: " << e.what() << "\n";
+                return 1;
+            }
+
+            std::cout << std::left << std::setw(36) << benchmark.name << std::right << std::setw(9) << density
+                      << std::fixed << std::setprecision(1) << std::setw(14) << state.nsPerOp()
+                      << std::setprecision(2) << std::setw(12) << state.allocationsPerOp()
+                      << std::setw(12) << state.getOps() << "\n";
+            if (csv)
+            {
+                csv << benchmark.name << "," << density << "," << state.nsPerOp() << ","
+                    << state.allocationsPerOp() << "," << state.getOps() << "\n";
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * Brain host process. Started by RemoteBrainHost of simulation, it runs brains
+ * of remote populations outside of simulation process and talks to it through
+ * shared memory (see src/simulation/remote/).
+ *
+ * Usage: brain_host --shm NAME
+ */
+
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "protocols/brain/BrainsRegistry.h"
+#include "remote/RemoteBrainServer.h"
+#include "brains/neural/NeuralBrain.h"
+#include "brains/tunable/TunableBrain.h"
+
+/// @brief Register brain class under its population name
+template <typename T>
+static void registerBrain(BrainsRegistry &registry)
+{
+    registry.registerBot(std::make_shared<T>()->populationName, [](BrainContext &)
+                         { return std::make_shared<T>(); });
+}
+
+int main(int argc, char **argv)
+{
+    if (argc != 3 || std::string(argv[1]) != "--shm")
+    {
+        std::cerr << "Usage: brain_host --shm NAME\n"
+                     "Brain host is started by simulation, see RemoteBrainHost\n";
+        return 1;
+    }
+
+    // Only brains that dont need visible sets, as host receive flat perception of bots
+    BrainsRegistry registry;
+    registerBrain<NeuralBrain>(registry);
+    registerBrain<TunableBrain>(registry);
+
+    try
+    {
+        RemoteBrainServer server(argv[2], registry);
+        server.run();
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Brain host: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+/*
+ * Headless run of simulation whose populations are controlled by brains
+ * in separate brain host process (see src/simulation/remote/).
+ * Print latency and throughput of communication with host.
+ *
+ * Usage: remote_run [--ticks N] [--workers N] [--host PATH] [--bots N]
+ *                   [--chunks N] [--timeout-ms N] [--populations A,B,...]
+ *                   [--profile 0|1] [--budget-us X] [--trace PATH]
+ *                   [--memory 0|1] [--counters 0|1]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include "simulation.h"
+#include "settings/SimulationSettings.h"
+#include "remote/RemoteBrainHost.h"
+
+struct RemoteRunOptions
+{
+    int ticks = 1000;
+    int botsPerPopulation = 100;
+    int chunks = 16;
+    std::vector<std::string> populations = {"TunableLegion", "NeuralSwarm"};
+    /// @brief Print time spent on each population (see BrainProfiler)
+    bool profile = false;
+    float budgetUs = 0.0f;
+    /// @brief Save phases of the last ticks as Chrome trace (see TickProfiler)
+    std::string tracePath;
+    /// @brief Print estimated memory of simulation (see MemoryStats)
+    bool memory = false;
+    /// @brief Print hardware counters of tick phases (see PerfCounters)
+    bool counters = false;
+    RemoteBrainHost::Options host;
+};
+
+static void printUsage()
+{
+    std::cout << "Usage: remote_run [--ticks N] [--workers N] [--host PATH] [--bots N]\n"
+                 "                  [--chunks N] [--timeout-ms N] [--populations A,B,...]\n"
+                 "                  [--profile 0|1] [--budget-us X] [--trace PATH]\n"
+                 "                  [--memory 0|1] [--counters 0|1]\n";
+}
+
+static RemoteRunOptions parseOptions(int argc, char **argv)
+{
+    RemoteRunOptions options;
+    // By default brain host is expected next to this executable
+    const std::string self = argv[0];
+    const size_t slash = self.find_last_of('/');
+    options.host.hostExecutable = (slash == std::string::npos ? std::string(".") : self.substr(0, slash)) + "/brain_host";
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc)
+        {
+            throw std::invalid_argument("Missing value of option " + arg);
+        }
+        const std::string value = argv[++i];
+
+        if (arg == "--ticks") options.ticks = std::stoi(value);
+        else if (arg == "--workers") options.host.workers = std::stoi(value);
+        else if (arg == "--host") options.host.hostExecutable = value;
+        else if (arg == "--bots") options.botsPerPopulation = std::stoi(value);
+        else if (arg == "--chunks") options.chunks = std::stoi(value);
+        else if (arg == "--timeout-ms") options.host.timeoutMs = std::stoi(value);
+        else if (arg == "--profile") options.profile = std::stoi(value) != 0;
+        else if (arg == "--budget-us") options.budgetUs = std::stof(value);
+        else if (arg == "--trace") options.tracePath = value;
+        else if (arg == "--memory") options.memory = std::stoi(value) != 0;
+        else if (arg == "--counters") options.counters = std::stoi(value) != 0;
+        else if (arg == "--populations")
+        {
+            options.populations.clear();
+            std::stringstream names(value);
+            std::string name;
+            while (std::getline(names, name, ','))
+            {
+                if (!name.empty())
+                {
+                    options.populations.push_back(name);
+                }
+            }
+        }
+        else throw std::invalid_argument("Unknown option " + arg);
+    }
+
+    if (options.ticks < 1 || options.botsPerPopulation < 1 || options.chunks < 1 || options.populations.empty())
+    {
+        throw std::invalid_argument("Remote run options must be positive!");
+    }
+    return options;
+}
+
+int main(int argc, char **argv)
+{
+    RemoteRunOptions options;
+    try
+    {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+
+    auto settings = std::make_shared<SimulationSettings>();
+    settings->simulationSizeSettings.unit = 50;
+    settings->simulationSizeSettings.numberOfChunksX = options.chunks;
+    settings->simulationSizeSettings.numberOfChunksY = options.chunks;
+    settings->mapGenerationSettings.spawnType = SpawnType::Random;
+    settings->mapGenerationSettings.numberOfBotsPerPopulation = options.botsPerPopulation;
+    settings->mapGenerationSettings.randomSpawnFood = true;
+    settings->profilingSettings.profileBrains = options.profile;
+    settings->profilingSettings.brainTimeBudgetUs = options.budgetUs;
+    settings->profilingSettings.profileTicks = !options.tracePath.empty() || options.counters;
+    settings->profilingSettings.profileCounters = options.counters;
+
+    std::shared_ptr<RemoteBrainHost> host;
+    try
+    {
+        host = RemoteBrainHost::start(options.host);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "Brain host started with " << options.host.workers << " workers\n";
+
+    double tickSeconds = 0.0;
+    {
+        auto simulation = std::make_shared<Simulation>(settings);
+        simulation->generateTree();
+        simulation->initBotClasses(host->makeRegistry(options.populations));
+
+        for (int tick = 0; tick < options.ticks; tick++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            simulation->update(true);
+            simulation->afterUpdate();
+            tickSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if ((tick + 1) % 100 == 0 || tick + 1 == options.ticks)
+            {
+                std::cout << "Tick " << std::setw(6) << tick + 1;
+                for (const auto &[name, size] : simulation->getPopulationSizes())
+                {
+                    std::cout << " | " << name << ": " << size;
+                }
+                std::cout << "\n";
+            }
+        }
+        if (options.profile)
+        {
+            simulation->getBrainProfiler().print(std::cout);
+        }
+        if (options.memory)
+        {
+            simulation->collectMemoryStats().print(std::cout);
+            MemoryStats::printLayout(std::cout, Simulation::getObjectLayout());
+        }
+        if (options.counters)
+        {
+            simulation->getTickProfiler().printCounters(std::cout);
+        }
+        if (!options.tracePath.empty() && !simulation->getTickProfiler().exportChromeTrace(options.tracePath))
+        {
+            std::cerr << "Can't write trace to " << options.tracePath << "\n";
+        }
+    }
+
+    const auto &stats = host->getStats();
+    std::cout << std::fixed << std::setprecision(2)
+              << "Ticks:              " << options.ticks << ", " << tickSeconds * 1000.0 / options.ticks << " ms/tick\n"
+              << "Round trips:        " << stats.roundTrips << " (" << stats.timeouts << " timeouts, "
+              << stats.failures << " failures), " << stats.inits << " inits\n"
+              << "Bots per trip:      " << (stats.roundTrips ? double(stats.bots) / stats.roundTrips : 0.0) << "\n"
+              << "Latency:            mean " << stats.meanLatencyUs() << " us, max " << stats.maxLatencyUs << " us\n"
+              << "Throughput:         " << (tickSeconds > 0.0 ? stats.bots / tickSeconds : 0.0) << " bot decisions/s\n"
+              << "Traffic:            " << stats.bytesSent / 1048576.0 << " MB sent, "
+              << stats.bytesReceived / 1048576.0 << " MB received\n";
+    return 0;
+}
@@ -0,0 +1,555 @@
+/*
+ * Macro benchmark of whole simulation ticks on canned scenarios.
+ *
+ * Every scenario is run for each number of objects and each number of
+ * threads. With N threads, N independent simulations of the scenario run
+ * at the same time (simulation itself is single threaded), which shows how
+ * ticks slow down when instances share memory bandwidth and caches.
+ *
+ * Results are written as CSV. If baseline file (results of earlier run)
+ * is given, every result is compared with it and program exits with code 2
+ * when ms/tick of any run grew more than threshold.
+ *
+ * With --telemetry every simulation writes per tick metrics (see Telemetry) to
+ * given directory, ms/tick then includes cost of telemetry.
+ *
+ * With --food-field 1 randomly spawned food far from bots is kept as calories of chunks (see FoodField).
+ * With --merge-food 1 new food merges into food it overlaps, --food-cap N limits food objects per cell,
+ * number of food objects saved by both is printed.
+ *
+ * Scenarios:
+ *   uniform    - bots of two populations spread randomly over the map
+ *   hotspot    - all bots spawned in one place (SpawnType::OnePlace)
+ *   forest     - dense perlin forest with fast fruiting trees
+ *   foodboom   - food spawned in every chunk on every tick
+ *   meadow     - few bots in one place on map full of randomly spawned food
+ *
+ * Usage: scenario_bench [--scenarios A,B,...] [--objects N,N,...] [--threads N,N,...]
+ *                       [--ticks N] [--warmup N] [--max-seconds X] [--seed N]
+ *                       [--out PATH] [--baseline PATH] [--threshold X]
+ *                       [--telemetry DIR] [--telemetry-format csv|binary] [--food-field 0|1]
+ *                       [--merge-food 0|1] [--food-cap N]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <algorithm>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+
+#include "simulation.h"
+#include "settings/SimulationSettings.h"
+#include "telemetry/Telemetry.h"
+#include "utilities/ThreadPool.h"
+#include "brains/tunable/TunableBrain.h"
+#include "brains/neural/NeuralBrain.h"
+
+struct ScenarioOptions
+{
+    std::vector<std::string> scenarios = {"uniform", "hotspot", "forest", "foodboom", "meadow"};
+    std::vector<int> objects = {1000, 10000, 100000};
+    std::vector<int> threads = {1};
+    int ticks = 30;
+    int warmupTicks = 5;
+    /// @brief Measuring of one run stops after this time, even if not all ticks were done
+    double maxSeconds = 60.0;
+    unsigned int seed = 1;
+    std::string outPath = "scenario_results.csv";
+    std::string baselinePath;
+    /// @brief Allowed growth of ms/tick relative to baseline (0.1 - 10%)
+    double threshold = 0.1;
+    /// @brief Directory for telemetry of every simulation. Empty - no telemetry
+    std::string telemetryPath;
+    Telemetry::Format telemetryFormat = Telemetry::Format::Csv;
+    /// @brief Keep random food far from bots in FoodField (MapGenerationSettings::foodDensityField)
+    bool foodField = false;
+    /// @brief Merge overlapping food and limit food per cell (MapGenerationSettings::mergeFood, maxFoodPerCell)
+    bool mergeFood = false;
+    unsigned int foodCap = 0;
+};
+
+/// @brief Scenario fill settings and world for given number of objects
+struct Scenario
+{
+    std::string name;
+    std::function<std::shared_ptr<SimulationSettings>(int objects)> makeSettings;
+    /// @brief Generate map objects and spawn populations
+    std::function<void(Simulation &simulation)> populate;
+};
+
+struct RunResult
+{
+    std::string scenario;
+    int objects = 0;
+    int threads = 0;
+    /// @brief Number of objects of the first simulation when measurement started and ended
+    int objectsStart = 0;
+    int objectsEnd = 0;
+    /// @brief Number of measured ticks of all simulations
+    int ticks = 0;
+    double msPerTick = 0.0;
+    double p95Ms = 0.0;
+    double ticksPerSecond = 0.0;
+    /// @brief Time of simulation thread spent on telemetry per sample and bytes written by all simulations
+    double telemetryMs = 0.0;
+    size_t telemetryBytes = 0;
+    /// @brief Food objects not created because of merging, all simulations, whole run
+    uint64_t foodMerged = 0;
+    uint64_t foodCapped = 0;
+
+    std::string key() const { return scenario + "/" + std::to_string(objects) + "/" + std::to_string(threads); }
+};
+
+/// @brief Number of chunks per side of square map with given number of objects per chunk
+static int mapSide(int objects, double objectsPerChunk)
+{
+    return std::max(4, int(std::ceil(std::sqrt(objects / objectsPerChunk))));
+}
+
+static std::shared_ptr<SimulationSettings> baseSettings(int side, int botsPerPopulation)
+{
+    auto settings = std::make_shared<SimulationSettings>();
+    settings->simulationSizeSettings.numberOfChunksX = side;
+    settings->simulationSizeSettings.numberOfChunksY = side;
+    settings->mapGenerationSettings.spawnType = SpawnType::Random;
+    settings->mapGenerationSettings.numberOfBotsPerPopulation = std::max(1, botsPerPopulation);
+    settings->mapGenerationSettings.randomSpawnFood = false;
+    return settings;
+}
+
+static void spawnPopulations(Simulation &simulation)
+{
+    simulation.spawnPopulation([]() { return std::make_shared<TunableBrain>(); });
+    simulation.spawnPopulation([]() { return std::make_shared<NeuralBrain>(); });
+}
+
+static std::vector<Scenario> makeScenarios()
+{
+    std::vector<Scenario> scenarios;
+
+    scenarios.push_back({"uniform", [](int objects)
+    {
+        auto settings = baseSettings(mapSide(objects, 8.0), objects / 2);
+        settings->mapGenerationSettings.randomSpawnFood = true;
+        return settings;
+    }, spawnPopulations});
+
+    scenarios.push_back({"hotspot", [](int objects)
+    {
+        auto settings = baseSettings(mapSide(objects, 8.0), objects / 2);
+        settings->mapGenerationSettings.spawnType = SpawnType::OnePlace;
+        // Bots are spread over a few chunks around center of map
+        settings->mapGenerationSettings.spawnRadius = 2.0f * settings->simulationSizeSettings.unit *
+                                                      settings->simulationSizeSettings.unitsPerChunk;
+        return settings;
+    }, spawnPopulations});
+
+    scenarios.push_back({"forest", [](int objects)
+    {
+        // About 3/4 of objects are trees (roughly 12 trees per chunk with these settings)
+        auto settings = baseSettings(mapSide(objects * 0.75, 12.0), objects / 8);
+        settings->mapGenerationSettings.perlinThreshold = 0.1f;
+        settings->mapGenerationSettings.treeRarety = 1;
+        settings->mapGenerationSettings.treeFruitingRate = 10.0f;
+        return settings;
+    }, [](Simulation &simulation)
+    {
+        simulation.generateTree();
+        spawnPopulations(simulation);
+    }});
+
+    scenarios.push_back({"foodboom", [](int objects)
+    {
+        auto settings = baseSettings(mapSide(objects, 8.0), objects / 4);
+        settings->mapGenerationSettings.randomSpawnFood = true;
+        settings->mapGenerationSettings.foodSpawnChance = 1.0f;
+        settings->mapGenerationSettings.foodPerChunk = 10.0f;
+        return settings;
+    }, spawnPopulations});
+
+    scenarios.push_back({"meadow", [](int objects)
+    {
+        // Few bots in one place, the rest of map is covered with randomly spawned food
+        // (about 20 food objects per chunk in steady state)
+        auto settings = baseSettings(mapSide(objects, 20.0), objects / 40);
+        settings->mapGenerationSettings.spawnType = SpawnType::OnePlace;
+        settings->mapGenerationSettings.spawnRadius = 2.0f * settings->simulationSizeSettings.unit *
+                                                      settings->simulationSizeSettings.unitsPerChunk;
+        settings->mapGenerationSettings.randomSpawnFood = true;
+        settings->mapGenerationSettings.foodSpawnChance = 0.05f;
+        settings->mapGenerationSettings.foodPerChunk = 4.0f;
+        return settings;
+    }, spawnPopulations});
+
+    return scenarios;
+}
+
+static std::vector<std::string> splitList(const std::string &value)
+{
+    std::vector<std::string> items;
+    std::stringstream stream(value);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+static std::vector<int> splitIntList(const std::string &value)
+{
+    std::vector<int> numbers;
+    for (const auto &item : splitList(value))
+    {
+        numbers.push_back(std::stoi(item));
+    }
+    return numbers;
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: scenario_bench [--scenarios A,B,...] [--objects N,N,...] [--threads N,N,...]\n"
+                 "                      [--ticks N] [--warmup N] [--max-seconds X] [--seed N]\n"
+                 "                      [--out PATH] [--baseline PATH] [--threshold X]\n"
+                 "                      [--telemetry DIR] [--telemetry-format csv|binary] [--food-field 0|1]\n"
+                 "                      [--merge-food 0|1] [--food-cap N]\n"
+                 "Scenarios: uniform, hotspot, forest, foodboom, meadow\n";
+}
+
+static ScenarioOptions parseOptions(int argc, char **argv)
+{
+    ScenarioOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc)
+        {
+            throw std::invalid_argument("Missing value of option " + arg);
+        }
+        const std::string value = argv[++i];
+
+        if (arg == "--scenarios") options.scenarios = splitList(value);
+        else if (arg == "--objects") options.objects = splitIntList(value);
+        else if (arg == "--threads") options.threads = splitIntList(value);
+        else if (arg == "--ticks") options.ticks = std::stoi(value);
+        else if (arg == "--warmup") options.warmupTicks = std::stoi(value);
+        else if (arg == "--max-seconds") options.maxSeconds = std::stod(value);
+        else if (arg == "--seed") options.seed = static_cast<unsigned int>(std::stoul(value));
+        else if (arg == "--out") options.outPath = value;
+        else if (arg == "--baseline") options.baselinePath = value;
+        else if (arg == "--threshold") options.threshold = std::stod(value);
+        else if (arg == "--telemetry") options.telemetryPath = value;
+        else if (arg == "--telemetry-format")
+        {
+            if (value == "csv") options.telemetryFormat = Telemetry::Format::Csv;
+            else if (value == "binary") options.telemetryFormat = Telemetry::Format::Binary;
+            else throw std::invalid_argument("Unknown telemetry format " + value);
+        }
+        else if (arg == "--food-field") options.foodField = std::stoi(value) != 0;
+        else if (arg == "--merge-food") options.mergeFood = std::stoi(value) != 0;
+        else if (arg == "--food-cap") options.foodCap = static_cast<unsigned int>(std::stoul(value));
+        else throw std::invalid_argument("Unknown option " + arg);
+    }
+
+    if (options.scenarios.empty() || options.objects.empty() || options.threads.empty() ||
+        options.ticks < 1 || options.warmupTicks < 0 || options.maxSeconds <= 0.0 || options.threshold < 0.0)
+    {
+        throw std::invalid_argument("Scenario bench options are invalid!");
+    }
+    for (int value : options.objects)
+    {
+        if (value < 10) throw std::invalid_argument("Number of objects must be at least 10!");
+    }
+    for (int value : options.threads)
+    {
+        if (value < 1) throw std::invalid_argument("Number of threads must be positive!");
+    }
+    return options;
+}
+
+/// @brief Run given number of simulations of scenario at the same time and measure their ticks
+static RunResult runScenario(const Scenario &scenario, int objects, int threads, const ScenarioOptions &options)
+{
+    const auto settings = scenario.makeSettings(objects);
+    settings->mapGenerationSettings.foodDensityField = options.foodField;
+    settings->mapGenerationSettings.mergeFood = options.mergeFood;
+    settings->mapGenerationSettings.maxFoodPerCell = options.foodCap;
+
+    // Simulations are created before measuring, so generation of world is not measured
+    std::vector<std::shared_ptr<Simulation>> simulations;
+    for (int i = 0; i < threads; i++)
+    {
+        auto simulationSettings = std::make_shared<SimulationSettings>(*settings);
+        simulationSettings->seed = options.seed + i;
+        auto simulation = std::make_shared<Simulation>(simulationSettings);
+        scenario.populate(*simulation);
+        simulations.push_back(simulation);
+    }
+    std::vector<std::unique_ptr<Telemetry>> telemetries;
+    if (!options.telemetryPath.empty())
+    {
+        for (int i = 0; i < threads; i++)
+        {
+            Telemetry::Options telemetryOptions;
+            telemetryOptions.path = options.telemetryPath + "/" + scenario.name + "_" + std::to_string(objects) + "_" +
+                                    std::to_string(threads) + "_" + std::to_string(i);
+            telemetryOptions.format = options.telemetryFormat;
+            telemetries.push_back(std::make_unique<Telemetry>(simulations[i], telemetryOptions));
+        }
+    }
+
+    RunResult result;
+    result.scenario = scenario.name;
+    result.objects = objects;
+    result.threads = threads;
+
+    std::vector<std::vector<double>> tickTimes(threads);
+    std::vector<int> objectsStart(threads, 0);
+    std::vector<int> objectsEnd(threads, 0);
+    const auto wallStart = std::chrono::steady_clock::now();
+    ThreadPool pool(threads);
+    pool.parallelFor(threads, [&](size_t i)
+    {
+        auto &simulation = simulations[i];
+        for (int tick = 0; tick < options.warmupTicks; tick++)
+        {
+            simulation->update(true);
+            simulation->afterUpdate();
+        }
+        objectsStart[i] = simulation->getNumberOfObjects();
+
+        const auto measureStart = std::chrono::steady_clock::now();
+        for (int tick = 0; tick < options.ticks; tick++)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            simulation->update(true);
+            simulation->afterUpdate();
+            const auto end = std::chrono::steady_clock::now();
+            tickTimes[i].push_back(std::chrono::duration<double, std::milli>(end - start).count());
+            if (std::chrono::duration<double>(end - measureStart).count() > options.maxSeconds)
+            {
+                break;
+            }
+        }
+        objectsEnd[i] = simulation->getNumberOfObjects();
+    });
+    const double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    std::vector<double> allTimes;
+    for (const auto &times : tickTimes)
+    {
+        allTimes.insert(allTimes.end(), times.begin(), times.end());
+    }
+    std::sort(allTimes.begin(), allTimes.end());
+    double sum = 0.0;
+    for (double time : allTimes)
+    {
+        sum += time;
+    }
+
+    result.objectsStart = objectsStart[0];
+    result.objectsEnd = objectsEnd[0];
+    result.ticks = int(allTimes.size());
+    result.msPerTick = allTimes.empty() ? 0.0 : sum / allTimes.size();
+    result.p95Ms = allTimes.empty() ? 0.0 : allTimes[std::min(allTimes.size() - 1, size_t(0.95 * allTimes.size()))];
+    result.ticksPerSecond = wallSeconds > 0.0 ? allTimes.size() / wallSeconds : 0.0;
+
+    unsigned long samples = 0;
+    double telemetrySeconds = 0.0;
+    for (auto &telemetry : telemetries)
+    {
+        telemetry->flush();
+        const auto stats = telemetry->getStats();
+        samples += stats.samples;
+        telemetrySeconds += stats.collectSeconds + stats.waitSeconds;
+        result.telemetryBytes += stats.bytes;
+    }
+    result.telemetryMs = samples > 0 ? telemetrySeconds * 1000.0 / samples : 0.0;
+    for (const auto &simulation : simulations)
+    {
+        result.foodMerged += simulation->getFoodMergeStats().merged;
+        result.foodCapped += simulation->getFoodMergeStats().capped;
+    }
+    return result;
+}
+
+static const char *csvHeader = "scenario,objects,threads,objects_start,objects_end,ticks,ms_per_tick,p95_ms,ticks_per_second";
+
+static void writeResults(const std::string &path, const std::vector<RunResult> &results)
+{
+    std::ofstream out(path);
+    if (!out)
+    {
+        throw std::runtime_error("Can't write results to " + path);
+    }
+    out << csvHeader << "\n" << std::fixed << std::setprecision(4);
+    for (const auto &result : results)
+    {
+        out << result.scenario << "," << result.objects << "," << result.threads << ","
+            << result.objectsStart << "," << result.objectsEnd << "," << result.ticks << ","
+            << result.msPerTick << "," << result.p95Ms << "," << result.ticksPerSecond << "\n";
+    }
+}
+
+/// @brief Read ms/tick of every run of results file written by writeResults()
+static std::map<std::string, double> readBaseline(const std::string &path)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        throw std::runtime_error("Can't read baseline " + path);
+    }
+    std::map<std::string, double> baseline;
+    std::string line;
+    std::getline(in, line);
+    if (line != csvHeader)
+    {
+        throw std::runtime_error("Baseline " + path + " is not a scenario_bench results file");
+    }
+    while (std::getline(in, line))
+    {
+        const auto fields = splitList(line);
+        if (fields.size() < 7)
+        {
+            continue;
+        }
+        RunResult result;
+        result.scenario = fields[0];
+        result.objects = std::stoi(fields[1]);
+        result.threads = std::stoi(fields[2]);
+        baseline[result.key()] = std::stod(fields[6]);
+    }
+    return baseline;
+}
+
+int main(int argc, char **argv)
+{
+    ScenarioOptions options;
+    std::map<std::string, double> baseline;
+    try
+    {
+        options = parseOptions(argc, argv);
+        if (!options.baselinePath.empty())
+        {
+            baseline = readBaseline(options.baselinePath);
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+
+    const auto allScenarios = makeScenarios();
+    std::vector<const Scenario *> scenarios;
+    for (const auto &name : options.scenarios)
+    {
+        auto it = std::find_if(allScenarios.begin(), allScenarios.end(), [&](const Scenario &s) { return s.name == name; });
+        if (it == allScenarios.end())
+        {
+            std::cerr << "Unknown scenario " << name << "\n";
+            printUsage();
+            return 1;
+        }
+        scenarios.push_back(&*it);
+    }
+
+#ifndef NDEBUG
+    std::cout << "WARNING: debug build, configure with -DDEBUG=OFF for meaningful numbers\n";
+#endif
+    std::cout << std::left << std::setw(10) << "Scenario" << std::right << std::setw(9) << "Objects"
+              << std::setw(8) << "Threads" << std::setw(16) << "Objects (end)" << std::setw(7) << "Ticks"
+              << std::setw(11) << "ms/tick" << std::setw(10) << "p95 ms" << std::setw(12) << "Baseline" << "\n";
+
+    std::vector<RunResult> results;
+    int regressions = 0;
+    bool failed = false;
+    for (const Scenario *scenario : scenarios)
+    {
+        for (int objects : options.objects)
+        {
+            for (int threads : options.threads)
+            {
+                RunResult result;
+                try
+                {
+                    result = runScenario(*scenario, objects, threads, options);
+                }
+                catch (const std::exception &e)
+                {
+                    // Results of other runs are still written
+                    std::cerr << scenario->name << " with " << objects << " objects failed: " << e.what() << "\n";
+                    failed = true;
+                    continue;
+                }
+                results.push_back(result);
+
+                std::cout << std::left << std::setw(10) << result.scenario << std::right << std::setw(9) << result.objects
+                          << std::setw(8) << result.threads << std::setw(16) << result.objectsEnd
+                          << std::setw(7) << result.ticks << std::fixed << std::setprecision(2)
+                          << std::setw(11) << result.msPerTick << std::setw(10) << result.p95Ms;
+                if (auto it = baseline.find(result.key()); it != baseline.end() && it->second > 0.0)
+                {
+                    const double change = result.msPerTick / it->second - 1.0;
+                    std::cout << std::setw(11) << std::showpos << std::setprecision(1) << change * 100.0 << "%" << std::noshowpos;
+                    if (change > options.threshold)
+                    {
+                        std::cout << "  REGRESSION";
+                        regressions++;
+                    }
+                }
+                std::cout << "\n";
+                if (!options.telemetryPath.empty())
+                {
+                    std::cout << "  telemetry: " << std::setprecision(3) << result.telemetryMs << " ms/sample, "
+                              << std::setprecision(1) << result.telemetryBytes / 1024.0 << " KB written\n";
+                }
+                if (options.mergeFood || options.foodCap > 0)
+                {
+                    std::cout << "  food merged: " << result.foodMerged << " overlapping, " << result.foodCapped
+                              << " into full cells\n";
+                }
+            }
+        }
+    }
+
+    try
+    {
+        writeResults(options.outPath, results);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+    std::cout << "Results written to " << options.outPath << "\n";
+
+    if (failed)
+    {
+        return 1;
+    }
+    if (regressions > 0)
+    {
+        std::cout << regressions << " runs are slower than baseline by more than "
+                  << std::setprecision(0) << options.threshold * 100.0 << "%\n";
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,400 @@
+/*
+ * Throughput of world snapshots (see WorldSnapshot) and world images (see WorldImage).
+ *
+ * Builds world with given number of objects (bots of two populations, trees
+ * and food), runs a few ticks, saves it to snapshot and image, loads both back
+ * and saves loaded worlds to snapshots again. They must be identical to the first one,
+ * otherwise some state is lost by save/load and program exits with code 1.
+ *
+ * With --checkpoints N world then runs with DeltaCheckpointer and every checkpoint
+ * restored from disk is compared with snapshot taken at the same tick.
+ *
+ * With --replay N world runs N ticks with ActionRecorder, then ActionReplay replays the log
+ * to its end and back to its middle. Objects of replayed world are compared with the live one
+ * (brains are not: replay does not call them).
+ *
+ * Usage: snapshot_bench [--objects N] [--bots-share X] [--ticks N] [--seed N]
+ *                       [--path PATH] [--threads N] [--keep 0|1]
+ *                       [--checkpoints N] [--checkpoint-every N] [--full-every N]
+ *                       [--replay N]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+#include "simulation.h"
+#include "objects/Food.h"
+#include "objects/Tree.h"
+#include "settings/SimulationSettings.h"
+#include "protocols/brain/BrainsRegistry.h"
+#include "snapshot/WorldSnapshot.h"
+#include "snapshot/WorldImage.h"
+#include "snapshot/DeltaCheckpointer.h"
+#include "snapshot/ActionLog.h"
+#include "brains/tunable/TunableBrain.h"
+#include "brains/neural/NeuralBrain.h"
+
+struct SnapshotBenchOptions
+{
+    int objects = 1000000;
+    /// @brief Share of bots among objects, the rest is 1/10 trees and food
+    double botsShare = 0.05;
+    /// @brief Ticks run before saving, so bots have intents and brains have state
+    int ticks = 1;
+    unsigned int seed = 1;
+    /// @brief Snapshot is written to this path, image to the same path with ".image" suffix
+    std::string path = "snapshot_bench.bin";
+    /// @brief Workers that build objects of image, 0 for number of hardware threads
+    size_t threads = 0;
+    bool keep = false;
+    /// @brief Number of checkpoints to take and verify after snapshot tests, 0 to skip
+    int checkpoints = 0;
+    int checkpointEvery = 50;
+    int fullEvery = 4;
+    /// @brief Number of ticks to record and replay, 0 to skip
+    int replay = 0;
+};
+
+static void printUsage()
+{
+    std::cout << "Usage: snapshot_bench [--objects N] [--bots-share X] [--ticks N] [--seed N]\n"
+                 "                      [--path PATH] [--threads N] [--keep 0|1]\n"
+                 "                      [--checkpoints N] [--checkpoint-every N] [--full-every N]\n"
+                 "                      [--replay N]\n";
+}
+
+static SnapshotBenchOptions parseOptions(int argc, char **argv)
+{
+    SnapshotBenchOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc)
+        {
+            throw std::invalid_argument("Missing value of option " + arg);
+        }
+        const std::string value = argv[++i];
+
+        if (arg == "--objects") options.objects = std::stoi(value);
+        else if (arg == "--bots-share") options.botsShare = std::stod(value);
+        else if (arg == "--ticks") options.ticks = std::stoi(value);
+        else if (arg == "--seed") options.seed = static_cast<unsigned int>(std::stoul(value));
+        else if (arg == "--path") options.path = value;
+        else if (arg == "--threads") options.threads = std::stoul(value);
+        else if (arg == "--keep") options.keep = std::stoi(value) != 0;
+        else if (arg == "--checkpoints") options.checkpoints = std::stoi(value);
+        else if (arg == "--checkpoint-every") options.checkpointEvery = std::stoi(value);
+        else if (arg == "--full-every") options.fullEvery = std::stoi(value);
+        else if (arg == "--replay") options.replay = std::stoi(value);
+        else throw std::invalid_argument("Unknown option " + arg);
+    }
+
+    if (options.objects < 10 || options.botsShare < 0.0 || options.botsShare > 1.0 || options.ticks < 0 ||
+        options.checkpoints < 0 || options.checkpointEvery < 1 || options.fullEvery < 1 ||
+        options.replay < 0)
+    {
+        throw std::invalid_argument("Snapshot bench options are invalid!");
+    }
+    return options;
+}
+
+static std::shared_ptr<Simulation> buildWorld(const SnapshotBenchOptions &options)
+{
+    // About 16 objects per chunk
+    const int side = std::max(4, int(std::ceil(std::sqrt(options.objects / 16.0))));
+    const int bots = int(options.objects * options.botsShare);
+    const int trees = (options.objects - bots) / 10;
+    const int food = options.objects - bots - trees;
+
+    auto settings = std::make_shared<SimulationSettings>();
+    settings->simulationSizeSettings.numberOfChunksX = side;
+    settings->simulationSizeSettings.numberOfChunksY = side;
+    settings->mapGenerationSettings.spawnType = SpawnType::Random;
+    settings->mapGenerationSettings.numberOfBotsPerPopulation = std::max(1, bots / 2);
+
+    settings->seed = options.seed;
+    auto simulation = std::make_shared<Simulation>(settings);
+    std::mt19937 gen(options.seed);
+    std::uniform_real_distribution<float> x(0.0f, simulation->chunkManager->mapWidth - 1.0f);
+    std::uniform_real_distribution<float> y(0.0f, simulation->chunkManager->mapHeight - 1.0f);
+
+    for (int i = 0; i < trees; i++)
+    {
+        simulation->addObject(SimulationObjectType::TreeObject,
+                              std::make_shared<TreeObject>(simulation, Vec2<float>(x(gen), y(gen)), 3 + i % 3,
+                                                           150.0f, 0.5f, 1.5f, 600.0f, false));
+    }
+    for (int i = 0; i < food; i++)
+    {
+        simulation->addObject(SimulationObjectType::FoodObject,
+                              std::make_shared<FoodObject>(simulation, Vec2<float>(x(gen), y(gen)), colorInt(100, 0, 0),
+                                                           50.0f, 50.0f, 0.5f, 0.0f, i % 2 == 0));
+    }
+    if (bots > 0)
+    {
+        simulation->spawnPopulation([]() { return std::make_shared<TunableBrain>(); });
+        simulation->spawnPopulation([]() { return std::make_shared<NeuralBrain>(); });
+    }
+    return simulation;
+}
+
+static void printStats(const char *name, const WorldSnapshot::Stats &stats)
+{
+    const double megabytes = stats.bytes / (1024.0 * 1024.0);
+    std::cout << std::left << std::setw(12) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(9) << stats.seconds << " s" << std::setprecision(1)
+              << std::setw(10) << megabytes / stats.seconds << " MB/s"
+              << std::setprecision(2) << std::setw(10) << stats.objects / stats.seconds / 1e6 << " M objects/s\n";
+}
+
+static std::string snapshotBytes(const Simulation &simulation)
+{
+    std::ostringstream out;
+    WorldSnapshot::save(simulation, out);
+    return std::move(out).str();
+}
+
+/// @brief Run world with checkpoints and compare every restored checkpoint with snapshot of the same tick
+static bool runCheckpoints(const SnapshotBenchOptions &options, const BrainsRegistry &registry)
+{
+    DeltaCheckpointer::Options checkpointOptions;
+    checkpointOptions.directory = options.path + ".checkpoints";
+    checkpointOptions.interval = options.checkpointEvery;
+    checkpointOptions.fullEvery = options.fullEvery;
+
+    auto simulation = buildWorld(options);
+    // Snapshot of the same tick for every checkpoint
+    std::vector<std::string> expected;
+    double tickSeconds = 0.0;
+    {
+        DeltaCheckpointer checkpointer(simulation, checkpointOptions);
+        expected.push_back(snapshotBytes(*simulation));
+        while (checkpointer.getLastSequence() < options.checkpoints)
+        {
+            const auto tickStart = std::chrono::steady_clock::now();
+            simulation->update(true);
+            simulation->afterUpdate();
+            tickSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - tickStart).count();
+            if (checkpointer.afterTick())
+            {
+                expected.push_back(snapshotBytes(*simulation));
+            }
+        }
+        checkpointer.flush();
+
+        const auto &stats = checkpointer.getStats();
+        std::cout << "Checkpoints: " << stats.fullCheckpoints << " full, " << stats.deltaCheckpoints << " deltas every "
+                  << options.checkpointEvery << " ticks\n"
+                  << std::setprecision(1) << "  full " << stats.fullBytes / std::max(1, stats.fullCheckpoints) / 1024.0
+                  << " KB, delta " << stats.deltaBytes / std::max(1, stats.deltaCheckpoints) / 1024.0 << " KB on average, "
+                  << stats.deltaObjects / std::max(1, stats.deltaCheckpoints) << " objects per delta\n"
+                  << std::setprecision(3) << "  simulation thread: " << stats.serializeSeconds << " s serialising, "
+                  << stats.waitSeconds << " s waiting for writer, " << tickSeconds << " s ticking\n";
+    }
+
+    bool identical = true;
+    for (int sequence = 0; sequence <= options.checkpoints; sequence++)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        auto restored = DeltaCheckpointer::restore(checkpointOptions.directory, sequence, registry);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const bool same = snapshotBytes(*restored) == expected[sequence];
+        identical = identical && same;
+        std::cout << "  restore " << sequence << ": " << std::setprecision(3) << seconds << " s, "
+                  << (same ? "identical" : "DIFFERENT") << "\n";
+    }
+
+    if (!options.keep)
+    {
+        std::filesystem::remove_all(checkpointOptions.directory);
+    }
+    return identical;
+}
+
+/// @brief Id and state of every object without brains of bots
+static std::string objectStates(Simulation &simulation)
+{
+    std::ostringstream out;
+    BinaryWriter writer(&out);
+    const auto objects = simulation.getObjects();
+    for (const auto &object : *objects)
+    {
+        writer.write<uint8_t>(uint8_t(object->type()));
+        writer.write<uint64_t>(object->id.get());
+        object->saveState(writer);
+        writer.flushIfFull();
+    }
+    writer.flush();
+    return std::move(out).str();
+}
+
+/// @brief Record ticks of world to action log, replay it and compare replayed world with the live one
+static bool runReplay(const SnapshotBenchOptions &options, const BrainsRegistry &registry)
+{
+    const std::string logPath = options.path + ".actions";
+    const int middle = options.replay / 2;
+    std::string expectedMiddle;
+    std::string expectedEnd;
+    double liveSeconds = 0.0;
+    {
+        auto simulation = buildWorld(options);
+        ActionRecorder recorder(simulation, logPath);
+        if (middle == 0)
+        {
+            expectedMiddle = objectStates(*simulation);
+        }
+        for (int tick = 1; tick <= options.replay; tick++)
+        {
+            const auto tickStart = std::chrono::steady_clock::now();
+            simulation->update(true);
+            simulation->afterUpdate();
+            liveSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - tickStart).count();
+            if (tick == middle)
+            {
+                expectedMiddle = objectStates(*simulation);
+            }
+        }
+        expectedEnd = objectStates(*simulation);
+        recorder.flush();
+
+        const auto &stats = recorder.getStats();
+        std::cout << "Action log: " << stats.ticks << " ticks, " << std::setprecision(1)
+                  << (stats.bytes - stats.snapshotBytes) / double(std::max(1ul, stats.ticks)) / 1024.0 << " KB per tick ("
+                  << stats.actions << " actions, " << stats.intents << " intents, " << stats.births << " births) after "
+                  << stats.snapshotBytes / (1024.0 * 1024.0) << " MB snapshot\n";
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    ActionReplay replay(logPath, registry);
+    const double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const unsigned long endTick = replay.seek(replay.getLastTick());
+    const double replaySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() - loadSeconds;
+    const bool sameEnd = objectStates(*replay.getSimulation()) == expectedEnd;
+
+    // Seeking back starts from the beginning of log again
+    replay.seek(replay.getStartTick() + middle);
+    const bool sameMiddle = objectStates(*replay.getSimulation()) == expectedMiddle;
+
+    std::cout << std::setprecision(3) << "  live " << liveSeconds << " s, replay " << replaySeconds << " s ("
+              << std::setprecision(1) << liveSeconds / std::max(1e-9, replaySeconds) << "x) after "
+              << std::setprecision(3) << loadSeconds << " s load\n"
+              << "  tick " << endTick << ": " << (sameEnd ? "identical" : "DIFFERENT")
+              << ", tick " << replay.getTick() << ": " << (sameMiddle ? "identical" : "DIFFERENT") << "\n";
+
+    if (!options.keep)
+    {
+        std::remove(logPath.c_str());
+    }
+    return sameEnd && sameMiddle;
+}
+
+int main(int argc, char **argv)
+{
+    SnapshotBenchOptions options;
+    try
+    {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+#ifndef NDEBUG
+    std::cout << "Warning: debug build, numbers are not representative. Configure with -DDEBUG=OFF\n";
+#endif
+
+    BrainsRegistry registry;
+    registry.registerBot("TunableLegion", [](BrainContext &) { return std::make_shared<TunableBrain>(); });
+    registry.registerBot("NeuralSwarm", [](BrainContext &) { return std::make_shared<NeuralBrain>(); });
+
+    try
+    {
+        const auto buildStart = std::chrono::steady_clock::now();
+        auto simulation = buildWorld(options);
+        for (int tick = 0; tick < options.ticks; tick++)
+        {
+            simulation->update(true);
+            simulation->afterUpdate();
+        }
+        std::cout << "World: " << simulation->getNumberOfObjects() << " objects on "
+                  << simulation->chunkManager->numberOfChunksX << "x" << simulation->chunkManager->numberOfChunksY
+                  << " chunks, built in " << std::fixed << std::setprecision(2)
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now() - buildStart).count() << " s\n";
+
+        const std::string imagePath = options.path + ".image";
+        const auto saved = WorldSnapshot::save(*simulation, options.path);
+        std::cout << "Snapshot: " << std::setprecision(1) << saved.bytes / (1024.0 * 1024.0) << " MB, "
+                  << double(saved.bytes) / std::max<size_t>(1, saved.objects) << " bytes per object\n";
+        const auto imageWritten = WorldImage::write(*simulation, imagePath);
+        std::cout << "Image: " << std::setprecision(1) << imageWritten.bytes / (1024.0 * 1024.0) << " MB, "
+                  << double(imageWritten.bytes) / std::max<size_t>(1, imageWritten.objects) << " bytes per object\n";
+        printStats("Save", saved);
+        printStats("Image write", imageWritten);
+        simulation.reset();
+
+        std::ifstream file(options.path, std::ios::binary);
+        std::stringstream original;
+        original << file.rdbuf();
+
+        // Loaded worlds must give exactly the same snapshot
+        auto checkRoundTrip = [&](const char *name, const std::shared_ptr<Simulation> &loaded)
+        {
+            std::stringstream resaved;
+            WorldSnapshot::save(*loaded, resaved);
+            const bool identical = original.str() == resaved.str();
+            std::cout << "Round trip of " << name << ": " << (identical ? "identical" : "DIFFERENT") << "\n";
+            return identical;
+        };
+
+        WorldSnapshot::Stats loadedStats;
+        auto loaded = WorldSnapshot::load(options.path, registry, &loadedStats);
+        printStats("Load", loadedStats);
+        bool identical = checkRoundTrip("snapshot", loaded);
+        loaded.reset();
+
+        WorldImage::Stats imageStats;
+        loaded = WorldImage::load(imagePath, registry, options.threads, &imageStats);
+        printStats("Image load", imageStats);
+        identical = checkRoundTrip("image", loaded) && identical;
+
+        loaded.reset();
+        if (!options.keep)
+        {
+            std::remove(options.path.c_str());
+            std::remove(imagePath.c_str());
+        }
+
+        if (options.checkpoints > 0)
+        {
+            identical = runCheckpoints(options, registry) && identical;
+        }
+        if (options.replay > 0)
+        {
+            identical = runReplay(options, registry) && identical;
+        }
+        return identical ? 0 : 1;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        return 1;
+    }
+}
@@ -0,0 +1,224 @@
+/*
+ * Startup time of world generation on large maps.
+ *
+ * For every map size (in chunks along each side) builds empty simulation and measures:
+ *  - noise of the whole map computed cell by cell with PerlinNoise2D::getValue(), as tree generation did before,
+ *  - the same noise field made by NoiseField::generate() with one thread and with --threads threads.
+ *    Every value must be bitwise equal to the scalar one, otherwise program exits with code 1,
+ *  - Simulation::generateTree() on a fresh world (noise field, places of trees and bulk insertion),
+ *  - insertion of the same trees at once with Simulation::addObjects() and one by one with Simulation::addObject().
+ *
+ * Usage: startup_bench [--chunks N,N,...] [--threads N] [--seed N]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include "simulation.h"
+#include "objects/Tree.h"
+#include "settings/SimulationSettings.h"
+#include "utilities/NoiseField.h"
+#include "utilities/PerlinNoise2D.h"
+#include "utilities/ThreadPool.h"
+
+struct StartupBenchOptions
+{
+    /// @brief Sizes of map, in chunks along each side
+    std::vector<int> chunks = {100, 300};
+    /// @brief Threads of parallel noise field, 0 for number of hardware threads
+    size_t threads = 0;
+    unsigned int seed = 1;
+};
+
+static void printUsage()
+{
+    std::cout << "Usage: startup_bench [--chunks N,N,...] [--threads N] [--seed N]\n";
+}
+
+static StartupBenchOptions parseOptions(int argc, char **argv)
+{
+    StartupBenchOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc)
+        {
+            throw std::invalid_argument("Missing value of option " + arg);
+        }
+        const std::string value = argv[++i];
+
+        if (arg == "--chunks")
+        {
+            options.chunks.clear();
+            std::stringstream stream(value);
+            std::string item;
+            while (std::getline(stream, item, ','))
+            {
+                options.chunks.push_back(std::stoi(item));
+            }
+        }
+        else if (arg == "--threads") options.threads = std::stoul(value);
+        else if (arg == "--seed") options.seed = static_cast<unsigned int>(std::stoul(value));
+        else throw std::invalid_argument("Unknown option " + arg);
+    }
+
+    if (options.chunks.empty())
+    {
+        throw std::invalid_argument("Startup bench options are invalid!");
+    }
+    for (int side : options.chunks)
+    {
+        if (side < 1)
+        {
+            throw std::invalid_argument("Startup bench options are invalid!");
+        }
+    }
+    return options;
+}
+
+static std::shared_ptr<Simulation> buildEmptyWorld(int side, unsigned int seed)
+{
+    auto settings = std::make_shared<SimulationSettings>();
+    settings->simulationSizeSettings.numberOfChunksX = side;
+    settings->simulationSizeSettings.numberOfChunksY = side;
+    settings->seed = seed;
+    return std::make_shared<Simulation>(settings);
+}
+
+template <typename F>
+static double measureMs(F &&function)
+{
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    StartupBenchOptions options;
+    try
+    {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+#ifndef NDEBUG
+    std::cout << "Warning: debug build, numbers are not representative. Configure with -DDEBUG=OFF\n";
+#endif
+
+    ThreadPool pool(options.threads);
+    std::cout << std::left << std::setw(14) << "Map" << std::right << std::setw(12) << "Cells"
+              << std::setw(12) << "Scalar ms" << std::setw(12) << "Field1 ms" << std::setw(12) << "FieldN ms"
+              << std::setw(10) << "Speedup" << std::setw(10) << "Trees" << std::setw(14) << "Generate ms"
+              << std::setw(10) << "Bulk ms" << std::setw(14) << "OneByOne ms" << "\n";
+
+    bool identical = true;
+    try
+    {
+        for (int side : options.chunks)
+        {
+            auto world = buildEmptyWorld(side, options.seed);
+            const auto &mapSettings = world->settings->mapGenerationSettings;
+            const int width = side * world->settings->simulationSizeSettings.unitsPerChunk;
+            const int height = width;
+            const PerlinNoise2D noise(world->getRandom().stream(RandomService::TreeGeneration, 0));
+
+            // Noise as generateTree() computed it before NoiseField
+            std::vector<float> scalar(size_t(width) * height);
+            const double scalarMs = measureMs([&]()
+            {
+                for (int y = 0; y < height; y++)
+                {
+                    for (int x = 0; x < width; x++)
+                    {
+                        const float value = noise.getValue(x * mapSettings.positiveScale, y * mapSettings.positiveScale) -
+                                            noise.getValue(x * mapSettings.negativeScale, y * mapSettings.negativeScale);
+                        scalar[size_t(y) * width + x] = std::clamp(value, 0.0f, 1.0f);
+                    }
+                }
+            });
+
+            NoiseField single;
+            const double singleMs = measureMs([&]()
+            {
+                single = NoiseField::generate(noise, width, height, mapSettings.positiveScale, mapSettings.negativeScale, 1);
+            });
+            NoiseField parallel;
+            const double parallelMs = measureMs([&]()
+            {
+                parallel = NoiseField::generate(noise, width, height, mapSettings.positiveScale, mapSettings.negativeScale, pool);
+            });
+            for (int y = 0; y < height && identical; y++)
+            {
+                identical = std::memcmp(single.row(y), scalar.data() + size_t(y) * width, width * sizeof(float)) == 0 &&
+                            std::memcmp(parallel.row(y), scalar.data() + size_t(y) * width, width * sizeof(float)) == 0;
+            }
+            scalar = {};
+            single = {};
+            parallel = {};
+
+            const double generateMs = measureMs([&]() { world->generateTree(); });
+
+            // The same trees added to other worlds at once and by the old path, object by object
+            std::vector<std::shared_ptr<SimulationObject>> bulkCopies;
+            std::vector<std::shared_ptr<TreeObject>> copies;
+            bulkCopies.reserve(world->getNumberOfObjects());
+            copies.reserve(world->getNumberOfObjects());
+            const auto trees = world->getObjects();
+            for (const auto &object : *trees)
+            {
+                const auto tree = std::static_pointer_cast<TreeObject>(object);
+                bulkCopies.push_back(std::make_shared<TreeObject>(*tree));
+                copies.push_back(std::make_shared<TreeObject>(*tree));
+            }
+            auto bulkWorld = buildEmptyWorld(side, options.seed);
+            const double bulkMs = measureMs([&]() { bulkWorld->addObjects(bulkCopies); });
+            auto other = buildEmptyWorld(side, options.seed);
+            const double oneByOneMs = measureMs([&]()
+            {
+                for (const auto &tree : copies)
+                {
+                    other->addObject(SimulationObjectType::TreeObject, tree);
+                }
+            });
+
+            std::cout << std::left << std::setw(14) << (std::to_string(width) + "x" + std::to_string(height))
+                      << std::right << std::setw(12) << size_t(width) * height << std::fixed << std::setprecision(1)
+                      << std::setw(12) << scalarMs << std::setw(12) << singleMs << std::setw(12) << parallelMs
+                      << std::setw(9) << scalarMs / std::max(parallelMs, 1e-3) << "x"
+                      << std::setw(10) << world->getNumberOfObjects() << std::setw(14) << generateMs
+                      << std::setw(10) << bulkMs << std::setw(14) << oneByOneMs << "\n";
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Startup bench failed: " << e.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "Threads: " << pool.size() << "\n";
+    if (!identical)
+    {
+        std::cerr << "Noise field differs from PerlinNoise2D::getValue()!\n";
+        return 1;
+    }
+    std::cout << "Noise field is identical to PerlinNoise2D::getValue()\n";
+    return 0;
+}
@@ -0,0 +1,302 @@
+/*
+ * Headless evolutionary tuner of TunableBrain parameters.
+ *
+ * Every candidate set of parameters is evaluated by running its own
+ * Simulation without GUI for a fixed number of ticks. Simulations are
+ * independent, so all evaluations of one generation run in parallel on
+ * a thread pool. Score of candidate is average size of its population
+ * during the run relative to starting size, so it rewards both survival
+ * and multiplication. World of every evaluation is seeded from --seed,
+ * generation and index of evaluation, so the same --seed gives the same
+ * results.
+ *
+ * Usage: tuner [--generations N] [--population N] [--elites N] [--ticks N]
+ *              [--repeats N] [--threads N] [--bots N] [--max-bots N]
+ *              [--chunks N] [--sigma X] [--seed N]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <array>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "simulation.h"
+#include "settings/SimulationSettings.h"
+#include "utilities/ThreadPool.h"
+#include "brains/tunable/TunableBrain.h"
+
+using Genome = std::array<float, TunableBrain::Parameters::count>;
+
+struct TunerOptions
+{
+    int generations = 20;
+    int populationSize = 32;
+    int elites = 8;
+    int ticks = 2000;
+    /// @brief Number of simulations per candidate. Score is averaged over them
+    int repeats = 2;
+    /// @brief 0 means number of hardware threads
+    int threads = 0;
+    int botsPerPopulation = 40;
+    /// @brief Stop simulation early when population reach this size
+    int maxBots = 1500;
+    int chunks = 12;
+    float mutationSigma = 0.15f;
+    unsigned int seed = 1;
+};
+
+struct Candidate
+{
+    Genome genome;
+    double score = 0.0;
+};
+
+static void printUsage()
+{
+    std::cout << "Usage: tuner [--generations N] [--population N] [--elites N] [--ticks N]\n"
+                 "             [--repeats N] [--threads N] [--bots N] [--max-bots N]\n"
+                 "             [--chunks N] [--sigma X] [--seed N]\n";
+}
+
+static TunerOptions parseOptions(int argc, char **argv)
+{
+    TunerOptions options;
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            std::exit(0);
+        }
+        if (i + 1 >= argc)
+        {
+            throw std::invalid_argument("Missing value of option " + arg);
+        }
+        const std::string value = argv[++i];
+
+        if (arg == "--generations") options.generations = std::stoi(value);
+        else if (arg == "--population") options.populationSize = std::stoi(value);
+        else if (arg == "--elites") options.elites = std::stoi(value);
+        else if (arg == "--ticks") options.ticks = std::stoi(value);
+        else if (arg == "--repeats") options.repeats = std::stoi(value);
+        else if (arg == "--threads") options.threads = std::stoi(value);
+        else if (arg == "--bots") options.botsPerPopulation = std::stoi(value);
+        else if (arg == "--max-bots") options.maxBots = std::stoi(value);
+        else if (arg == "--chunks") options.chunks = std::stoi(value);
+        else if (arg == "--sigma") options.mutationSigma = std::stof(value);
+        else if (arg == "--seed") options.seed = static_cast<unsigned int>(std::stoul(value));
+        else throw std::invalid_argument("Unknown option " + arg);
+    }
+
+    if (options.generations < 1 || options.populationSize < 2 || options.ticks < 1 || options.repeats < 1 ||
+        options.botsPerPopulation < 1 || options.maxBots < 1 || options.chunks < 1 || options.threads < 0)
+    {
+        throw std::invalid_argument("Tuner options must be positive!");
+    }
+    options.elites = std::clamp(options.elites, 1, options.populationSize);
+    return options;
+}
+
+static std::shared_ptr<const SimulationSettings> makeSettings(const TunerOptions &options)
+{
+    auto settings = std::make_shared<SimulationSettings>();
+
+    settings->simulationSizeSettings.unit = 50;
+    settings->simulationSizeSettings.numberOfChunksX = options.chunks;
+    settings->simulationSizeSettings.numberOfChunksY = options.chunks;
+
+    settings->mapGenerationSettings.spawnType = SpawnType::Random;
+    settings->mapGenerationSettings.numberOfBotsPerPopulation = options.botsPerPopulation;
+    settings->mapGenerationSettings.treeRarety = 0;
+    settings->mapGenerationSettings.randomSpawnFood = true;
+    settings->mapGenerationSettings.foodPerChunk = 3.0f;
+    settings->mapGenerationSettings.foodSpawnChance = 0.005f;
+
+    return settings;
+}
+
+/// @brief Seed of world of one evaluation, so the same --seed gives the same worlds and results
+/// @param evaluation Index of evaluation in generation (candidate * repeats + repeat)
+static uint64_t worldSeed(const TunerOptions &options, int generation, size_t evaluation)
+{
+    // SplitMix64 finalizer spreads neighbour indices over all bits
+    uint64_t value = uint64_t(options.seed) << 32 ^ uint64_t(generation) << 20 ^ uint64_t(evaluation);
+    value = (value ^ value >> 30) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ value >> 27) * 0x94D049BB133111EBull;
+    value ^= value >> 31;
+    // Seed 0 takes random seed from std::random_device
+    return value != 0 ? value : 1;
+}
+
+/// @brief Run one headless simulation with given parameters
+/// @return Average population size during simulation relative to starting size
+static double evaluate(const Genome &genome, const std::shared_ptr<const SimulationSettings> &settings, uint64_t seed,
+                       const TunerOptions &options)
+{
+    constexpr int sampleEvery = 10;
+
+    auto parameters = std::make_shared<const TunableBrain::Parameters>(TunableBrain::Parameters::fromGenome(genome));
+
+    auto worldSettings = std::make_shared<SimulationSettings>(*settings);
+    worldSettings->seed = seed;
+    auto simulation = std::make_shared<Simulation>(worldSettings);
+    simulation->generateTree();
+    simulation->spawnPopulation([&parameters]() { return std::make_shared<TunableBrain>(parameters); });
+
+    const int samples = (options.ticks + sampleEvery - 1) / sampleEvery;
+    double populationSum = 0.0;
+    for (int tick = 0; tick < options.ticks; tick++)
+    {
+        simulation->update(true);
+        simulation->afterUpdate();
+
+        if (tick % sampleEvery != 0)
+        {
+            continue;
+        }
+        const auto sizes = simulation->getPopulationSizes();
+        const auto it = sizes.find("TunableLegion");
+        const int population = it == sizes.end() ? 0 : it->second;
+
+        if (population == 0)
+        {
+            // Extinct, rest of samples are zeros
+            break;
+        }
+        if (population >= options.maxBots)
+        {
+            // Count population as capped for the rest of the run instead of simulating it
+            const int remainingSamples = samples - tick / sampleEvery;
+            populationSum += double(options.maxBots) * remainingSamples;
+            break;
+        }
+        populationSum += population;
+    }
+
+    return populationSum / samples / options.botsPerPopulation;
+}
+
+static void printGenome(const Genome &genome)
+{
+    const auto parameters = TunableBrain::Parameters::fromGenome(genome);
+    const float values[TunableBrain::Parameters::count] = {
+        parameters.healthShare, parameters.foodShare, parameters.visionShare, parameters.speedShare,
+        parameters.attackShare, parameters.attackFoodThreshold, parameters.spawnFoodThreshold,
+        parameters.childExtraPoints, parameters.turnRate, parameters.wanderTicks};
+
+    const float sharesSum = values[0] + values[1] + values[2] + values[3] + values[4];
+    for (int i = 0; i < TunableBrain::Parameters::count; i++)
+    {
+        // Shares are printed normalized, as brain uses them
+        const float value = i < 5 && sharesSum > 0.0f ? values[i] / sharesSum : values[i];
+        std::cout << "  " << std::setw(20) << std::left << TunableBrain::Parameters::names[i]
+                  << std::fixed << std::setprecision(3) << value << "\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    TunerOptions options;
+    try
+    {
+        options = parseOptions(argc, argv);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << "\n";
+        printUsage();
+        return 1;
+    }
+
+    ThreadPool pool(options.threads);
+    const auto settings = makeSettings(options);
+    std::mt19937 gen(options.seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+
+    std::cout << "Tuning TunableBrain: " << options.populationSize << " candidates x " << options.repeats
+              << " runs x " << options.ticks << " ticks, " << pool.size() << " threads\n";
+
+    // First candidate is hand-written default, others are random
+    std::vector<Candidate> candidates(options.populationSize);
+    candidates[0].genome = TunableBrain::Parameters().toGenome();
+    for (size_t c = 1; c < candidates.size(); c++)
+    {
+        for (auto &gene : candidates[c].genome)
+        {
+            gene = uniform(gen);
+        }
+    }
+
+    Candidate best;
+    best.score = -1.0;
+    float sigma = options.mutationSigma;
+    const auto tuningStart = std::chrono::steady_clock::now();
+
+    for (int generation = 0; generation < options.generations; generation++)
+    {
+        const size_t evaluations = candidates.size() * options.repeats;
+        std::vector<double> scores(evaluations, 0.0);
+
+        const auto start = std::chrono::steady_clock::now();
+        pool.parallelFor(evaluations, [&](size_t i)
+                         { scores[i] = evaluate(candidates[i / options.repeats].genome, settings,
+                                                worldSeed(options, generation, i), options); });
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (size_t c = 0; c < candidates.size(); c++)
+        {
+            candidates[c].score = std::accumulate(scores.begin() + c * options.repeats,
+                                                  scores.begin() + (c + 1) * options.repeats, 0.0) /
+                                  options.repeats;
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Candidate &a, const Candidate &b) { return a.score > b.score; });
+        if (candidates.front().score > best.score)
+        {
+            best = candidates.front();
+        }
+
+        double meanScore = 0.0;
+        for (const auto &candidate : candidates)
+        {
+            meanScore += candidate.score;
+        }
+        meanScore /= candidates.size();
+
+        std::cout << "Generation " << std::setw(3) << generation
+                  << " | best: " << std::fixed << std::setprecision(3) << candidates.front().score
+                  << " | mean: " << meanScore
+                  << " | " << std::setprecision(1) << evaluations / seconds << " evals/s"
+                  << " | " << std::setprecision(0) << evaluations * double(options.ticks) / seconds << " ticks/s\n";
+
+        // Next generation: keep elites, fill the rest with mutated crossovers of elites
+        std::uniform_int_distribution<int> eliteIndex(0, options.elites - 1);
+        std::normal_distribution<float> mutation(0.0f, sigma);
+        for (size_t c = options.elites; c < candidates.size(); c++)
+        {
+            const Genome &first = candidates[eliteIndex(gen)].genome;
+            const Genome &second = candidates[eliteIndex(gen)].genome;
+            for (size_t g = 0; g < first.size(); g++)
+            {
+                const float gene = uniform(gen) < 0.5f ? first[g] : second[g];
+                candidates[c].genome[g] = std::clamp(gene + mutation(gen), 0.0f, 1.0f);
+            }
+        }
+        sigma = std::max(0.02f, sigma * 0.95f);
+    }
+
+    const double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - tuningStart).count();
+    std::cout << "Finished in " << std::setprecision(1) << totalSeconds << " s. Best score: "
+              << std::setprecision(3) << best.score << "\nBest parameters:\n";
+    printGenome(best.genome);
+
+    return 0;
+}